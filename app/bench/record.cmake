@@ -0,0 +1,42 @@
+################################################################################
+#
+#  record.cmake
+#
+#  Runs bench and stores aggregated results as bench/results/<commit>.json,
+#  see README for comparing two of them
+#
+################################################################################
+
+execute_process(
+COMMAND git rev-parse --short HEAD
+WORKING_DIRECTORY ${SOURCE_DIR}
+OUTPUT_VARIABLE COMMIT
+OUTPUT_STRIP_TRAILING_WHITESPACE
+ERROR_QUIET)
+if(NOT COMMIT)
+  set(COMMIT "unknown")
+endif()
+
+# Uncommitted changes don't overwrite results of their base commit
+execute_process(
+COMMAND git diff --quiet HEAD
+WORKING_DIRECTORY ${SOURCE_DIR}
+RESULT_VARIABLE DIRTY
+ERROR_QUIET)
+if(DIRTY)
+  set(COMMIT "${COMMIT}-dirty")
+endif()
+
+set(RESULTS_DIR "${SOURCE_DIR}/bench/results")
+file(MAKE_DIRECTORY ${RESULTS_DIR})
+execute_process(
+COMMAND ${BENCH}
+--benchmark_repetitions=5
+--benchmark_report_aggregates_only=true
+--benchmark_out=${RESULTS_DIR}/${COMMIT}.json
+--benchmark_out_format=json
+RESULT_VARIABLE RESULT)
+if(RESULT)
+  message(FATAL_ERROR "bench failed: ${RESULT}")
+endif()
+message(STATUS "bench results written to ${RESULTS_DIR}/${COMMIT}.json")
@@ -0,0 +1,399 @@
+////////////////////////////////////////////////////////////////////////////////
+//  AsyncHTTPRequest.hpp
+//
+//
+//  Bitfinex REST API C++ client - asynchronous requests on curl_multi
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// curl
+#include <curl/curl.h>
+
+// internal HTTPRequest
+#include "HTTPRequest.hpp"
+
+using std::vector;
+
+namespace BfxAPI {
+
+  // Runs many requests concurrently on a single thread. Requests are queued
+  // with get()/post() and driven by poll() or run() called from the owning
+  // thread. Completion callbacks and futures are fulfilled from within
+  // poll()/run(), so waiting on a future without driving the engine from
+  // another place blocks forever. HTTP/2 connections are multiplexed when
+  // the server supports it. With rate limiter set, requests over budget are
+  // held back and started by poll() once the budget allows.
+  class AsyncHTTPRequest {
+
+    public:
+
+      using Callback = std::function<void(HTTPResponse&)>;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Constructor / Destructor
+      ////////////////////////////////////////////////////////////////////////
+
+      AsyncHTTPRequest(string inEndpoint,
+                       const HTTPSettings &inSettings = HTTPSettings(),
+                       std::shared_ptr<ConnectionPool> inPool =
+                         ConnectionPool::shared()):
+      endpoint(inEndpoint),
+      settings(inSettings),
+      pool(inPool) {};
+
+      ~AsyncHTTPRequest() {
+        for (auto &transfer : transfers) {
+          curl_multi_remove_handle(multi, transfer.first);
+          curl_easy_cleanup(transfer.first);
+          curl_slist_free_all(transfer.second->header);
+        }
+        for (auto &request : deferred) {
+          curl_easy_cleanup(request.handle);
+          curl_slist_free_all(request.transfer->header);
+        }
+        for (auto handle : idleHandles)
+          curl_easy_cleanup(handle);
+        if (multi)
+          curl_multi_cleanup(multi);
+      };
+
+      AsyncHTTPRequest(const AsyncHTTPRequest&) = delete;
+      AsyncHTTPRequest& operator = (const AsyncHTTPRequest&) = delete;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Public methods
+      ////////////////////////////////////////////////////////////////////////
+
+      void get(const string &inPath,
+               const map<string, string> &params,
+               Callback callback) {
+        string query;
+        for (const auto &param : params)
+          query += param.first + "=" + param.second + "&";
+        submit(inPath, query, false, {}, {}, std::move(callback));
+      };
+
+      std::future<HTTPResponse> get(const string &inPath,
+                                    const map<string, string> &params = {}) {
+        auto promise = std::make_shared<std::promise<HTTPResponse>>();
+        auto future = promise->get_future();
+        get(inPath, params, [promise](HTTPResponse &response) {
+          promise->set_value(std::move(response));
+        });
+        return future;
+      };
+
+      // headers are complete "Name: value" lines, e.g. X-BFX-* headers.
+      // They aren't passed to transport set by setTransport().
+      void post(const string &inPath,
+                const vector<string> &headers,
+                Callback callback) {
+        submit(inPath, "", true, {}, headers, std::move(callback));
+      };
+
+      // Signed POST request: transport gets json payload and signs it
+      // itself, libcurl sends headers, see HTTPRequest::signedHeaderLines()
+      void post(const string &inPath,
+                const string &json,
+                const vector<string> &headers,
+                Callback callback) {
+        submit(inPath, "", true, json, headers, std::move(callback));
+      };
+
+      std::future<HTTPResponse> post(const string &inPath,
+                                     const vector<string> &headers) {
+        auto promise = std::make_shared<std::promise<HTTPResponse>>();
+        auto future = promise->get_future();
+        post(inPath, headers, [promise](HTTPResponse &response) {
+          promise->set_value(std::move(response));
+        });
+        return future;
+      };
+
+      // Performs pending transfers, waits at most timeoutMs for socket
+      // activity and dispatches completed requests. Returns number of
+      // requests still in flight.
+      size_t poll(int timeoutMs = 0) {
+        if (transport) {
+          performQueued();
+          return pending();
+        }
+        if (!multi)
+          return 0;
+
+        int running = 0;
+        startDeferred();
+        curl_multi_perform(multi, &running);
+        if (timeoutMs > 0 && !deferred.empty())
+          timeoutMs = std::min(timeoutMs, untilDeferredMs());
+        if (running && timeoutMs > 0) {
+          #if LIBCURL_VERSION_NUM >= 0x074200
+          curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+          #else
+          curl_multi_wait(multi, nullptr, 0, timeoutMs, nullptr);
+          #endif
+          curl_multi_perform(multi, &running);
+        } else if (!running && timeoutMs > 0 && !deferred.empty()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        }
+        dispatch();
+        return pending();
+      };
+
+      // Drives the engine until every queued request has completed,
+      // including requests queued from completion callbacks
+      void run() {
+        while (poll(100))
+          ;
+      };
+
+      size_t pending() const noexcept {
+        return transfers.size() + deferred.size() + queued.size();
+      }
+
+      // Requests wait for limiter budget before they are started, nullptr
+      // disables client side rate limiting
+      void setRateLimiter(std::shared_ptr<RateLimiter> inLimiter) noexcept {
+        limiter = std::move(inLimiter);
+      }
+
+      // Network timings of completed requests are recorded into metrics,
+      // nullptr disables recording
+      void setLatencyMetrics(std::shared_ptr<LatencyMetrics> inMetrics)
+      noexcept {
+        metrics = std::move(inMetrics);
+      }
+
+      // Requests are performed one by one by transport from poll() instead
+      // of concurrently by libcurl, nullptr restores libcurl. Must not be
+      // changed while requests are pending.
+      void setTransport(std::shared_ptr<Transport> inTransport) noexcept {
+        transport = std::move(inTransport);
+      }
+
+    private:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private properties
+      ////////////////////////////////////////////////////////////////////////
+
+      struct Transfer {
+        HTTPResponse response;
+        struct curl_slist *header = nullptr;
+        Callback callback;
+      };
+
+      // Request waiting for transport
+      struct Queued {
+        TransportRequest request;
+        std::unique_ptr<Transfer> transfer;
+      };
+
+      // Configured request waiting for rate limiter budget
+      struct Deferred {
+        RateLimiter::Clock::time_point ready;
+        CURL *handle;
+        std::unique_ptr<Transfer> transfer;
+      };
+
+      string endpoint;
+      HTTPSettings settings;
+      std::shared_ptr<ConnectionPool> pool;
+      std::shared_ptr<RateLimiter> limiter;
+      std::shared_ptr<LatencyMetrics> metrics;
+      std::shared_ptr<Transport> transport;
+      CURLM *multi = nullptr; // created by first libcurl request
+      std::unordered_map<CURL*, std::unique_ptr<Transfer>> transfers;
+      vector<Deferred> deferred;
+      vector<Queued> queued;
+      // Finished handles are kept so their connections stay warm
+      vector<CURL*> idleHandles;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private methods
+      ////////////////////////////////////////////////////////////////////////
+
+      CURLM* initMulti() {
+        if (!multi) {
+          multi = curl_multi_init();
+          if (multi) {
+            curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+            curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                              settings.maxHostConnections);
+          }
+        }
+        return multi;
+      };
+
+      CURL* acquireHandle() {
+        if (!idleHandles.empty()) {
+          CURL *handle = idleHandles.back();
+          idleHandles.pop_back();
+          return handle;
+        }
+        CURL *handle = curl_easy_init();
+        pool->setup(handle, settings);
+        if (handle)
+          curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+        return handle;
+      };
+
+      void submit(const string &inPath,
+                  const string &query,
+                  bool isPost,
+                  const string &json,
+                  const vector<string> &headers,
+                  Callback callback) {
+        std::unique_ptr<Transfer> transfer(new Transfer);
+        transfer->response.path = inPath;
+        transfer->callback = std::move(callback);
+
+        if (transport) {
+          Queued request;
+          request.request.method = isPost ? HTTPMethod::post : HTTPMethod::get;
+          request.request.path = inPath;
+          request.request.query = query;
+          request.request.payload = json;
+          request.transfer = std::move(transfer);
+          queued.push_back(std::move(request));
+          return;
+        }
+        const string url = isPost ? endpoint + inPath
+                                  : endpoint + inPath + "?" + query;
+
+        CURL *handle = initMulti() ? acquireHandle() : nullptr;
+        if (!handle) {
+          cerr << "curl not properly initialized in AsyncHTTPRequest" << endl;
+          transfer->response.curlStatusCode = CURLE_FAILED_INIT;
+          transfer->callback(transfer->response);
+          return;
+        }
+
+        for (const auto &line : headers)
+          transfer->header = curl_slist_append(transfer->header, line.c_str());
+
+        curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer->header);
+        if (isPost) {
+          curl_easy_setopt(handle, CURLOPT_POST, 1L);
+          curl_easy_setopt(handle, CURLOPT_POSTFIELDS, "\n");
+        } else {
+          curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+        }
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, &transfer->response.body);
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION,
+                         HTTPRequest::writeCallback);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, &transfer->response.body);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION,
+                         HTTPRequest::headerCallback);
+
+        RateLimiter::Clock::duration wait;
+        if (limiter && !limiter->tryAcquire(inPath, wait)) {
+          deferred.push_back({RateLimiter::Clock::now() + wait, handle,
+                              std::move(transfer)});
+          return;
+        }
+        start(handle, std::move(transfer));
+      };
+
+      void start(CURL *handle, std::unique_ptr<Transfer> transfer) {
+        curl_multi_add_handle(multi, handle);
+        transfers.emplace(handle, std::move(transfer));
+      };
+
+      // Starts deferred requests which got their budget, in queued order
+      void startDeferred() {
+        const auto now = RateLimiter::Clock::now();
+        size_t kept = 0;
+        for (auto &request : deferred) {
+          RateLimiter::Clock::duration wait;
+          if (request.ready <= now &&
+              limiter->tryAcquire(request.transfer->response.path, wait)) {
+            start(request.handle, std::move(request.transfer));
+            continue;
+          }
+          if (request.ready <= now)
+            request.ready = now + wait;
+          deferred[kept++] = std::move(request);
+        }
+        deferred.erase(deferred.begin() + kept, deferred.end());
+      };
+
+      int untilDeferredMs() const {
+        using namespace std::chrono;
+
+        auto ready = deferred.front().ready;
+        for (const auto &request : deferred)
+          ready = std::min(ready, request.ready);
+        const auto wait = duration_cast<milliseconds>(
+          ready - RateLimiter::Clock::now()).count();
+        return static_cast<int>(std::max<long long>(wait + 1, 1));
+      };
+
+      // Requests queued from callbacks are performed by the next poll()
+      void performQueued() {
+        vector<Queued> batch;
+        batch.swap(queued);
+        for (auto &request : batch) {
+          HTTPResponse &response = request.transfer->response;
+          transport->perform(request.request, response);
+          if (metrics && response.timings[LatencyPhase::total] > 0)
+            metrics->record(findEndpoint(response.path), response.timings);
+          request.transfer->callback(response);
+        }
+      };
+
+      void dispatch() {
+        int queued = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+          if (message->msg != CURLMSG_DONE)
+            continue;
+
+          CURL *handle = message->easy_handle;
+          auto it = transfers.find(handle);
+          if (it == transfers.end())
+            continue;
+
+          std::unique_ptr<Transfer> transfer(std::move(it->second));
+          transfers.erase(it);
+
+          transfer->response.curlStatusCode = message->data.result;
+          curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE,
+                            &transfer->response.httpStatusCode);
+          HTTPRequest::readTimings(handle, transfer->response.timings);
+          if (metrics)
+            metrics->record(findEndpoint(transfer->response.path),
+                            transfer->response.timings);
+          curl_multi_remove_handle(multi, handle);
+          curl_slist_free_all(transfer->header);
+          transfer->header = nullptr;
+          idleHandles.push_back(handle);
+
+          // libcurl internal error handling
+          if (transfer->response.curlStatusCode != CURLE_OK) {
+            cerr << "libcurl error in AsyncHTTPRequest:" << endl;
+            cerr << "CURLcode: " << transfer->response.curlStatusCode << endl;
+          }
+
+          transfer->callback(transfer->response);
+        }
+      };
+
+  };
+
+}
@@ -0,0 +1,485 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Awaitable.hpp
+//
+//
+//  Bitfinex REST API C++ client - C++20 coroutine interface over the
+//  asynchronous endpoints
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#if __cplusplus < 202002L || !__has_include(<coroutine>)
+#error "Awaitable.hpp requires C++20 coroutines, see BFX_BUILD_COROUTINES"
+#endif
+
+// std
+#include <atomic>
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// internal BitfinexAPI
+#include "BitfinexAPI.hpp"
+
+namespace BfxAPI
+{
+
+    // Resumes coroutine whose request completed, e.g. by posting the handle
+    // to thread pool. Empty executor resumes it inline from poll().
+    using Executor = std::function<void(std::coroutine_handle<>)>;
+
+    /// Lazily started coroutine returning T. Awaiting task starts it and
+    /// resumes awaiter when it finishes; spawn() starts it detached.
+    /// Exception escaping detached task terminates, like std::thread.
+    template <typename T = void>
+    class Task;
+
+    namespace detail
+    {
+        template <typename T>
+        struct TaskPromiseBase
+        {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr exception;
+            bool detached = false;
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            // Transfers to awaiter, detached frame destroys itself
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<Promise> handle) noexcept
+                {
+                    auto &promise = handle.promise();
+                    std::coroutine_handle<> next = promise.continuation;
+                    if (promise.detached)
+                        handle.destroy();
+                    return next ? next : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            FinalAwaiter final_suspend() noexcept { return {}; }
+
+            void unhandled_exception() noexcept
+            {
+                if (detached)
+                    std::terminate();
+                exception = std::current_exception();
+            }
+        };
+
+        template <typename T>
+        struct TaskPromise: TaskPromiseBase<T>
+        {
+            T value{};
+
+            Task<T> get_return_object() noexcept;
+
+            template <typename U>
+            void return_value(U &&result) { value = std::forward<U>(result); }
+
+            T take()
+            {
+                if (this->exception)
+                    std::rethrow_exception(this->exception);
+                return std::move(value);
+            }
+        };
+
+        template <>
+        struct TaskPromise<void>: TaskPromiseBase<void>
+        {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void take()
+            {
+                if (exception)
+                    std::rethrow_exception(exception);
+            }
+        };
+    }
+
+    template <typename T>
+    class Task
+    {
+
+    public:
+
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        explicit Task(Handle handle) noexcept: handle_(handle) {}
+
+        Task(Task &&other) noexcept: handle_(std::exchange(other.handle_, {}))
+        {}
+
+        Task& operator = (Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator = (const Task&) = delete;
+
+        ~Task() { reset(); }
+
+        bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<> awaiter) noexcept
+        {
+            handle_.promise().continuation = awaiter;
+            return handle_;
+        }
+
+        T await_resume() { return handle_.promise().take(); }
+
+        // Runs task until its first suspension without awaiting it, the
+        // frame is destroyed when it finishes
+        friend void spawn(Task task)
+        {
+            Handle handle = std::exchange(task.handle_, {});
+            handle.promise().detached = true;
+            handle.resume();
+        }
+
+    private:
+
+        Handle handle_;
+
+        void reset() noexcept
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = {};
+        }
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept
+        {
+            return Task<T>(Task<T>::Handle::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept
+        {
+            return Task<void>(Task<void>::Handle::from_promise(*this));
+        }
+    }
+
+    /// Coroutine interface of BitfinexAPI asynchronous endpoints:
+    ///
+    ///     Task<> flow(AwaitableAPI &api)
+    ///     {
+    ///         Result<Ticker> ticker = co_await api.getTickerAsync("btcusd");
+    ///         ...
+    ///     }
+    ///
+    /// Requests run concurrently on the curl_multi engine of api, driven by
+    /// poll() or run() of the thread owning api (the constructing thread).
+    /// Responses are validated and decoded before the coroutine resumes on
+    /// executor. Coroutines running on other threads may await requests:
+    /// these are handed over to the owning thread and sent by its next
+    /// poll(). api must outlive the instance and every pending request.
+    class AwaitableAPI
+    {
+
+    public:
+
+        /// Awaiter of single request, start(callback) sends it
+        template <typename T>
+        class Request
+        {
+
+        public:
+
+            using Start = std::function<void(BitfinexAPI::AsyncCallback)>;
+
+            Request(AwaitableAPI &owner, Start start):
+            owner_(owner),
+            start_(std::move(start))
+            {}
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                owner_.submit([this, handle]
+                {
+                    // Rejected request completes at once and may destroy
+                    // this awaiter together with the coroutine frame
+                    Start start = std::move(start_);
+                    start([this, handle](HTTPResponse &response)
+                    {
+                        static_cast<HTTPResponse&>(result_) =
+                            std::move(response);
+                        owner_.api_.decodeResponse(result_, result_.data);
+                        owner_.resume(handle);
+                    });
+                });
+            }
+
+            Result<T> await_resume() { return std::move(result_); }
+
+        private:
+
+            AwaitableAPI &owner_;
+            Start start_;
+            Result<T> result_;
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        explicit AwaitableAPI(BitfinexAPI &api, Executor executor = {}):
+        api_(api),
+        executor_(std::move(executor)),
+        owner_(std::this_thread::get_id())
+        {}
+
+        AwaitableAPI(const AwaitableAPI&) = delete;
+        AwaitableAPI& operator = (const AwaitableAPI&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Engine
+        ////////////////////////////////////////////////////////////////////////
+
+        // Sends requests awaited from other threads, then drives api's
+        // engine as BitfinexAPI::pollAsync(). Returns requests not completed.
+        size_t poll(int timeoutMs = 0)
+        {
+            startSubmitted();
+            api_.pollAsync(timeoutMs);
+            startSubmitted();
+            return pending_.load(std::memory_order_acquire);
+        }
+
+        // Polls until every awaited request has completed
+        void run()
+        {
+            while (poll(100))
+                ;
+        }
+
+        // Requests awaited and not completed yet
+        size_t pending() const noexcept { return pending_; }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Public endpoints
+        ////////////////////////////////////////////////////////////////////////
+
+        Request<Ticker> getTickerAsync(const string &symbol)
+        {
+            return {*this, [this, symbol](BitfinexAPI::AsyncCallback callback)
+            { api_.getTickerAsync(symbol, std::move(callback)); }};
+        }
+
+        Request<vector<Stat>> getStatsAsync(const string &symbol)
+        {
+            return {*this, [this, symbol](BitfinexAPI::AsyncCallback callback)
+            { api_.getStatsAsync(symbol, std::move(callback)); }};
+        }
+
+        Request<OrderBook> getOrderBookAsync(const string &symbol,
+                                             const unsigned &limit_bids = 50,
+                                             const unsigned &limit_asks = 50,
+                                             const bool &group = true)
+        {
+            return {*this, [=, this](BitfinexAPI::AsyncCallback callback)
+            {
+                api_.getOrderBookAsync(symbol, std::move(callback),
+                                       limit_bids, limit_asks, group);
+            }};
+        }
+
+        Request<vector<Trade>> getTradesAsync(const string &symbol,
+                                              const time_t &since = 0,
+                                              const unsigned &limit_trades = 50)
+        {
+            return {*this, [=, this](BitfinexAPI::AsyncCallback callback)
+            {
+                api_.getTradesAsync(symbol, std::move(callback), since,
+                                    limit_trades);
+            }};
+        }
+
+        // Interned symbol variants skip symbol check and path building
+        Request<Ticker> getTickerAsync(SymbolId symbol)
+        {
+            return {*this, [this, symbol](BitfinexAPI::AsyncCallback callback)
+            { api_.getTickerAsync(symbol, std::move(callback)); }};
+        }
+
+        Request<vector<Stat>> getStatsAsync(SymbolId symbol)
+        {
+            return {*this, [this, symbol](BitfinexAPI::AsyncCallback callback)
+            { api_.getStatsAsync(symbol, std::move(callback)); }};
+        }
+
+        Request<OrderBook> getOrderBookAsync(SymbolId symbol,
+                                             const unsigned &limit_bids = 50,
+                                             const unsigned &limit_asks = 50,
+                                             const bool &group = true)
+        {
+            return {*this, [=, this](BitfinexAPI::AsyncCallback callback)
+            {
+                api_.getOrderBookAsync(symbol, std::move(callback),
+                                       limit_bids, limit_asks, group);
+            }};
+        }
+
+        Request<vector<Trade>> getTradesAsync(SymbolId symbol,
+                                              const time_t &since = 0,
+                                              const unsigned &limit_trades = 50)
+        {
+            return {*this, [=, this](BitfinexAPI::AsyncCallback callback)
+            {
+                api_.getTradesAsync(symbol, std::move(callback), since,
+                                    limit_trades);
+            }};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Authenticated endpoints
+        ////////////////////////////////////////////////////////////////////////
+
+        // Nonce is taken when the owning thread sends the request
+
+        Request<vector<Balance>> getBalancesAsync()
+        {
+            return {*this, [this](BitfinexAPI::AsyncCallback callback)
+            { api_.getBalancesAsync(std::move(callback)); }};
+        }
+
+        Request<vector<Order>> getActiveOrdersAsync()
+        {
+            return {*this, [this](BitfinexAPI::AsyncCallback callback)
+            { api_.getActiveOrdersAsync(std::move(callback)); }};
+        }
+
+        Request<Order> getOrderStatusAsync(const long long &order_id)
+        {
+            return {*this, [this, order_id](BitfinexAPI::AsyncCallback callback)
+            { api_.getOrderStatusAsync(order_id, std::move(callback)); }};
+        }
+
+        Request<Order> newOrderAsync(const string &symbol,
+                                     const double &amount,
+                                     const double &price,
+                                     const string &side,
+                                     const string &type,
+                                     const bool &is_hidden = false,
+                                     const bool &is_postonly = false)
+        {
+            return {*this, [=, this](BitfinexAPI::AsyncCallback callback)
+            {
+                api_.newOrderAsync(symbol, amount, price, side, type,
+                                   std::move(callback), is_hidden,
+                                   is_postonly);
+            }};
+        }
+
+        Request<Order> newOrderAsync(SymbolId symbol,
+                                     const double &amount,
+                                     const double &price,
+                                     const string &side,
+                                     const string &type,
+                                     const bool &is_hidden = false,
+                                     const bool &is_postonly = false)
+        {
+            return {*this, [=, this](BitfinexAPI::AsyncCallback callback)
+            {
+                api_.newOrderAsync(symbol, amount, price, side, type,
+                                   std::move(callback), is_hidden,
+                                   is_postonly);
+            }};
+        }
+
+        Request<Order> cancelOrderAsync(const long long &order_id)
+        {
+            return {*this, [this, order_id](BitfinexAPI::AsyncCallback callback)
+            { api_.cancelOrderAsync(order_id, std::move(callback)); }};
+        }
+
+        // Any other callback style endpoint of BitfinexAPI, response is
+        // decoded into T, e.g.
+        // co_await api.request<T>([&](auto callback)
+        //                         { bfx.postAsync(endpoint, json, callback); });
+        template <typename T>
+        Request<T> request(typename Request<T>::Start start)
+        {
+            return {*this, std::move(start)};
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        BitfinexAPI &api_;
+        Executor executor_;
+        std::thread::id owner_;
+        std::atomic<size_t> pending_{0};
+        std::mutex mutex_;
+        vector<std::function<void()>> submitted_; // awaited on other threads
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        void submit(std::function<void()> start)
+        {
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            if (std::this_thread::get_id() == owner_)
+            {
+                start();
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            submitted_.push_back(std::move(start));
+        }
+
+        void startSubmitted()
+        {
+            vector<std::function<void()>> batch;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                batch.swap(submitted_);
+            }
+            for (auto &start : batch)
+                start();
+        }
+
+        void resume(std::coroutine_handle<> handle)
+        {
+            pending_.fetch_sub(1, std::memory_order_release);
+            if (executor_)
+                executor_(handle);
+            else
+                handle.resume();
+        }
+    };
+}
@@ -25,12 +25,17 @@
 #pragma once
 
 // std
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <thread>
 #include <fstream>
+#include <initializer_list>
 #include <iostream>
 #include <iostream>
 #include <map>
-#include <regex>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -44,18 +49,102 @@
 // internal HTTPRequest
 #include "HTTPRequest.hpp"
 
+// internal AsyncHTTPRequest
+#include "AsyncHTTPRequest.hpp"
+
+// internal RecordingTransport, ReplayTransport
+#include "RecordReplay.hpp"
+
+// internal BitfinexStream
+#include "BitfinexStream.hpp"
+
+// internal LocalOrderBook
+#include "LocalOrderBook.hpp"
+
+// internal SymbolId, CurrencyId
+#include "SymbolTable.hpp"
+
+// internal ClientContext
+#include "ClientContext.hpp"
+
+// internal NonceGenerator
+#include "NonceGenerator.hpp"
+
+// internal Decimal
+#include "Decimal.hpp"
+
+// internal PayloadWriter
+#include "PayloadWriter.hpp"
+
+// internal WithdrawConfig
+#include "WithdrawConfig.hpp"
+
+// internal HistoryRange
+#include "HistoryRange.hpp"
+
+// internal CaptureWriter
+#include "CaptureFile.hpp"
+
+// internal OrderCache
+#include "OrderCache.hpp"
+
 // namespaces
 using std::cerr;
 using std::cout;
 using std::endl;
 using std::string;
 using std::to_string;
+using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 
 namespace BfxAPI
 {
 
+    // Self contained result of thread-safe BitfinexAPI::fetch* calls
+    template <typename T>
+    struct Result: public HTTPResponse
+    {
+        T data;
+    };
+
+    // Result of bulk calls sent in chunks: response of every chunk and
+    // status of every submitted item, both in submission order
+    template <typename Response>
+    struct BulkResult
+    {
+        vector<Response> chunks;
+        vector<BfxClientErrors> status;
+
+        // Items rejected locally or not accepted by exchange
+        size_t failed() const noexcept
+        {
+            return static_cast<size_t>(std::count_if(
+                status.begin(), status.end(),
+                [](BfxClientErrors code) { return code != noError; }));
+        }
+    };
+
+    // orders[i] is exchange order of submitted order i, default constructed
+    // when status[i] isn't noError
+    struct BulkOrdersResult: public BulkResult<Result<NewOrders>>
+    {
+        vector<Order> orders;
+    };
+
+    // How the constructor obtains the list of valid symbols
+    enum class SymbolBootstrap
+    {
+        eager,  // fetch /symbols/ in constructor (served from ResponseCache
+                // snapshot when one is configured)
+        lazy,   // fetch /symbols/ before the first symbol check
+        none    // don't check symbols until setSymbols() is called
+    };
+
+    // Fluent methods returning BitfinexAPI& keep last response inside the
+    // instance and must not be called concurrently. fetch* methods are const
+    // and thread-safe - they return their own Result object, so one instance
+    // can be shared by any number of threads.
     class BitfinexAPI
     {
 
@@ -64,9 +153,16 @@ namespace BfxAPI
         ////////////////////////////////////////////////////////////////////////
 
         static constexpr auto API_URL = "https://api.bitfinex.com/v1";
+        // Server side throttling response status
+        static constexpr long HTTP_TOO_MANY_REQUESTS = 429;
         #ifndef WITHDRAWAL_CONF_FILE_PATH
         static constexpr auto WITHDRAWAL_CONF_FILE_PATH = "withdraw.conf";
         #endif
+        // Signed chunks rejected because they reached the exchange after
+        // a request with higher nonce are signed and sent again
+        static constexpr unsigned NONCE_RETRIES = 3;
+
+    public:
 
         ////////////////////////////////////////////////////////////////////////
         // Typedefs
@@ -83,6 +179,26 @@ namespace BfxAPI
         };
         using vOrders = vector<sOrder>;
         using vIds = vector<long long>;
+        using AsyncCallback = AsyncHTTPRequest::Callback;
+        using AsyncPromise = std::shared_ptr<std::promise<HTTPResponse>>;
+
+        // Orders per /order/new/multi/ and ids per /order/cancel/multi/
+        // request of bulk calls
+        static constexpr size_t MULTI_ORDER_CHUNK = 10;
+        // Chunks of bulk calls in flight at once
+        static constexpr unsigned BULK_CONCURRENCY = 4;
+
+    private:
+
+        // Single request of batch endpoints, status other than noError
+        // rejects request without sending it
+        struct BatchRequest
+        {
+            Endpoint endpoint;
+            string path;
+            map<string, string> params;
+            BfxClientErrors status;
+        };
 
     public:
 
@@ -92,39 +208,46 @@ namespace BfxAPI
 
         explicit BitfinexAPI():BitfinexAPI("", "") {}
 
-        explicit BitfinexAPI(const string &accessKey, const string &secretKey):
-        WDconfFilePath_(WITHDRAWAL_CONF_FILE_PATH),
-        Request(API_URL),
+        explicit BitfinexAPI(const string &accessKey,
+                             const string &secretKey,
+                             SymbolBootstrap bootstrap = SymbolBootstrap::eager):
+        BitfinexAPI(ClientContext::create(), accessKey, secretKey, bootstrap)
+        {}
+
+        // Session of one account sharing connections, rate limits, schemas
+        // and symbols with other sessions of context. Symbols are fetched
+        // by the first session needing them.
+        BitfinexAPI(std::shared_ptr<ClientContext> context,
+                    const string &accessKey,
+                    const string &secretKey,
+                    SymbolBootstrap bootstrap = SymbolBootstrap::eager):
+        context_(std::move(context)),
+        symbolBootstrap_(bootstrap),
+        withdrawConfig_(WITHDRAWAL_CONF_FILE_PATH),
+        Request(API_URL, context_->getHTTPSettings(),
+                context_->getConnectionPool()),
+        AsyncRequest(API_URL, context_->getHTTPSettings(),
+                     context_->getConnectionPool()),
         bfxApiStatusCode_(noError)
         {
             // Internal HTTPRequest set Keys
             Request.setAccessKey(accessKey);
             Request.setSecretKey(secretKey);
 
-            // populate _symbols directly from Bitfinex getSymbols endpoint
-            jsonutils::jsonStrToUset(symbols_, getSymbols().strResponse());
-
-            currencies_ =
-            {
-                "BTG",
-                "DSH",
-                "ETC",
-                "ETP",
-                "EUR",
-                "GBP",
-                "IOT",
-                "JPY",
-                "LTC",
-                "NEO",
-                "OMG",
-                "SAN",
-                "USD",
-                "XMR",
-                "XRP",
-                "ZEC"
-            };
-
-            schemaValidator_ = jsonutils::BfxSchemaValidator(symbols_, currencies_);
+            // Requests of all sessions share rate limits of context
+            // (process-wide by default)
+            Request.setRateLimiter(context_->getRateLimiter());
+            AsyncRequest.setRateLimiter(context_->getRateLimiter());
+            // ... and latency metrics
+            Request.setLatencyMetrics(context_->getLatencyMetrics());
+            AsyncRequest.setLatencyMetrics(context_->getLatencyMetrics());
+            // Metadata endpoints (symbols, fees ...) are served from cache
+            Request.setResponseCache(context_->getResponseCache());
+
+            // populate symbols directly from Bitfinex getSymbols endpoint
+            // unless another session of context did
+            if (symbolBootstrap_ == SymbolBootstrap::eager)
+                loadedSymbols();
 
             // As found on
             // https://bitfinex.readme.io/v1/reference#rest-auth-deposit
@@ -163,6 +286,13 @@ namespace BfxAPI
             };
         }
 
+        // Preloaded list of valid symbols, no request is made
+        explicit BitfinexAPI(const string &accessKey,
+                             const string &secretKey,
+                             const vector<string> &symbols):
+        BitfinexAPI(accessKey, secretKey, SymbolBootstrap::none)
+        { setSymbols(symbols); }
+
         // BitfinexAPI object cannot be
         // copied
         BitfinexAPI(const BitfinexAPI&) = delete;
@@ -178,139 +308,1430 @@ namespace BfxAPI
         ////////////////////////////////////////////////////////////////////////
 
         // Getters
-        const string getWDconfFilePath() const noexcept
-        { return WDconfFilePath_; }
+        const string& getWDconfFilePath() const noexcept
+        { return withdrawConfig_.getPath(); }
 
         const BfxClientErrors& getBfxApiStatusCode() const noexcept
         { return bfxApiStatusCode_; }
 
-        const CURLcode getCurlStatusCode() const noexcept
-        { return Request.getLastStatusCode(); }
+        CURLcode getCurlStatusCode() const noexcept
+        { return Request.getLastStatusCode(); }
+
+        const string& strResponse() const noexcept
+        { return Request.getLastResponse(); }
+
+        const jsonutils::BfxSchemaValidator& getSchemaValidator() const noexcept
+        { return schemaValidator(); }
+
+        const std::shared_ptr<ClientContext>& getContext() const noexcept
+        { return context_; }
+
+        // Last response is validated once, repeated checks are free
+        bool hasApiError()
+        {
+            if (checkedResponse_ != Request.getResponseSerial())
+                checkErrors();
+            return (bfxApiStatusCode_ != noError || Request.hasError());
+        }
+
+        // Setters
+        void setWDconfFilePath(const string &path) noexcept
+        { withdrawConfig_.setPath(path); }
+
+        void setKeys(const string &accessKey, const string &secretKey) noexcept
+        {
+            Request.setAccessKey(accessKey);
+            Request.setSecretKey(secretKey);
+        }
+
+        // Persist nonce high-water mark so that nonces keep increasing
+        // across restarts, see NonceGenerator
+        void setNonceFilePath(const string &path)
+        { NonceGenerator::instance().setPersistencePath(path); }
+
+        // Connection settings (timeouts, keepalive, HTTP/2 ...)
+        void setHTTPSettings(const HTTPSettings &settings)
+        { Request.setSettings(settings); }
+
+        const HTTPSettings& getHTTPSettings() const noexcept
+        { return Request.getSettings(); }
+
+        // Let Request write responses into caller owned reusable buffer
+        void setResponseBuffer(string &buffer) noexcept
+        { Request.setResponseBuffer(buffer); }
+
+        void resetResponseBuffer() noexcept
+        { Request.resetResponseBuffer(); }
+
+        // Client side rate limiter, see RateLimiter. nullptr disables it.
+        void setRateLimiter(std::shared_ptr<RateLimiter> limiter)
+        {
+            Request.setRateLimiter(limiter);
+            AsyncRequest.setRateLimiter(std::move(limiter));
+        }
+
+        const std::shared_ptr<RateLimiter>& getRateLimiter() const noexcept
+        { return Request.getRateLimiter(); }
+
+        // TTL cache of slow-changing endpoints, see ResponseCache. nullptr
+        // disables it.
+        void setResponseCache(std::shared_ptr<ResponseCache> cache) noexcept
+        { Request.setResponseCache(std::move(cache)); }
+
+        const std::shared_ptr<ResponseCache>& getResponseCache() const noexcept
+        { return Request.getResponseCache(); }
+
+        // Per endpoint histograms of network and validation time, see
+        // LatencyMetrics. nullptr disables recording.
+        void setLatencyMetrics(std::shared_ptr<LatencyMetrics> metrics)
+        {
+            Request.setLatencyMetrics(metrics);
+            AsyncRequest.setLatencyMetrics(std::move(metrics));
+        }
+
+        const std::shared_ptr<LatencyMetrics>& getLatencyMetrics() const
+        noexcept
+        { return Request.getLatencyMetrics(); }
+
+        // Sends all requests through transport, e.g. RecordingTransport or
+        // ReplayTransport, nullptr restores libcurl. Symbols of eager
+        // SymbolBootstrap are fetched before transport can be set, so replay
+        // should use lazy or none bootstrap.
+        void setTransport(std::shared_ptr<Transport> transport)
+        {
+            Request.setTransport(transport);
+            AsyncRequest.setTransport(std::move(transport));
+        }
+
+        const std::shared_ptr<Transport>& getTransport() const noexcept
+        { return Request.getTransport(); }
+
+        // libcurl transport with keys, rate limiter, cache and retries of
+        // this object, to be wrapped by RecordingTransport. Must not outlive
+        // this object.
+        std::shared_ptr<Transport> getCurlTransport() const
+        { return Request.curlTransport(); }
+
+        // Decoded trades and order books of successful fetch*, batch and
+        // typed fluent calls are appended to capture, nullptr disables it
+        void setCaptureWriter(std::shared_ptr<CaptureWriter> capture) noexcept
+        { capture_ = std::move(capture); }
+
+        const std::shared_ptr<CaptureWriter>& getCaptureWriter() const noexcept
+        { return capture_; }
+
+        // Orders of successful order entry, status and /orders/ calls are
+        // applied to cache (fluent calls decode their response for it),
+        // nullptr disables it. Cache belongs to the account of this object.
+        void setOrderCache(std::shared_ptr<OrderCache> cache) noexcept
+        { orderCache_ = std::move(cache); }
+
+        const std::shared_ptr<OrderCache>& getOrderCache() const noexcept
+        { return orderCache_; }
+
+        // Typed results of fetch*, batch and asynchronous calls are decoded
+        // in place inside response body, which is then left empty. Fluent
+        // calls keep their response for strResponse() and hasApiError().
+        void setInsituParsing(bool enabled) noexcept
+        { insituParsing_ = enabled; }
+
+        // Schema validation of endpoint responses: full (default), sampled
+        // 1 in sampleInterval, structural (parse only) or off. Typed results
+        // are always decoded. Mismatch counters are kept by
+        // getSchemaValidator().getValidationStats(). Applies to all
+        // sessions of ClientContext.
+        void setValidationMode(Endpoint endpoint,
+                               jsonutils::ValidationMode mode,
+                               unsigned sampleInterval = 100) noexcept
+        {
+            context_->getSchemaValidator().setValidationMode(endpoint, mode,
+                                                             sampleInterval);
+        }
+
+        void setValidationMode(jsonutils::ValidationMode mode,
+                               unsigned sampleInterval = 100) noexcept
+        { context_->getSchemaValidator().setValidationMode(mode, sampleInterval); }
+
+        // Per endpoint retry with backoff and hedging of public GET requests
+        RetryPolicies& getRetryPolicies() noexcept
+        { return Request.getRetryPolicies(); }
+
+        // Replaces list of valid symbols of all sessions of ClientContext,
+        // e.g. with list saved by previous run
+        void setSymbols(const vector<string> &symbols)
+        { context_->getSymbols().setSymbols(symbols); }
+
+        // Interned symbol, invalid when symbol is unknown (also before
+        // symbols are loaded in SymbolBootstrap::none mode). Ids stay valid
+        // for the lifetime of ClientContext, also after setSymbols().
+        SymbolId getSymbolId(const string &symbol) const
+        {
+            return loadedSymbols() ? symbols().table().find(symbol)
+                                   : SymbolId();
+        }
+
+        CurrencyId getCurrencyId(const string &currency) const noexcept
+        { return currencies().find(currency); }
+
+        // Ids of all known symbols
+        const SymbolTable& getSymbolTable() const
+        {
+            loadedSymbols();
+            return symbols().table();
+        }
+
+        // Price precision (significant digits) used to format order prices,
+        // also loaded by getSymbolsDetails(vector<SymbolDetails>&)
+        void setSymbolsDetails(const vector<SymbolDetails> &details)
+        { context_->getSymbols().setPricePrecisions(details); }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Public endpoints
+        ////////////////////////////////////////////////////////////////////////
+
+        BitfinexAPI& getTicker(const string &symbol)
+        {
+            if (!knownSymbol(symbol))
+                bfxApiStatusCode_ = badSymbol;
+            else
+                Request.get("/pubticker/" + symbol);
+
+            return *this;
+        };
+
+        BitfinexAPI& getTicker(const string &symbol, Ticker &ticker)
+        {
+            bfxApiStatusCode_ = noError;
+            if (getTicker(symbol).bfxApiStatusCode_ == noError)
+                decodeLastResponse(ticker);
+
+            return *this;
+        };
+
+        // Interned symbol variants skip symbol check and path building
+        BitfinexAPI& getTicker(SymbolId symbol)
+        {
+            if (!symbol)
+                bfxApiStatusCode_ = badSymbol;
+            else
+                Request.get(symbol.path(Endpoint::pubticker));
+
+            return *this;
+        };
+
+        BitfinexAPI& getTicker(SymbolId symbol, Ticker &ticker)
+        {
+            bfxApiStatusCode_ = noError;
+            if (getTicker(symbol).bfxApiStatusCode_ == noError)
+                decodeLastResponse(ticker);
+
+            return *this;
+        };
+
+        BitfinexAPI& getStats(const string &symbol)
+        {
+            if (!knownSymbol(symbol))
+                bfxApiStatusCode_ = badSymbol;
+            else
+                Request.get("/stats/" + symbol);
+
+            return *this;
+        };
+
+        BitfinexAPI& getStats(SymbolId symbol)
+        {
+            if (!symbol)
+                bfxApiStatusCode_ = badSymbol;
+            else
+                Request.get(symbol.path(Endpoint::stats));
+
+            return *this;
+        };
+
+        BitfinexAPI& getFundingBook(const string &currency,
+                                    const unsigned &limit_bids = 50,
+                                    const unsigned &limit_asks = 50)
+        {
+            if (!currencies().contains(currency))
+                bfxApiStatusCode_ = badCurrency;
+            else
+            {
+                map<string, string> params;
+                params["limit_bids"] = to_string(limit_bids);
+                params["limit_asks"] = to_string(limit_asks);
+                Request.get("/lendbook/" + currency, params);
+            }
+
+            return *this;
+        };
+
+        BitfinexAPI& getOrderBook(const string &symbol,
+                                  const unsigned &limit_bids = 50,
+                                  const unsigned &limit_asks = 50,
+                                  const bool &group = true)
+        {
+            if (!knownSymbol(symbol))
+                bfxApiStatusCode_ = badSymbol;
+            else
+            {
+                map<string, string> params;
+                params["limit_bids"] = to_string(limit_bids);
+                params["limit_asks"] = to_string(limit_asks);
+                params["group"]      = to_string(group);
+                Request.get("/book/" + symbol, params);
+            }
+
+            return *this;
+        };
+
+        BitfinexAPI& getOrderBook(const string &symbol,
+                                  OrderBook &book,
+                                  const unsigned &limit_bids = 50,
+                                  const unsigned &limit_asks = 50,
+                                  const bool &group = true)
+        {
+            bfxApiStatusCode_ = noError;
+            getOrderBook(symbol, limit_bids, limit_asks, group);
+            if (bfxApiStatusCode_ == noError)
+                decodeLastResponse(book);
+
+            return *this;
+        };
+
+        BitfinexAPI& getOrderBook(SymbolId symbol,
+                                  const unsigned &limit_bids = 50,
+                                  const unsigned &limit_asks = 50,
+                                  const bool &group = true)
+        {
+            if (!symbol)
+                bfxApiStatusCode_ = badSymbol;
+            else
+            {
+                map<string, string> params;
+                params["limit_bids"] = to_string(limit_bids);
+                params["limit_asks"] = to_string(limit_asks);
+                params["group"]      = to_string(group);
+                Request.get(symbol.path(Endpoint::book), params);
+            }
+
+            return *this;
+        };
+
+        BitfinexAPI& getOrderBook(SymbolId symbol,
+                                  OrderBook &book,
+                                  const unsigned &limit_bids = 50,
+                                  const unsigned &limit_asks = 50,
+                                  const bool &group = true)
+        {
+            bfxApiStatusCode_ = noError;
+            getOrderBook(symbol, limit_bids, limit_asks, group);
+            if (bfxApiStatusCode_ == noError)
+                decodeLastResponse(book);
+
+            return *this;
+        };
+
+        BitfinexAPI& getTrades(const string &symbol,
+                               const time_t &since = 0,
+                               const unsigned &limit_trades = 50)
+        {
+            if (!knownSymbol(symbol))
+                bfxApiStatusCode_ = badSymbol;
+            else
+            {
+                map<string, string> params;
+                params["timestamp"]    = to_string(since);
+                params["limit_trades"] = to_string(limit_trades);
+                Request.get("/trades/" + symbol, params);
+            }
+
+            return *this;
+        };
+
+        BitfinexAPI& getTrades(const string &symbol,
+                               vector<Trade> &trades,
+                               const time_t &since = 0,
+                               const unsigned &limit_trades = 50)
+        {
+            bfxApiStatusCode_ = noError;
+            getTrades(symbol, since, limit_trades);
+            if (bfxApiStatusCode_ == noError)
+                decodeLastResponse(trades);
+
+            return *this;
+        };
+
+        BitfinexAPI& getTrades(SymbolId symbol,
+                               const time_t &since = 0,
+                               const unsigned &limit_trades = 50)
+        {
+            if (!symbol)
+                bfxApiStatusCode_ = badSymbol;
+            else
+            {
+                map<string, string> params;
+                params["timestamp"]    = to_string(since);
+                params["limit_trades"] = to_string(limit_trades);
+                Request.get(symbol.path(Endpoint::trades), params);
+            }
+
+            return *this;
+        };
+
+        BitfinexAPI& getTrades(SymbolId symbol,
+                               vector<Trade> &trades,
+                               const time_t &since = 0,
+                               const unsigned &limit_trades = 50)
+        {
+            bfxApiStatusCode_ = noError;
+            getTrades(symbol, since, limit_trades);
+            if (bfxApiStatusCode_ == noError)
+                decodeLastResponse(trades);
+
+            return *this;
+        };
+
+        BitfinexAPI& getLends(const string &currency,
+                              const time_t &since = 0,
+                              const unsigned &limit_lends = 50)
+        {
+            if (!currencies().contains(currency))
+                bfxApiStatusCode_ = badCurrency;
+            else
+            {
+                map<string, string> params;
+                params["timestamp"]   = to_string(since);
+                params["limit_lends"] = to_string(limit_lends);
+                Request.get("/lends/" + currency, params);
+            }
+
+            return *this;
+        };
+
+        BitfinexAPI& getSymbols()
+        {
+            Request.get("/symbols/");
+
+            return *this;
+        };
+
+        BitfinexAPI& getSymbolsDetails()
+        {
+            Request.get("/symbols_details/");
+
+            return *this;
+        };
+
+        BitfinexAPI& getSymbolsDetails(vector<SymbolDetails> &details)
+        {
+            bfxApiStatusCode_ = noError;
+            getSymbolsDetails();
+            decodeLastResponse(details);
+            if (bfxApiStatusCode_ == noError)
+                setSymbolsDetails(details);
+
+            return *this;
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Asynchronous public endpoints
+        ////////////////////////////////////////////////////////////////////////
+
+        // Requests are sent concurrently and completed from pollAsync() or
+        // runAsync() called on the thread owning BitfinexAPI instance.
+        // Delivered responses are not validated yet, pass them to
+        // checkResponse() or decodeResponse().
+
+        void getTickerAsync(const string &symbol, AsyncCallback callback)
+        {
+            if (!knownSymbol(symbol))
+                rejectAsync("/pubticker/" + symbol, badSymbol, callback);
+            else
+                AsyncRequest.get("/pubticker/" + symbol, {}, std::move(callback));
+        };
+
+        void getStatsAsync(const string &symbol, AsyncCallback callback)
+        {
+            if (!knownSymbol(symbol))
+                rejectAsync("/stats/" + symbol, badSymbol, callback);
+            else
+                AsyncRequest.get("/stats/" + symbol, {}, std::move(callback));
+        };
+
+        void getOrderBookAsync(const string &symbol,
+                               AsyncCallback callback,
+                               const unsigned &limit_bids = 50,
+                               const unsigned &limit_asks = 50,
+                               const bool &group = true)
+        {
+            if (!knownSymbol(symbol))
+                rejectAsync("/book/" + symbol, badSymbol, callback);
+            else
+            {
+                map<string, string> params;
+                params["limit_bids"] = to_string(limit_bids);
+                params["limit_asks"] = to_string(limit_asks);
+                params["group"]      = to_string(group);
+                AsyncRequest.get("/book/" + symbol, params, std::move(callback));
+            }
+        };
+
+        void getTradesAsync(const string &symbol,
+                            AsyncCallback callback,
+                            const time_t &since = 0,
+                            const unsigned &limit_trades = 50)
+        {
+            if (!knownSymbol(symbol))
+                rejectAsync("/trades/" + symbol, badSymbol, callback);
+            else
+            {
+                map<string, string> params;
+                params["timestamp"]    = to_string(since);
+                params["limit_trades"] = to_string(limit_trades);
+                AsyncRequest.get("/trades/" + symbol, params, std::move(callback));
+            }
+        };
+
+        void getTickerAsync(SymbolId symbol, AsyncCallback callback)
+        {
+            if (!symbol)
+                rejectAsync("/pubticker/", badSymbol, callback);
+            else
+                AsyncRequest.get(symbol.path(Endpoint::pubticker), {},
+                                 std::move(callback));
+        };
+
+        void getStatsAsync(SymbolId symbol, AsyncCallback callback)
+        {
+            if (!symbol)
+                rejectAsync("/stats/", badSymbol, callback);
+            else
+                AsyncRequest.get(symbol.path(Endpoint::stats), {},
+                                 std::move(callback));
+        };
+
+        void getOrderBookAsync(SymbolId symbol,
+                               AsyncCallback callback,
+                               const unsigned &limit_bids = 50,
+                               const unsigned &limit_asks = 50,
+                               const bool &group = true)
+        {
+            if (!symbol)
+                rejectAsync("/book/", badSymbol, callback);
+            else
+            {
+                map<string, string> params;
+                params["limit_bids"] = to_string(limit_bids);
+                params["limit_asks"] = to_string(limit_asks);
+                params["group"]      = to_string(group);
+                AsyncRequest.get(symbol.path(Endpoint::book), params,
+                                 std::move(callback));
+            }
+        };
+
+        void getTradesAsync(SymbolId symbol,
+                            AsyncCallback callback,
+                            const time_t &since = 0,
+                            const unsigned &limit_trades = 50)
+        {
+            if (!symbol)
+                rejectAsync("/trades/", badSymbol, callback);
+            else
+            {
+                map<string, string> params;
+                params["timestamp"]    = to_string(since);
+                params["limit_trades"] = to_string(limit_trades);
+                AsyncRequest.get(symbol.path(Endpoint::trades), params,
+                                 std::move(callback));
+            }
+        };
+
+        std::future<HTTPResponse> getTickerAsync(const string &symbol)
+        {
+            auto promise = makeAsyncPromise();
+            getTickerAsync(symbol, fulfil(promise));
+            return promise->get_future();
+        };
+
+        std::future<HTTPResponse> getStatsAsync(const string &symbol)
+        {
+            auto promise = makeAsyncPromise();
+            getStatsAsync(symbol, fulfil(promise));
+            return promise->get_future();
+        };
+
+        std::future<HTTPResponse> getOrderBookAsync(const string &symbol,
+                                                    const unsigned &limit_bids = 50,
+                                                    const unsigned &limit_asks = 50,
+                                                    const bool &group = true)
+        {
+            auto promise = makeAsyncPromise();
+            getOrderBookAsync(symbol, fulfil(promise),
+                              limit_bids, limit_asks, group);
+            return promise->get_future();
+        };
+
+        std::future<HTTPResponse> getTradesAsync(const string &symbol,
+                                                 const time_t &since = 0,
+                                                 const unsigned &limit_trades = 50)
+        {
+            auto promise = makeAsyncPromise();
+            getTradesAsync(symbol, fulfil(promise), since, limit_trades);
+            return promise->get_future();
+        };
+
+        std::future<HTTPResponse> getTickerAsync(SymbolId symbol)
+        {
+            auto promise = makeAsyncPromise();
+            getTickerAsync(symbol, fulfil(promise));
+            return promise->get_future();
+        };
+
+        std::future<HTTPResponse> getStatsAsync(SymbolId symbol)
+        {
+            auto promise = makeAsyncPromise();
+            getStatsAsync(symbol, fulfil(promise));
+            return promise->get_future();
+        };
+
+        std::future<HTTPResponse> getOrderBookAsync(SymbolId symbol,
+                                                    const unsigned &limit_bids = 50,
+                                                    const unsigned &limit_asks = 50,
+                                                    const bool &group = true)
+        {
+            auto promise = makeAsyncPromise();
+            getOrderBookAsync(symbol, fulfil(promise),
+                              limit_bids, limit_asks, group);
+            return promise->get_future();
+        };
+
+        std::future<HTTPResponse> getTradesAsync(SymbolId symbol,
+                                                 const time_t &since = 0,
+                                                 const unsigned &limit_trades = 50)
+        {
+            auto promise = makeAsyncPromise();
+            getTradesAsync(symbol, fulfil(promise), since, limit_trades);
+            return promise->get_future();
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Asynchronous authenticated endpoints
+        ////////////////////////////////////////////////////////////////////////
+
+        // Signed POST of endpoint with payload started by payload(), same
+        // completion rules as asynchronous public endpoints
+        void postAsync(Endpoint endpoint,
+                       const string &payload,
+                       AsyncCallback callback)
+        {
+            const string &path = endpointInfo(endpoint).path;
+            AsyncRequest.post(path, payload, Request.signedHeaderLines(payload),
+                              std::move(callback));
+        };
+
+        void getBalancesAsync(AsyncCallback callback)
+        {
+            auto params = payload("/v1/balances");
+            postAsync(Endpoint::balances, params.str(), std::move(callback));
+        };
+
+        void getActiveOrdersAsync(AsyncCallback callback)
+        {
+            auto params = payload("/v1/orders");
+            postAsync(Endpoint::orders, params.str(), std::move(callback));
+        };
+
+        void getOrderStatusAsync(const long long &order_id,
+                                 AsyncCallback callback)
+        {
+            auto params = payload("/v1/order/status");
+            params.integer("order_id", order_id);
+            postAsync(Endpoint::orderStatus, params.str(), std::move(callback));
+        };
+
+        void newOrderAsync(const string &symbol,
+                           const double &amount,
+                           const double &price,
+                           const string &side,
+                           const string &type,
+                           AsyncCallback callback,
+                           const bool &is_hidden = false,
+                           const bool &is_postonly = false)
+        {
+            if (!knownSymbol(symbol))
+                rejectAsync("/order/new/", badSymbol, callback);
+            else if (!inArray(type, types_))
+                rejectAsync("/order/new/", badOrderType, callback);
+            else
+                postAsync(Endpoint::orderNew,
+                          newOrderPayload(symbol,
+                                          symbols().pricePrecision(symbol),
+                                          amount, price, side, type,
+                                          is_hidden, is_postonly).str(),
+                          std::move(callback));
+        };
+
+        void newOrderAsync(SymbolId symbol,
+                           const double &amount,
+                           const double &price,
+                           const string &side,
+                           const string &type,
+                           AsyncCallback callback,
+                           const bool &is_hidden = false,
+                           const bool &is_postonly = false)
+        {
+            if (!symbol)
+                rejectAsync("/order/new/", badSymbol, callback);
+            else if (!inArray(type, types_))
+                rejectAsync("/order/new/", badOrderType, callback);
+            else
+                postAsync(Endpoint::orderNew,
+                          newOrderPayload(symbol.name(),
+                                          symbols().pricePrecision(symbol),
+                                          amount, price, side, type,
+                                          is_hidden, is_postonly).str(),
+                          std::move(callback));
+        };
+
+        void cancelOrderAsync(const long long &order_id,
+                              AsyncCallback callback)
+        {
+            auto params = payload("/v1/order/cancel");
+            params.integer("order_id", order_id);
+            postAsync(Endpoint::orderCancel, params.str(), std::move(callback));
+        };
+
+        // Drives asynchronous requests, see AsyncHTTPRequest::poll()
+        size_t pollAsync(int timeoutMs = 0)
+        { return AsyncRequest.poll(timeoutMs); }
+
+        void runAsync()
+        { AsyncRequest.run(); }
+
+        // Validates asynchronous response, result is stored in
+        // response.bfxApiStatusCode
+        BfxClientErrors checkResponse(HTTPResponse &response) const
+        {
+            if (response.bfxApiStatusCode == noError)
+                response.bfxApiStatusCode = response.curlStatusCode != CURLE_OK
+                    ? curlERR
+                    : response.httpStatusCode == HTTP_TOO_MANY_REQUESTS
+                    ? rateLimitError
+                    : timedValidation(response, [this, &response]
+                    {
+                        return schemaValidator().validateSchema(
+                            apiEndPoint(response), response.body);
+                    });
+            return response.bfxApiStatusCode;
+        }
+
+        // Validates and decodes asynchronous response in one pass. In-situ
+        // parsing consumes response.body, which is cleared afterwards.
+        template <typename T>
+        BfxClientErrors decodeResponse(HTTPResponse &response, T &out) const
+        {
+            if (response.bfxApiStatusCode != noError)
+                return response.bfxApiStatusCode;
+
+            if (response.curlStatusCode != CURLE_OK)
+                response.bfxApiStatusCode = curlERR;
+            else if (response.httpStatusCode == HTTP_TOO_MANY_REQUESTS)
+                response.bfxApiStatusCode = rateLimitError;
+            else if (insituParsing_)
+            {
+                response.bfxApiStatusCode = timedValidation(response,
+                    [this, &response, &out]
+                {
+                    return schemaValidator().decodeResponseInsitu(
+                        apiEndPoint(response), response.body, out);
+                });
+                response.body.clear();
+            }
+            else
+                response.bfxApiStatusCode = timedValidation(response,
+                    [this, &response, &out]
+                {
+                    return schemaValidator().decodeResponse(
+                        apiEndPoint(response), response.body, out);
+                });
+            return response.bfxApiStatusCode;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Thread-safe endpoints
+        ////////////////////////////////////////////////////////////////////////
+
+        // Validated public GET request
+        HTTPResponse fetchPublic(const string &path,
+                                 const map<string, string> &params = {}) const
+        {
+            HTTPResponse response;
+            Request.perform(response, path, params);
+            checkResponse(response);
+            return response;
+        };
+
+        // Validated and decoded public GET request
+        template <typename T>
+        Result<T> fetchPublic(const string &path,
+                              const map<string, string> &params = {}) const
+        {
+            Result<T> result;
+            Request.perform(result, path, params);
+            decodeResponse(result, result.data);
+            return result;
+        };
+
+        // Validated and decoded public GET request of endpoint, path is
+        // endpoint path followed by suffix (symbol or currency)
+        template <typename T>
+        Result<T> fetchPublic(Endpoint endpoint,
+                              const string &suffix = "",
+                              const map<string, string> &params = {}) const
+        {
+            return fetchPublicPath<T>(endpoint,
+                                      endpointInfo(endpoint).path + suffix,
+                                      params);
+        };
+
+        // path must belong to endpoint, e.g. SymbolId::path(endpoint)
+        template <typename T>
+        Result<T> fetchPublicPath(Endpoint endpoint,
+                                  const string &path,
+                                  const map<string, string> &params = {}) const
+        {
+            Result<T> result;
+            result.endpoint = endpoint;
+            Request.perform(result, path, params);
+            if (decodeResponse(result, result.data) == noError)
+                capture(endpoint, path, result.data);
+            return result;
+        };
+
+        // Validated authenticated POST request, payload is request JSON
+        HTTPResponse fetchAuthenticated(const string &path,
+                                        const string &payload) const
+        {
+            HTTPResponse response;
+            Request.performSigned(response, path, payload);
+            checkResponse(response);
+            return response;
+        };
+
+        // Validated and decoded authenticated POST request
+        template <typename T>
+        Result<T> fetchAuthenticated(const string &path,
+                                     const string &payload) const
+        {
+            Result<T> result;
+            Request.performSigned(result, path, payload);
+            decodeResponse(result, result.data);
+            return result;
+        };
+
+        template <typename T>
+        Result<T> fetchAuthenticated(Endpoint endpoint,
+                                     const string &payload) const
+        {
+            Result<T> result;
+            result.endpoint = endpoint;
+            Request.performSigned(result, endpointInfo(endpoint).path, payload);
+            decodeResponse(result, result.data);
+            return result;
+        };
+
+        Result<Ticker> fetchTicker(const string &symbol) const
+        {
+            if (!knownSymbol(symbol))
+                return rejected<Ticker>("/pubticker/" + symbol, badSymbol);
+
+            return fetchPublic<Ticker>(Endpoint::pubticker, symbol);
+        };
+
+        // Interned symbol variants skip symbol check and path building
+        Result<Ticker> fetchTicker(SymbolId symbol) const
+        {
+            if (!symbol)
+                return rejected<Ticker>("/pubticker/", badSymbol);
+
+            return fetchPublicPath<Ticker>(Endpoint::pubticker,
+                                           symbol.path(Endpoint::pubticker));
+        };
+
+        Result<OrderBook> fetchOrderBook(const string &symbol,
+                                         const unsigned &limit_bids = 50,
+                                         const unsigned &limit_asks = 50,
+                                         const bool &group = true) const
+        {
+            if (!knownSymbol(symbol))
+                return rejected<OrderBook>("/book/" + symbol, badSymbol);
+
+            map<string, string> params;
+            params["limit_bids"] = to_string(limit_bids);
+            params["limit_asks"] = to_string(limit_asks);
+            params["group"]      = to_string(group);
+            return fetchPublic<OrderBook>(Endpoint::book, symbol, params);
+        };
+
+        Result<OrderBook> fetchOrderBook(SymbolId symbol,
+                                         const unsigned &limit_bids = 50,
+                                         const unsigned &limit_asks = 50,
+                                         const bool &group = true) const
+        {
+            if (!symbol)
+                return rejected<OrderBook>("/book/", badSymbol);
+
+            map<string, string> params;
+            params["limit_bids"] = to_string(limit_bids);
+            params["limit_asks"] = to_string(limit_asks);
+            params["group"]      = to_string(group);
+            return fetchPublicPath<OrderBook>(Endpoint::book,
+                                              symbol.path(Endpoint::book),
+                                              params);
+        };
+
+        Result<vector<Trade>> fetchTrades(const string &symbol,
+                                          const time_t &since = 0,
+                                          const unsigned &limit_trades = 50)
+        const
+        {
+            if (!knownSymbol(symbol))
+                return rejected<vector<Trade>>("/trades/" + symbol, badSymbol);
+
+            map<string, string> params;
+            params["timestamp"]    = to_string(since);
+            params["limit_trades"] = to_string(limit_trades);
+            return fetchPublic<vector<Trade>>(Endpoint::trades, symbol, params);
+        };
+
+        Result<vector<Trade>> fetchTrades(SymbolId symbol,
+                                          const time_t &since = 0,
+                                          const unsigned &limit_trades = 50)
+        const
+        {
+            if (!symbol)
+                return rejected<vector<Trade>>("/trades/", badSymbol);
+
+            map<string, string> params;
+            params["timestamp"]    = to_string(since);
+            params["limit_trades"] = to_string(limit_trades);
+            return fetchPublicPath<vector<Trade>>(Endpoint::trades,
+                                                  symbol.path(Endpoint::trades),
+                                                  params);
+        };
+
+        Result<vector<Stat>> fetchStats(const string &symbol) const
+        {
+            if (!knownSymbol(symbol))
+                return rejected<vector<Stat>>("/stats/" + symbol, badSymbol);
+
+            return fetchPublic<vector<Stat>>(Endpoint::stats, symbol);
+        };
+
+        Result<vector<Stat>> fetchStats(SymbolId symbol) const
+        {
+            if (!symbol)
+                return rejected<vector<Stat>>("/stats/", badSymbol);
+
+            return fetchPublicPath<vector<Stat>>(Endpoint::stats,
+                                                 symbol.path(Endpoint::stats));
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Thread-safe batch endpoints
+        ////////////////////////////////////////////////////////////////////////
+
+        // Requests for all symbols are in flight at once, so refreshing the
+        // whole universe takes about one round trip. Results are returned
+        // in symbols order, each with its own status.
+
+        vector<Result<Ticker>> fetchTickerBatch(const vector<string> &symbols) const
+        {
+            vector<BatchRequest> requests;
+            for (const auto &symbol : symbols)
+                requests.push_back({Endpoint::pubticker,
+                                    "/pubticker/" + symbol, {},
+                                    knownSymbol(symbol)
+                                        ? noError : badSymbol});
+            return fetchPublicBatch<Ticker>(requests);
+        };
+
+        vector<Result<vector<Stat>>> fetchStatsBatch(const vector<string> &symbols)
+        const
+        {
+            vector<BatchRequest> requests;
+            for (const auto &symbol : symbols)
+                requests.push_back({Endpoint::stats,
+                                    "/stats/" + symbol, {},
+                                    knownSymbol(symbol)
+                                        ? noError : badSymbol});
+            return fetchPublicBatch<vector<Stat>>(requests);
+        };
+
+        vector<Result<OrderBook>> fetchOrderBookBatch(const vector<string> &symbols,
+                                                      const unsigned &limit_bids = 50,
+                                                      const unsigned &limit_asks = 50,
+                                                      const bool &group = true)
+        const
+        {
+            map<string, string> params;
+            params["limit_bids"] = to_string(limit_bids);
+            params["limit_asks"] = to_string(limit_asks);
+            params["group"]      = to_string(group);
+
+            vector<BatchRequest> requests;
+            for (const auto &symbol : symbols)
+                requests.push_back({Endpoint::book,
+                                    "/book/" + symbol, params,
+                                    knownSymbol(symbol)
+                                        ? noError : badSymbol});
+            return fetchPublicBatch<OrderBook>(requests);
+        };
+
+        vector<Result<vector<Trade>>> fetchTradesBatch(const vector<string> &symbols,
+                                                       const time_t &since = 0,
+                                                       const unsigned &limit_trades = 50)
+        const
+        {
+            map<string, string> params;
+            params["timestamp"]    = to_string(since);
+            params["limit_trades"] = to_string(limit_trades);
+
+            vector<BatchRequest> requests;
+            for (const auto &symbol : symbols)
+                requests.push_back({Endpoint::trades,
+                                    "/trades/" + symbol, params,
+                                    knownSymbol(symbol)
+                                        ? noError : badSymbol});
+            return fetchPublicBatch<vector<Trade>>(requests);
+        };
+
+        // Braced lists of names, e.g. {"btcusd", "ethusd"}, would be
+        // ambiguous between name and id vectors
+        vector<Result<Ticker>> fetchTickerBatch(
+            std::initializer_list<string> symbols) const
+        { return fetchTickerBatch(vector<string>(symbols)); };
+
+        vector<Result<vector<Stat>>> fetchStatsBatch(
+            std::initializer_list<string> symbols) const
+        { return fetchStatsBatch(vector<string>(symbols)); };
+
+        vector<Result<OrderBook>> fetchOrderBookBatch(
+            std::initializer_list<string> symbols,
+            const unsigned &limit_bids = 50,
+            const unsigned &limit_asks = 50,
+            const bool &group = true) const
+        {
+            return fetchOrderBookBatch(vector<string>(symbols),
+                                       limit_bids, limit_asks, group);
+        };
+
+        vector<Result<vector<Trade>>> fetchTradesBatch(
+            std::initializer_list<string> symbols,
+            const time_t &since = 0,
+            const unsigned &limit_trades = 50) const
+        {
+            return fetchTradesBatch(vector<string>(symbols),
+                                    since, limit_trades);
+        };
+
+        // Interned symbol variants skip symbol check and path building
+        vector<Result<Ticker>> fetchTickerBatch(const vector<SymbolId> &symbols)
+        const
+        {
+            return fetchPublicBatch<Ticker>(
+                batchRequests(Endpoint::pubticker, symbols, {}));
+        };
+
+        vector<Result<vector<Stat>>> fetchStatsBatch(
+            const vector<SymbolId> &symbols) const
+        {
+            return fetchPublicBatch<vector<Stat>>(
+                batchRequests(Endpoint::stats, symbols, {}));
+        };
+
+        vector<Result<OrderBook>> fetchOrderBookBatch(
+            const vector<SymbolId> &symbols,
+            const unsigned &limit_bids = 50,
+            const unsigned &limit_asks = 50,
+            const bool &group = true) const
+        {
+            map<string, string> params;
+            params["limit_bids"] = to_string(limit_bids);
+            params["limit_asks"] = to_string(limit_asks);
+            params["group"]      = to_string(group);
+            return fetchPublicBatch<OrderBook>(
+                batchRequests(Endpoint::book, symbols, params));
+        };
+
+        vector<Result<vector<Trade>>> fetchTradesBatch(
+            const vector<SymbolId> &symbols,
+            const time_t &since = 0,
+            const unsigned &limit_trades = 50) const
+        {
+            map<string, string> params;
+            params["timestamp"]    = to_string(since);
+            params["limit_trades"] = to_string(limit_trades);
+            return fetchPublicBatch<vector<Trade>>(
+                batchRequests(Endpoint::trades, symbols, params));
+        };
+
+        Result<vector<Balance>> fetchBalances() const
+        {
+            auto params = payload("/v1/balances");
+            return fetchAuthenticated<vector<Balance>>(Endpoint::balances,
+                                                       params.str());
+        };
 
-        const string strResponse() const noexcept
-        { return Request.getLastResponse(); }
+        Result<Order> fetchOrderStatus(const long long &order_id) const
+        {
+            auto params = payload("/v1/order/status");
+            params.integer("order_id", order_id);
+            auto result = fetchAuthenticated<Order>(Endpoint::orderStatus,
+                                                    params.str());
+            trackOrder(Endpoint::orderStatus, order_id, result);
+            return result;
+        };
 
-        bool hasApiError()
+        Result<vector<Order>> fetchActiveOrders() const
         {
-            return (checkErrors() != noError || Request.hasError());
-        }
+            const auto requested = OrderCache::Clock::now();
+            auto params = payload("/v1/orders");
+            auto result = fetchAuthenticated<vector<Order>>(Endpoint::orders,
+                                                            params.str());
+            if (orderCache_ && result.bfxApiStatusCode == noError)
+                orderCache_->applySnapshot(result.data, requested);
+            return result;
+        };
 
-        // Setters
-        void setWDconfFilePath(const string &path) noexcept
-        { WDconfFilePath_ = path; }
+        // Refreshes order cache from /orders/ when it needsReconcile() or
+        // force is set, so that periodic calls poll only as often as the
+        // cache requires. No-op without order cache.
+        BfxClientErrors reconcileOrders(bool force = false) const
+        {
+            if (!orderCache_ || (!force && !orderCache_->needsReconcile()))
+                return noError;
+            return fetchActiveOrders().bfxApiStatusCode;
+        };
 
-        void setKeys(const string &accessKey, const string &secretKey) noexcept
+        Result<vector<Order>> fetchOrdersHistory(const unsigned &limit = 50) const
         {
-            Request.setAccessKey(accessKey);
-            Request.setSecretKey(secretKey);
-        }
+            auto params = payload("/v1/orders/hist");
+            params.integer("limit", limit);
+            return fetchAuthenticated<vector<Order>>(Endpoint::ordersHist,
+                                                     params.str());
+        };
 
-        ////////////////////////////////////////////////////////////////////////
-        // Public endpoints
-        ////////////////////////////////////////////////////////////////////////
+        // Same parameters as newOrder(), see also OrderGateway
+        Result<Order> fetchNewOrder(const string &symbol,
+                                    const double &amount,
+                                    const double &price,
+                                    const string &side,
+                                    const string &type,
+                                    const bool &is_hidden = false,
+                                    const bool &is_postonly = false) const
+        {
+            if (!knownSymbol(symbol))
+                return rejected<Order>("/order/new/", badSymbol);
+            if (!inArray(type, types_))
+                return rejected<Order>("/order/new/", badOrderType);
+
+            auto result = fetchAuthenticated<Order>(
+                Endpoint::orderNew,
+                newOrderPayload(symbol, symbols().pricePrecision(symbol),
+                                amount, price, side, type,
+                                is_hidden, is_postonly).str());
+            trackOrder(Endpoint::orderNew, 0, result);
+            return result;
+        };
 
-        BitfinexAPI& getTicker(const string &symbol)
+        // Interned symbol variant skips symbol check and precision lookup
+        // by name
+        Result<Order> fetchNewOrder(SymbolId symbol,
+                                    const double &amount,
+                                    const double &price,
+                                    const string &side,
+                                    const string &type,
+                                    const bool &is_hidden = false,
+                                    const bool &is_postonly = false) const
         {
-            if (!inArray(symbol, symbols_))
-                bfxApiStatusCode_ = badSymbol;
-            else
-                Request.get("/pubticker/" + symbol);
+            if (!symbol)
+                return rejected<Order>("/order/new/", badSymbol);
+            if (!inArray(type, types_))
+                return rejected<Order>("/order/new/", badOrderType);
+
+            auto result = fetchAuthenticated<Order>(
+                Endpoint::orderNew,
+                newOrderPayload(symbol.name(), symbols().pricePrecision(symbol),
+                                amount, price, side, type,
+                                is_hidden, is_postonly).str());
+            trackOrder(Endpoint::orderNew, 0, result);
+            return result;
+        };
 
-            return *this;
+        Result<Order> fetchCancelOrder(const long long &order_id) const
+        {
+            auto params = payload("/v1/order/cancel");
+            params.integer("order_id", order_id);
+            auto result = fetchAuthenticated<Order>(Endpoint::orderCancel,
+                                                    params.str());
+            trackOrder(Endpoint::orderCancel, order_id, result);
+            return result;
         };
 
-        BitfinexAPI& getStats(const string &symbol)
+        // Same parameters as replaceOrder()
+        Result<Order> fetchReplaceOrder(const long long &order_id,
+                                        const string &symbol,
+                                        const double &amount,
+                                        const double &price,
+                                        const string &side,
+                                        const string &type,
+                                        const bool &is_hidden = false,
+                                        const bool &use_remaining = false)
+        const
         {
-            if (!inArray(symbol, symbols_))
-                bfxApiStatusCode_ = badSymbol;
-            else
-                Request.get("/stats/" + symbol);
+            if (!knownSymbol(symbol))
+                return rejected<Order>("/order/cancel/replace/", badSymbol);
+            if (!inArray(type, types_))
+                return rejected<Order>("/order/cancel/replace/", badOrderType);
+
+            auto result = fetchAuthenticated<Order>(
+                Endpoint::orderCancelReplace,
+                replaceOrderPayload(order_id, symbol,
+                                    symbols().pricePrecision(symbol),
+                                    amount, price, side, type,
+                                    is_hidden, use_remaining).str());
+            trackOrder(Endpoint::orderCancelReplace, order_id, result);
+            return result;
+        };
 
-            return *this;
+        Result<Order> fetchReplaceOrder(const long long &order_id,
+                                        SymbolId symbol,
+                                        const double &amount,
+                                        const double &price,
+                                        const string &side,
+                                        const string &type,
+                                        const bool &is_hidden = false,
+                                        const bool &use_remaining = false)
+        const
+        {
+            if (!symbol)
+                return rejected<Order>("/order/cancel/replace/", badSymbol);
+            if (!inArray(type, types_))
+                return rejected<Order>("/order/cancel/replace/", badOrderType);
+
+            auto result = fetchAuthenticated<Order>(
+                Endpoint::orderCancelReplace,
+                replaceOrderPayload(order_id, symbol.name(),
+                                    symbols().pricePrecision(symbol),
+                                    amount, price, side, type,
+                                    is_hidden, use_remaining).str());
+            trackOrder(Endpoint::orderCancelReplace, order_id, result);
+            return result;
         };
 
-        BitfinexAPI& getFundingBook(const string &currency,
-                                    const unsigned &limit_bids = 50,
-                                    const unsigned &limit_asks = 50)
+        // History endpoints as ranges of decoded records, newest first, see
+        // HistoryRange. until 0 means now, times are in seconds. Pages are
+        // fetched while previous ones are consumed.
+        HistoryRange<BalanceHistoryEntry> fetchBalanceHistory(
+            const string &currency,
+            const time_t &since = 0,
+            const time_t &until = 0,
+            const unsigned &limit = 500,
+            const string &walletType = "all") const
         {
-            if (!inArray(currency, currencies_))
-                bfxApiStatusCode_ = badCurrency;
-            else
+            using Range = HistoryRange<BalanceHistoryEntry>;
+            if (!currencies().contains(currency))
+                return Range(badCurrency);
+            if (walletType != "all" && !inArray(walletType, walletNames_))
+                return Range(badWalletType);
+
+            return Range([this, currency, since, limit, walletType]
+                         (time_t pageUntil, vector<BalanceHistoryEntry> &page)
             {
-                map<string, string> params;
-                params["limit_bids"] = to_string(limit_bids);
-                params["limit_asks"] = to_string(limit_asks);
-                Request.get("/lendbook/" + currency, params);
-            }
-
-            return *this;
+                auto params = payload("/v1/history");
+                params.text("currency", currency);
+                params.quotedInteger("since", since);
+                params.quotedInteger("until", pageUntil);
+                params.integer("limit", limit);
+                if (walletType != "all")
+                    params.text("wallet", walletType);
+                return fetchPage(Endpoint::history, params, page);
+            }, since, until, limit);
         };
 
-        BitfinexAPI& getOrderBook(const string &symbol,
-                                  const unsigned &limit_bids = 50,
-                                  const unsigned &limit_asks = 50,
-                                  const bool &group = true)
+        HistoryRange<Movement> fetchWithdrawalHistory(
+            const string &currency,
+            const string &method = "all",
+            const time_t &since = 0,
+            const time_t &until = 0,
+            const unsigned &limit = 500) const
         {
-            if (!inArray(symbol, symbols_))
-                bfxApiStatusCode_ = badSymbol;
-            else
+            using Range = HistoryRange<Movement>;
+            if (!currencies().contains(currency))
+                return Range(badCurrency);
+            if (!inArray(method, methods_) && method != "wire" &&
+                method != "all")
+                return Range(badDepositMethod);
+
+            return Range([this, currency, method, since, limit]
+                         (time_t pageUntil, vector<Movement> &page)
             {
-                map<string, string> params;
-                params["limit_bids"] = to_string(limit_bids);
-                params["limit_asks"] = to_string(limit_asks);
-                params["group"]      = to_string(group);
-                Request.get("/book/" + symbol, params);
-            }
-
-            return *this;
+                auto params = payload("/v1/history/movements");
+                params.text("currency", currency);
+                if (method != "all")
+                    params.text("method", method);
+                params.quotedInteger("since", since);
+                params.quotedInteger("until", pageUntil);
+                params.integer("limit", limit);
+                return fetchPage(Endpoint::historyMovements, params, page);
+            }, since, until, limit);
         };
 
-        BitfinexAPI& getTrades(const string &symbol,
-                               const time_t &since = 0,
-                               const unsigned &limit_trades = 50)
+        HistoryRange<PastTrade> fetchPastTrades(const string &symbol,
+                                                const time_t &since = 0,
+                                                const time_t &until = 0,
+                                                const unsigned &limit = 500)
+        const
         {
-            if (!inArray(symbol, symbols_))
-                bfxApiStatusCode_ = badSymbol;
-            else
-            {
-                map<string, string> params;
-                params["timestamp"]    = to_string(since);
-                params["limit_trades"] = to_string(limit_trades);
-                Request.get("/trades/" + symbol, params);
-            }
+            using Range = HistoryRange<PastTrade>;
+            if (!knownSymbol(symbol))
+                return Range(badSymbol);
 
-            return *this;
+            return Range([this, symbol, since, limit]
+                         (time_t pageUntil, vector<PastTrade> &page)
+            {
+                auto params = payload("/v1/mytrades");
+                params.text("symbol", symbol);
+                params.quotedInteger("timestamp", since);
+                params.quotedInteger("until", pageUntil);
+                params.integer("limit_trades", limit);
+                return fetchPage(Endpoint::mytrades, params, page);
+            }, since, until, limit);
         };
 
-        BitfinexAPI& getLends(const string &currency,
-                              const time_t &since = 0,
-                              const unsigned &limit_lends = 50)
+        // /mytrades_funding/ has no since parameter, older trades are
+        // dropped client side
+        HistoryRange<FundingTrade> fetchPastFundingTrades(
+            const string &currency,
+            const time_t &since = 0,
+            const time_t &until = 0,
+            const unsigned &limit = 50) const
         {
-            if (!inArray(currency, currencies_))
-                bfxApiStatusCode_ = badCurrency;
-            else
-            {
-                map<string, string> params;
-                params["timestamp"]   = to_string(since);
-                params["limit_lends"] = to_string(limit_lends);
-                Request.get("/lends/" + currency, params);
-            }
+            using Range = HistoryRange<FundingTrade>;
+            if (!currencies().contains(currency))
+                return Range(badCurrency);
 
-            return *this;
+            return Range([this, currency, limit]
+                         (time_t pageUntil, vector<FundingTrade> &page)
+            {
+                auto params = payload("/v1/mytrades_funding");
+                params.text("symbol", currency);
+                params.integer("until", pageUntil);
+                params.integer("limit_trades", limit);
+                return fetchPage(Endpoint::mytradesFunding, params, page);
+            }, since, until, limit);
         };
 
-        BitfinexAPI& getSymbols()
+        // Submits any number of orders as /order/new/multi/ requests of at
+        // most chunkSize orders, up to concurrency of them in flight under
+        // the rate limiter. Orders with unknown symbol or type are rejected
+        // locally, the rest keep their relative order within chunks.
+        BulkOrdersResult fetchNewOrdersBulk(const vOrders &orders,
+                                            size_t chunkSize =
+                                                MULTI_ORDER_CHUNK,
+                                            unsigned concurrency =
+                                                BULK_CONCURRENCY) const
         {
-            Request.get("/symbols/");
+            BulkOrdersResult result;
+            result.status.resize(orders.size(), noError);
+            result.orders.resize(orders.size());
+            vector<size_t> accepted;
+            for (size_t i = 0; i < orders.size(); ++i)
+            {
+                if (!knownSymbol(orders[i].symbol))
+                    result.status[i] = badSymbol;
+                else if (!inArray(orders[i].type, types_))
+                    result.status[i] = badOrderType;
+                else
+                    accepted.push_back(i);
+            }
 
-            return *this;
+            const auto bounds = splitChunks(accepted.size(), chunkSize);
+            result.chunks.resize(bounds.size() - 1);
+            sendChunks(result.chunks, concurrency,
+                       [this, &orders, &accepted, &bounds]
+                       (size_t chunk, Result<NewOrders> &response)
+            {
+                auto params = payload("/v1/order/new/multi");
+                writeOrders(params, orders, accepted.begin() + bounds[chunk],
+                            accepted.begin() + bounds[chunk + 1]);
+                response.endpoint = Endpoint::orderNewMulti;
+                Request.performSigned(response, "/order/new/multi/",
+                                      params.str());
+            });
+
+            for (size_t chunk = 0; chunk < result.chunks.size(); ++chunk)
+            {
+                auto &response = result.chunks[chunk];
+                decodeResponse(response, response.data);
+                const BfxClientErrors code = chunkStatus(response);
+                const auto &placed = response.data.orders;
+                trackOrders(code, response.httpStatusCode, placed);
+                for (size_t j = bounds[chunk]; j < bounds[chunk + 1]; ++j)
+                {
+                    const size_t i = accepted[j];
+                    const size_t k = j - bounds[chunk];
+                    if (code != noError)
+                        result.status[i] = code;
+                    else if (k < placed.size())
+                        result.orders[i] = placed[k];
+                    else
+                        result.status[i] = responseSchemaError;
+                }
+            }
+            return result;
         };
 
-        BitfinexAPI& getSymbolsDetails()
+        // Cancels any number of orders as /order/cancel/multi/ requests of
+        // at most chunkSize ids, see fetchNewOrdersBulk()
+        BulkResult<HTTPResponse> fetchCancelOrdersBulk(const vIds &orderIds,
+                                                       size_t chunkSize =
+                                                           MULTI_ORDER_CHUNK,
+                                                       unsigned concurrency =
+                                                           BULK_CONCURRENCY)
+        const
         {
-            Request.get("/symbols_details/");
-
-            return *this;
+            BulkResult<HTTPResponse> result;
+            const auto bounds = splitChunks(orderIds.size(), chunkSize);
+            result.chunks.resize(bounds.size() - 1);
+            sendChunks(result.chunks, concurrency,
+                       [this, &orderIds, &bounds]
+                       (size_t chunk, HTTPResponse &response)
+            {
+                auto params = payload("/v1/order/cancel/multi");
+                params.beginArray("order_ids");
+                for (size_t i = bounds[chunk]; i < bounds[chunk + 1]; ++i)
+                    params.integer(orderIds[i]);
+                params.endArray();
+                response.endpoint = Endpoint::orderCancelMulti;
+                Request.performSigned(response, "/order/cancel/multi/",
+                                      params.str());
+            });
+
+            result.status.resize(orderIds.size(), noError);
+            for (size_t chunk = 0; chunk < result.chunks.size(); ++chunk)
+            {
+                auto &response = result.chunks[chunk];
+                checkResponse(response);
+                const BfxClientErrors code = chunkStatus(response);
+                trackCancels(code, response.httpStatusCode,
+                             orderIds.begin() + bounds[chunk],
+                             orderIds.begin() + bounds[chunk + 1]);
+                for (size_t i = bounds[chunk]; i < bounds[chunk + 1]; ++i)
+                    result.status[i] = code;
+            }
+            return result;
         };
 
         ////////////////////////////////////////////////////////////////////////
@@ -320,30 +1741,24 @@ namespace BfxAPI
         //  Account
         BitfinexAPI& getAccountInfo()
         {
-            string params = "{\"request\":\"/v1/account_infos\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/account_infos/", params);
+            auto params = payload("/v1/account_infos");
+            Request.post("/account_infos/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getAccountFees()
         {
-            string params = "{\"request\":\"/v1/account_fees\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/account_fees/", params);
+            auto params = payload("/v1/account_fees");
+            Request.post("/account_fees/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getSummary()
         {
-            string params = "{\"request\":\"/v1/summary\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/summary/", params);
+            auto params = payload("/v1/summary");
+            Request.post("/summary/", params.str());
 
             return *this;
         };
@@ -358,43 +1773,44 @@ namespace BfxAPI
             if (!inArray(walletName, walletNames_))
             { bfxApiStatusCode_ = badWalletType; return *this; }
 
-            string params = "{\"request\":\"/v1/deposit/new\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"method\":\"" + method + "\"";
-            params += ",\"wallet_name\":\"" + walletName + "\"";
-            params += ",\"renew\":" + to_string(renew);
-            params += "}";
-            Request.post("/deposit/new/", params);
+            auto params = payload("/v1/deposit/new");
+            params.text("method", method);
+            params.text("wallet_name", walletName);
+            params.integer("renew", renew);
+            Request.post("/deposit/new/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getKeyPermissions()
         {
-            string params = "{\"request\":\"/v1/key_info\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/key_info/", params);
+            auto params = payload("/v1/key_info");
+            Request.post("/key_info/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getMarginInfos()
         {
-            string params = "{\"request\":\"/v1/margin_infos\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/margin_infos/", params);
+            auto params = payload("/v1/margin_infos");
+            Request.post("/margin_infos/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getBalances()
         {
-            string params = "{\"request\":\"/v1/balances\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/balances/", params);
+            auto params = payload("/v1/balances");
+            Request.post("/balances/", params.str());
+
+            return *this;
+        };
+
+        BitfinexAPI& getBalances(vector<Balance> &balances)
+        {
+            bfxApiStatusCode_ = noError;
+            getBalances();
+            decodeLastResponse(balances);
 
             return *this;
         };
@@ -404,21 +1820,19 @@ namespace BfxAPI
                               const string &walletfrom,
                               const string &walletto)
         {
-            if (!inArray(currency, currencies_))
+            if (!currencies().contains(currency))
             { bfxApiStatusCode_ = badCurrency; return *this; }
 
             if (!inArray(walletfrom, walletNames_) ||
                 !inArray(walletto, walletNames_))
             { bfxApiStatusCode_ = badWalletType; return *this; }
 
-            string params = "{\"request\":\"/v1/transfer\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"amount\":\"" + to_string(amount) + "\"";
-            params += ",\"currency\":\"" + currency + "\"";
-            params += ",\"walletfrom\":\"" + walletfrom + "\"";
-            params += ",\"walletto\":\"" + walletto + "\"";
-            params += "}";
-            Request.post("/transfer/", params);
+            auto params = payload("/v1/transfer");
+            params.decimal("amount", amount);
+            params.text("currency", currency);
+            params.text("walletfrom", walletfrom);
+            params.text("walletto", walletto);
+            Request.post("/transfer/", params.str());
 
             return *this;
         };
@@ -426,17 +1840,17 @@ namespace BfxAPI
         // configure withdraw.conf file before use
         BitfinexAPI& withdraw()
         {
-            string params = "{\"request\":\"/v1/withdraw\",\"nonce\":\"" +
-            getTonce() + "\"";
+            auto params = payload("/v1/withdraw");
 
-            // Add params from withdraw.conf
-            BfxClientErrors code(parseWDconfParams(params));
+            // Add params from withdraw.conf, parsed again only after it
+            // changed
+            BfxClientErrors code(withdrawConfig_.load(methods_));
             if (code != noError)
                 bfxApiStatusCode_ = code;
             else
             {
-                params += "}";
-                Request.post("/withdraw/", params);
+                withdrawConfig_.request().write(params);
+                Request.post("/withdraw/", params.str());
             }
 
             return *this;
@@ -454,95 +1868,92 @@ namespace BfxAPI
                               const bool &ocoorder = false,
                               const double &buy_price_oco = 0)
         {
-            if (!inArray(symbol, symbols_))
+            if (!knownSymbol(symbol))
             { bfxApiStatusCode_ = badSymbol; return *this; };
 
             if (!inArray(type, types_))
             { bfxApiStatusCode_ = badOrderType; return *this; };
 
-            string params = "{\"request\":\"/v1/order/new\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"symbol\":\"" + symbol + "\"";
-            params += ",\"amount\":\"" + to_string(amount) + "\"";
-            params += ",\"price\":\"" + to_string(price) + "\"";
-            params += ",\"side\":\"" + side + "\"";
-            params += ",\"type\":\"" + type + "\"";
-            params += ",\"is_hidden\":" + bool2string(is_hidden);
-            params += ",\"is_postonly\":" + bool2string(is_postonly);
-            params += ",\"use_all_available\":" + bool2string(use_all_available);
-            params += ",\"ocoorder\":" + bool2string(ocoorder);
-            params += ",\"buy_price_oco\":" + bool2string(buy_price_oco);
-            params += "}";
-
-            Request.post("/order/new/", params);
+            auto params = payload("/v1/order/new");
+            params.text("symbol", symbol);
+            params.decimal("amount", amount);
+            params.decimal("price", price, symbols().pricePrecision(symbol));
+            params.text("side", side);
+            params.text("type", type);
+            params.boolean("is_hidden", is_hidden);
+            params.boolean("is_postonly", is_postonly);
+            params.boolean("use_all_available", use_all_available);
+            params.boolean("ocoorder", ocoorder);
+            params.boolean("buy_price_oco", buy_price_oco);
+
+            Request.post("/order/new/", params.str());
+            trackLastOrder(Endpoint::orderNew, 0);
             return *this;
         };
 
+        // Single request, see fetchNewOrdersBulk() for large order sets
         BitfinexAPI& newOrders(const vOrders &orders)
         {
-            string params = "{\"request\":\"/v1/order/new/multi\",\"nonce\":\""
-            + getTonce() + "\"";
-
-            // Get pointer to last element in orders. We will not place
-            // ',' character at the end of the last loop.
-            auto &last = *(--orders.cend());
-
-            params += ",\"payload\":[";
-            for (const auto &order : orders)
+            if (orders.empty())
+            { bfxApiStatusCode_ = requiredParamsMissing; return *this; }
+
+            vector<size_t> indices(orders.size());
+            for (size_t i = 0; i < indices.size(); ++i)
+                indices[i] = i;
+            auto params = payload("/v1/order/new/multi");
+            writeOrders(params, orders, indices.cbegin(), indices.cend());
+            Request.post("/order/new/multi/", params.str());
+            if (orderCache_)
             {
-                params += "{\"symbol\":\"" + order.symbol + "\"";
-                params += ",\"amount\":\"" + to_string(order.amount) + "\"";
-                params += ",\"price\":\"" + to_string(order.price) + "\"";
-                params += ",\"side\":\"" + order.side + "\"";
-                params += ",\"type\":\"" + order.type + "\"}";
-                if (&order != &last)
-                    params += ",";
+                NewOrders placed;
+                decodeLastResponse(placed);
+                trackOrders(bfxApiStatusCode_,
+                            Request.getLastHTTPStatusCode(), placed.orders);
             }
-            params += "]}";
-            Request.post("/order/new/multi/", params);
 
             return *this;
         };
 
         BitfinexAPI& cancelOrder(const long long &order_id)
         {
-            string params = "{\"request\":\"/v1/order/cancel\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"order_id\":" + to_string(order_id);
-            params += "}";
-            Request.post("/order/cancel/", params);
+            auto params = payload("/v1/order/cancel");
+            params.integer("order_id", order_id);
+            Request.post("/order/cancel/", params.str());
+            trackLastOrder(Endpoint::orderCancel, order_id);
 
             return *this;
         };
 
         BitfinexAPI& cancelOrders(const vIds &vOrderIds)
         {
-            string params = "{\"request\":\"/v1/order/cancel/multi\",\"nonce\":\""
-            + getTonce() + "\"";
+            if (vOrderIds.empty())
+            { bfxApiStatusCode_ = requiredParamsMissing; return *this; }
 
-            // Get pointer to last element in vOrders. We will not place
-            // ',' character at the end of the last loop.
-            auto &last = *(--vOrderIds.cend());
-
-            params += ", \"order_ids\":[";
+            auto params = payload("/v1/order/cancel/multi");
+            params.beginArray("order_ids");
             for (const auto &order_id : vOrderIds)
-            {
-                params += to_string(order_id);
-                if (&order_id != &last)
-                    params += ",";
-            }
-            params += "]}";
-            Request.post("/order/cancel/multi/", params);
+                params.integer(order_id);
+            params.endArray();
+            Request.post("/order/cancel/multi/", params.str());
+            if (orderCache_)
+                trackCancels(checkErrors(), Request.getLastHTTPStatusCode(),
+                             vOrderIds.begin(), vOrderIds.end());
 
             return *this;
         };
 
         BitfinexAPI& cancelAllOrders()
         {
-            string params = "{\"request\":\"/v1/order/cancel/all\",\"nonce\":\""
-            + getTonce() + "\"";
-            params += "}";
-            Request.post("/order/cancel/all/", params);
+            auto params = payload("/v1/order/cancel/all");
+            Request.post("/order/cancel/all/", params.str());
+            if (orderCache_)
+            {
+                const BfxClientErrors code = checkErrors();
+                if (code == noError)
+                    orderCache_->clear();
+                else if (unknownOutcome(code, Request.getLastHTTPStatusCode()))
+                    orderCache_->markGap();
+            }
 
             return *this;
         };
@@ -556,56 +1967,82 @@ namespace BfxAPI
                                   const bool &is_hidden = false,
                                   const bool &use_remaining = false)
         {
-            if (!inArray(symbol, symbols_))
+            if (!knownSymbol(symbol))
             { bfxApiStatusCode_ = badSymbol; return *this; };
 
             if (!inArray(type, types_))
             { bfxApiStatusCode_ = badOrderType; return *this; };
 
-            string params = "{\"request\":\"/v1/order/cancel/replace\",\"nonce\":\""
-            + getTonce() + "\"";
-            params += ",\"order_id\":" + to_string(order_id);
-            params += ",\"symbol\":\"" + symbol + "\"";
-            params += ",\"amount\":\"" + to_string(amount) + "\"";
-            params += ",\"price\":\"" + to_string(price) + "\"";
-            params += ",\"side\":\"" + side + "\"";
-            params += ",\"type\":\"" + type + "\"";
-            params += ",\"is_hidden\":" + bool2string(is_hidden);
-            params += ",\"use_all_available\":" + bool2string(use_remaining);
-            params += "}";
-            Request.post("/order/cancel/replace/", params);
+            auto params = payload("/v1/order/cancel/replace");
+            params.integer("order_id", order_id);
+            params.text("symbol", symbol);
+            params.decimal("amount", amount);
+            params.decimal("price", price, symbols().pricePrecision(symbol));
+            params.text("side", side);
+            params.text("type", type);
+            params.boolean("is_hidden", is_hidden);
+            params.boolean("use_all_available", use_remaining);
+            Request.post("/order/cancel/replace/", params.str());
+            trackLastOrder(Endpoint::orderCancelReplace, order_id);
 
             return *this;
         };
 
         BitfinexAPI& getOrderStatus(const long long &order_id)
         {
-            string params = "{\"request\":\"/v1/order/status\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"order_id\":" + to_string(order_id);
-            params += "}";
-            Request.post("/order/status/", params);
+            auto params = payload("/v1/order/status");
+            params.integer("order_id", order_id);
+            Request.post("/order/status/", params.str());
+
+            return *this;
+        };
+
+        BitfinexAPI& getOrderStatus(const long long &order_id, Order &order)
+        {
+            bfxApiStatusCode_ = noError;
+            getOrderStatus(order_id);
+            decodeLastResponse(order);
+            trackOrder(Endpoint::orderStatus, order_id, bfxApiStatusCode_,
+                       Request.getLastHTTPStatusCode(), order);
 
             return *this;
         };
 
         BitfinexAPI& getActiveOrders()
         {
-            string params = "{\"request\":\"/v1/orders\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/orders/", params);
+            auto params = payload("/v1/orders");
+            Request.post("/orders/", params.str());
+
+            return *this;
+        };
+
+        BitfinexAPI& getActiveOrders(vector<Order> &orders)
+        {
+            bfxApiStatusCode_ = noError;
+            const auto requested = OrderCache::Clock::now();
+            getActiveOrders();
+            decodeLastResponse(orders);
+            if (orderCache_ && bfxApiStatusCode_ == noError)
+                orderCache_->applySnapshot(orders, requested);
 
             return *this;
         };
 
         BitfinexAPI& getOrdersHistory(const unsigned &limit = 50)
         {
-            string params = "{\"request\":\"/v1/orders/hist\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"limit\":" + to_string(limit);
-            params += "}";
-            Request.post("/orders/hist/", params);
+            auto params = payload("/v1/orders/hist");
+            params.integer("limit", limit);
+            Request.post("/orders/hist/", params.str());
+
+            return *this;
+        };
+
+        BitfinexAPI& getOrdersHistory(vector<Order> &orders,
+                                      const unsigned &limit = 50)
+        {
+            bfxApiStatusCode_ = noError;
+            getOrdersHistory(limit);
+            decodeLastResponse(orders);
 
             return *this;
         };
@@ -614,10 +2051,8 @@ namespace BfxAPI
         //  Positions
         BitfinexAPI& getActivePositions()
         {
-            string params = "{\"request\":\"/v1/positions\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/positions/", params);
+            auto params = payload("/v1/positions");
+            Request.post("/positions/", params.str());
 
             return *this;
         };
@@ -625,12 +2060,10 @@ namespace BfxAPI
         BitfinexAPI& claimPosition(long long &position_id,
                                    const double &amount)
         {
-            string params = "{\"request\":\"/v1/position/claim\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"position_id\":" + to_string(position_id);
-            params += ",\"amount\":\"" + to_string(amount) + "\"";
-            params += "}";
-            Request.post("/position/claim/", params);
+            auto params = payload("/v1/position/claim");
+            params.integer("position_id", position_id);
+            params.decimal("amount", amount);
+            Request.post("/position/claim/", params.str());
 
             return *this;
         };
@@ -644,7 +2077,7 @@ namespace BfxAPI
                                        const string &walletType = "all")
         {
             // Is currency valid ?
-            if (!inArray(currency, currencies_))
+            if (!currencies().contains(currency))
             { bfxApiStatusCode_ = badCurrency; return *this; };
 
             // Is wallet type valid ?
@@ -654,17 +2087,14 @@ namespace BfxAPI
             if (!inArray(walletType, walletNames_) || walletType != "all")
             { bfxApiStatusCode_ = badWalletType; return *this; };
 
-            string params = "{\"request\":\"/v1/history\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"currency\":\"" + currency + "\"";
-            params += ",\"since\":\"" + to_string(since) + "\"";
-            params += ",\"until\":\"" + (!until ? getTonce() : to_string(until))
-            + "\"";
-            params += ",\"limit\":" + to_string(limit);
+            auto params = payload("/v1/history");
+            params.text("currency", currency);
+            params.quotedInteger("since", since);
+            params.quotedInteger("until", !until ? getTimestamp() : until);
+            params.integer("limit", limit);
             if (walletType != "all")
-                params += ",\"wallet\":\"" + walletType + "\"";
-            params += "}";
-            Request.post("/history/", params);
+                params.text("wallet", walletType);
+            Request.post("/history/", params.str());
 
             return *this;
         };
@@ -675,23 +2105,20 @@ namespace BfxAPI
                                           const time_t &until = 0,
                                           const unsigned &limit = 500)
         {
-            if (!inArray(currency, currencies_))
+            if (!currencies().contains(currency))
             { bfxApiStatusCode_ = badCurrency; return *this; };
 
             if (!inArray(method, methods_) && method != "wire" && method != "all")
             { bfxApiStatusCode_ = badDepositMethod; return *this; };
 
-            string params = "{\"request\":\"/v1/history/movements\",\"nonce\":\""
-            + getTonce() + "\"";
-            params += ",\"currency\":\"" + currency + "\"";
+            auto params = payload("/v1/history/movements");
+            params.text("currency", currency);
             if (method != "all")
-                params += ",\"method\":\"" + method + "\"";
-            params += ",\"since\":\"" + to_string(since) + "\"";
-            params += ",\"until\":\"" +
-            (!until ? getTonce() : to_string(until)) + "\"";
-            params += ",\"limit\":" + to_string(limit);
-            params += "}";
-            Request.post("/history/movements/", params);
+                params.text("method", method);
+            params.quotedInteger("since", since);
+            params.quotedInteger("until", !until ? getTimestamp() : until);
+            params.integer("limit", limit);
+            Request.post("/history/movements/", params.str());
 
             return *this;
         };
@@ -702,20 +2129,17 @@ namespace BfxAPI
                                    const unsigned &limit_trades = 500,
                                    const bool reverse = false)
         {
-            if (!inArray(symbol, symbols_))
+            if (!knownSymbol(symbol))
                 bfxApiStatusCode_ = badSymbol;
             else
             {
-                string params = "{\"request\":\"/v1/mytrades\",\"nonce\":\"" +
-                getTonce() + "\"";
-                params += ",\"symbol\":\"" + symbol + "\"";
-                params += ",\"timestamp\":\"" + to_string(timestamp) + "\"";
-                params += ",\"until\":\"" +
-                (!until ? getTonce() : to_string(until)) + "\"";
-                params += ",\"limit_trades\":" + to_string(limit_trades);
-                params += ",\"reverse\":" + to_string(reverse);
-                params += "}";
-                Request.post("/mytrades/", params);
+                auto params = payload("/v1/mytrades");
+                params.text("symbol", symbol);
+                params.quotedInteger("timestamp", timestamp);
+                params.quotedInteger("until", !until ? getTimestamp() : until);
+                params.integer("limit_trades", limit_trades);
+                params.integer("reverse", reverse);
+                Request.post("/mytrades/", params.str());
             }
 
             return *this;
@@ -728,19 +2152,17 @@ namespace BfxAPI
                               const unsigned &period,
                               const string &direction)
         {
-            if(!inArray(currency, currencies_))
+            if(!currencies().contains(currency))
                 bfxApiStatusCode_ = badCurrency;
             else
             {
-                string params = "{\"request\":\"/v1/offer/new\",\"nonce\":\"" +
-                getTonce() + "\"";
-                params += ",\"currency\":\"" + currency + "\"";
-                params += ",\"amount\":\"" + to_string(amount) + "\"";
-                params += ",\"rate\":\"" + to_string(rate) + "\"";
-                params += ",\"period\":" + to_string(period);
-                params += ",\"direction\":\"" + direction + "\"";
-                params += "}";
-                Request.post("/offer/new/", params);
+                auto params = payload("/v1/offer/new");
+                params.text("currency", currency);
+                params.decimal("amount", amount);
+                params.decimal("rate", rate);
+                params.integer("period", period);
+                params.text("direction", direction);
+                Request.post("/offer/new/", params.str());
             }
 
             return  *this;
@@ -748,53 +2170,43 @@ namespace BfxAPI
 
         BitfinexAPI& cancelOffer(const long long &offer_id)
         {
-            string params = "{\"request\":\"/v1/offer/cancel\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"offer_id\":" + to_string(offer_id);
-            params += "}";
-            Request.post("/offer/cancel/", params);
+            auto params = payload("/v1/offer/cancel");
+            params.integer("offer_id", offer_id);
+            Request.post("/offer/cancel/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getOfferStatus(const long long &offer_id)
         {
-            string params = "{\"request\":\"/v1/offer/status\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"offer_id\":" + to_string(offer_id);
-            params += "}";
-            Request.post("/offer/status/", params);
+            auto params = payload("/v1/offer/status");
+            params.integer("offer_id", offer_id);
+            Request.post("/offer/status/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getActiveCredits()
         {
-            string params = "{\"request\":\"/v1/credits\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/credits/", params);
+            auto params = payload("/v1/credits");
+            Request.post("/credits/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getOffers()
         {
-            string params = "{\"request\":\"/v1/offers\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/offers/", params);
+            auto params = payload("/v1/offers");
+            Request.post("/offers/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getOffersHistory(const unsigned &limit)
         {
-            string params = "{\"request\":\"/v1/offers/hist\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"limit\":" + to_string(limit);
-            params += "}";
-            Request.post("/offers/hist/", params);
+            auto params = payload("/v1/offers/hist");
+            params.integer("limit", limit);
+            Request.post("/offers/hist/", params.str());
 
             return *this;
         };
@@ -809,18 +2221,16 @@ namespace BfxAPI
                                           const unsigned &limit_trades = 50)
         {
             // Is currency valid ?
-            if(!inArray(currency, currencies_))
+            if(!currencies().contains(currency))
                 bfxApiStatusCode_ = badCurrency;
             else
             {
-                string params = "{\"request\":\"/v1/mytrades_funding\",\"nonce\":\""
-                + getTonce() + "\"";
+                auto params = payload("/v1/mytrades_funding");
                 // param inconsistency in BFX API, "symbol" should be currency
-                params += ",\"symbol\":\"" + currency + "\"";
-                params += ",\"until\":" + to_string(until);
-                params += ",\"limit_trades\":" + to_string(limit_trades);
-                params += "}";
-                Request.post("/mytrades_funding/", params);
+                params.text("symbol", currency);
+                params.integer("until", until);
+                params.integer("limit_trades", limit_trades);
+                Request.post("/mytrades_funding/", params.str());
             }
 
             return *this;
@@ -828,52 +2238,42 @@ namespace BfxAPI
 
         BitfinexAPI& getTakenFunds()
         {
-            string params = "{\"request\":\"/v1/taken_funds\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += "}";
-            Request.post("/taken_funds/", params);
+            auto params = payload("/v1/taken_funds");
+            Request.post("/taken_funds/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getUnusedTakenFunds()
         {
-            string params = "{\"request\":\"/v1/unused_taken_funds\",\"nonce\":\""
-            + getTonce() + "\"";
-            params += "}";
-            Request.post("/unused_taken_funds/", params);
+            auto params = payload("/v1/unused_taken_funds");
+            Request.post("/unused_taken_funds/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& getTotalTakenFunds()
         {
-            string params = "{\"request\":\"/v1/total_taken_funds\",\"nonce\":\""
-            + getTonce() + "\"";
-            params += "}";
-            Request.post("/total_taken_funds/", params);
+            auto params = payload("/v1/total_taken_funds");
+            Request.post("/total_taken_funds/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& closeLoan(const long long &offer_id)
         {
-            string params = "{\"request\":\"/v1/funding/close\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"swap_id\":" + to_string(offer_id);
-            params += "}";
-            Request.post("/funding/close/", params);
+            auto params = payload("/v1/funding/close");
+            params.integer("swap_id", offer_id);
+            Request.post("/funding/close/", params.str());
 
             return *this;
         };
 
         BitfinexAPI& closePosition(const long long &position_id)
         {
-            string params = "{\"request\":\"/v1/position/close\",\"nonce\":\"" +
-            getTonce() + "\"";
-            params += ",\"position_id\":" + to_string(position_id);
-            params += "}";
-            Request.post("/position/close/", params);
+            auto params = payload("/v1/position/close");
+            params.integer("position_id", position_id);
+            Request.post("/position/close/", params.str());
 
             return *this;
         };
@@ -884,121 +2284,503 @@ namespace BfxAPI
         // Private attributes
         ////////////////////////////////////////////////////////////////////////
 
+        // connections, schemas, symbols and currencies shared by sessions
+        std::shared_ptr<ClientContext> context_;
+        SymbolBootstrap symbolBootstrap_;
         // containers with supported parameters
-        unordered_set<string> symbols_; // valid symbol pairs
-        unordered_set<string> currencies_; // valid currencies
         unordered_set<string> methods_; // valid deposit methods
         unordered_set<string> walletNames_; // valid walletTypes
         unordered_set<string> types_; // valid Types (see new order endpoint)
+        bool insituParsing_ = false; // see setInsituParsing()
+        std::shared_ptr<CaptureWriter> capture_; // see setCaptureWriter()
+        std::shared_ptr<OrderCache> orderCache_; // see setOrderCache()
         // BitfinexAPI settings
-        string WDconfFilePath_;
-        // internal jsonutils instances
-        jsonutils::BfxSchemaValidator schemaValidator_;
+        WithdrawConfig withdrawConfig_;
         // internal HTTPRequest instance
         HTTPRequest Request;
+        // internal AsyncHTTPRequest instance
+        AsyncHTTPRequest AsyncRequest;
         // dynamic and status variables
         BfxClientErrors bfxApiStatusCode_;
+        // getResponseSerial() of response validated into bfxApiStatusCode_
+        unsigned long long checkedResponse_ = 0;
 
         ////////////////////////////////////////////////////////////////////////
         // Utility private methods
         ////////////////////////////////////////////////////////////////////////
 
-        BfxClientErrors parseWDconfParams(string &params)
-        {
-            using std::getline;
-            using std::ifstream;
-            using std::map;
-            using std::regex;
-            using std::regex_search;
-            using std::smatch;
+        BfxClientErrors checkErrors() {
+            long long micros = 0;
+            checkedResponse_ = Request.getResponseSerial();
+            bfxApiStatusCode_ = Request.hasError()
+                ? curlERR
+                : Request.getLastHTTPStatusCode() == HTTP_TOO_MANY_REQUESTS
+                ? rateLimitError
+                : timedValidation(findEndpoint(Request.getLastPath()), micros,
+                                  [this]
+                {
+                    return schemaValidator().validateSchema(
+                        Request.getLastPath(),
+                        Request.getLastResponse()
+                    );
+                });
+            return bfxApiStatusCode_;
+        }
 
-            string line;
-            map<string, string> mParams;
-            ifstream inFile(WDconfFilePath_, ifstream::in);
-            if (!inFile.is_open())
-            {
-                return badWDconfFilePath;
-            }
-            regex rgx("^(.*)\\b\\s*=\\s*(\"{0,1}.*\"{0,1})$");
-            smatch match;
+        // Requests of interned symbols use their precomputed paths
+        static vector<BatchRequest> batchRequests(
+            Endpoint endpoint,
+            const vector<SymbolId> &symbols,
+            const map<string, string> &params)
+        {
+            vector<BatchRequest> requests;
+            requests.reserve(symbols.size());
+            for (const auto symbol : symbols)
+                requests.push_back({endpoint,
+                                    symbol ? symbol.path(endpoint)
+                                           : endpointInfo(endpoint).path,
+                                    params,
+                                    symbol ? noError : badSymbol});
+            return requests;
+        };
 
-            // Create map with parameters
-            while (getline(inFile, line))
+        // Sends all requests concurrently on private AsyncHTTPRequest which
+        // shares connection pool with Request, then validates and decodes
+        // each response as it completes
+        template <typename T>
+        vector<Result<T>> fetchPublicBatch(const vector<BatchRequest> &requests)
+        const
+        {
+            vector<Result<T>> results(requests.size());
+            AsyncHTTPRequest batch(API_URL, Request.getSettings(),
+                                   Request.getPool());
+            batch.setRateLimiter(Request.getRateLimiter());
+            batch.setLatencyMetrics(Request.getLatencyMetrics());
+            batch.setTransport(Request.getTransport());
+
+            for (size_t i = 0; i < requests.size(); ++i)
             {
-                // Skip comments, blank lines ...
-                if (isalpha(line[0]))
+                const auto &request = requests[i];
+                if (request.status != noError)
                 {
-                    // ... and keys with empty values
-                    if (regex_search(line, match, rgx) && match[2] != "\"\"")
-                        mParams.emplace(match[1], match[2]);
+                    results[i].path = request.path;
+                    results[i].endpoint = request.endpoint;
+                    results[i].bfxApiStatusCode = request.status;
+                    continue;
                 }
-            }
 
-            // Check parameters
-            if (!mParams.count("withdraw_type") ||
-                !mParams.count("walletselected") ||
-                !mParams.count("amount"))
-            {
-                return requiredParamsMissing;
+                const Endpoint endpoint = request.endpoint;
+                batch.get(request.path, request.params,
+                          [this, &results, i, endpoint](HTTPResponse &response)
+                {
+                    Result<T> &result = results[i];
+                    static_cast<HTTPResponse&>(result) = std::move(response);
+                    result.endpoint = endpoint;
+                    if (decodeResponse(result, result.data) == noError)
+                        capture(endpoint, result.path, result.data);
+                });
             }
+            batch.run();
 
-            if (mParams["withdraw_type"] == "wire")
-            {
-                if (!mParams.count("account_number") ||
-                    !mParams.count("bank_name") ||
-                    !mParams.count("bank_address") ||
-                    !mParams.count("bank_city") ||
-                    !mParams.count("bank_country"))
+            return results;
+        }
+
+        // Validates and decodes last response into typed result in one pass
+        template <typename T>
+        void decodeLastResponse(T &out)
+        {
+            long long micros = 0;
+            checkedResponse_ = Request.getResponseSerial();
+            bfxApiStatusCode_ = Request.hasError()
+                ? curlERR
+                : Request.getLastHTTPStatusCode() == HTTP_TOO_MANY_REQUESTS
+                ? rateLimitError
+                : timedValidation(findEndpoint(Request.getLastPath()), micros,
+                                  [this, &out]
                 {
-                    return wireParamsMissing;
-                }
-            }
-            else if (inArray(mParams["withdraw_type"], methods_))
+                    return schemaValidator().decodeResponse(
+                        Request.getLastPath(),
+                        Request.getLastResponse(),
+                        out
+                    );
+                });
+            if (bfxApiStatusCode_ == noError)
+                capture(findEndpoint(Request.getLastPath()),
+                        Request.getLastPath(), out);
+        }
+
+        // Appends decoded trades and books to capture_, symbol is the path
+        // suffix after endpoint path
+        template <typename T>
+        void capture(Endpoint, const string &, const T &) const {}
+
+        void capture(Endpoint endpoint,
+                     const string &path,
+                     const vector<Trade> &trades) const
+        {
+            if (capture_ && endpoint == Endpoint::trades)
+                capture_->write(pathSuffix(endpoint, path), trades);
+        }
+
+        void capture(Endpoint endpoint,
+                     const string &path,
+                     const OrderBook &book) const
+        {
+            if (capture_ && endpoint == Endpoint::book)
+                capture_->write(pathSuffix(endpoint, path), book);
+        }
+
+        // Order request may have been executed when response didn't arrive
+        // or exchange failed while processing it
+        static bool unknownOutcome(BfxClientErrors code, long httpStatus)
+        noexcept
+        { return code == curlERR || httpStatus >= 500; }
+
+        // Applies order of order entry or status response to orderCache_,
+        // orderId is the order cancelled or replaced
+        void trackOrder(Endpoint endpoint,
+                        long long orderId,
+                        BfxClientErrors code,
+                        long httpStatus,
+                        const Order &order) const
+        {
+            if (!orderCache_)
+                return;
+            if (code != noError)
             {
-                if(!mParams.count("address"))
-                {
-                    return addressParamsMissing;
-                }
+                if (endpoint != Endpoint::orderStatus &&
+                    unknownOutcome(code, httpStatus))
+                    orderCache_->markGap();
+                return;
             }
+            if (endpoint == Endpoint::orderCancel)
+                orderCache_->remove(orderId);
+            else if (endpoint == Endpoint::orderCancelReplace)
+                orderCache_->replace(orderId, order);
+            else
+                orderCache_->apply(order);
+        }
 
-            // Create JSON string
+        void trackOrder(Endpoint endpoint,
+                        long long orderId,
+                        const Result<Order> &result) const
+        {
+            trackOrder(endpoint, orderId, result.bfxApiStatusCode,
+                       result.httpStatusCode, result.data);
+        }
+
+        // Decodes last fluent order entry response for orderCache_
+        void trackLastOrder(Endpoint endpoint, long long orderId)
+        {
+            if (!orderCache_)
+                return;
+            Order order;
+            decodeLastResponse(order);
+            trackOrder(endpoint, orderId, bfxApiStatusCode_,
+                       Request.getLastHTTPStatusCode(), order);
+        }
 
-            for (const auto &param : mParams)
+        void trackOrders(BfxClientErrors code,
+                         long httpStatus,
+                         const vector<Order> &placed) const
+        {
+            if (!orderCache_)
+                return;
+            if (code == noError)
             {
-                params += ",\"";
-                params += param.first;
-                params += "\":";
-                params += param.second;
+                for (const auto &order : placed)
+                    orderCache_->apply(order);
             }
+            else if (unknownOutcome(code, httpStatus))
+                orderCache_->markGap();
+        }
 
-            return noError;
-        };
+        template <typename Iterator>
+        void trackCancels(BfxClientErrors code,
+                          long httpStatus,
+                          Iterator first,
+                          Iterator last) const
+        {
+            if (!orderCache_)
+                return;
+            if (code == noError)
+            {
+                for (; first != last; ++first)
+                    orderCache_->remove(*first);
+            }
+            else if (unknownOutcome(code, httpStatus))
+                orderCache_->markGap();
+        }
 
-        BfxClientErrors checkErrors() {
-            bfxApiStatusCode_ = Request.hasError()
-                ? curlERR
-                : schemaValidator_.validateSchema(
-                    Request.getLastPath(),
-                    Request.getLastResponse()
-                );
-            return bfxApiStatusCode_;
+        // Runs validate (parse, validation and decoding are one pass),
+        // stores its duration into micros and latency metrics
+        template <typename Validate>
+        BfxClientErrors timedValidation(Endpoint endpoint,
+                                        long long &micros,
+                                        Validate validate) const
+        {
+            using std::chrono::duration_cast;
+            using std::chrono::microseconds;
+            using std::chrono::steady_clock;
+
+            const auto start = steady_clock::now();
+            const BfxClientErrors code = validate();
+            micros = duration_cast<microseconds>(
+                steady_clock::now() - start).count();
+            if (const auto &metrics = Request.getLatencyMetrics())
+                metrics->record(endpoint, LatencyPhase::validate, micros);
+            return code;
+        }
+
+        template <typename Validate>
+        BfxClientErrors timedValidation(HTTPResponse &response,
+                                        Validate validate) const
+        {
+            return timedValidation(apiEndPoint(response).id,
+                                   response.timings[LatencyPhase::validate],
+                                   validate);
         }
 
         ////////////////////////////////////////////////////////////////////////
         // Utility private static methods
         ////////////////////////////////////////////////////////////////////////
 
-        const static string bool2string(const bool &in) noexcept
-        { return in ? "true" : "false"; };
+        static jsonutils::ApiEndPoint apiEndPoint(const HTTPResponse &response)
+        noexcept
+        {
+            return response.endpoint != Endpoint::unknown
+                ? jsonutils::ApiEndPoint(response.endpoint, response.path)
+                : jsonutils::ApiEndPoint(response.path);
+        };
+
+        static void rejectAsync(const string &path,
+                                const BfxClientErrors &code,
+                                const AsyncCallback &callback)
+        {
+            HTTPResponse response;
+            response.path = path;
+            response.bfxApiStatusCode = code;
+            callback(response);
+        };
+
+        template <typename T>
+        static Result<T> rejected(const string &path,
+                                  const BfxClientErrors &code)
+        {
+            Result<T> result;
+            result.path = path;
+            result.bfxApiStatusCode = code;
+            return result;
+        };
+
+        static AsyncPromise makeAsyncPromise()
+        { return std::make_shared<std::promise<HTTPResponse>>(); };
+
+        static AsyncCallback fulfil(const AsyncPromise &promise)
+        {
+            return [promise](HTTPResponse &response)
+            { promise->set_value(std::move(response)); };
+        };
+
+        // Starts payload of authenticated request with strictly increasing
+        // nonce shared by all threads and instances
+        static PayloadWriter payload(const char *request)
+        { return PayloadWriter(request, NonceGenerator::instance().next()); };
+
+        // Payloads of order entry, symbol is checked by caller. Same
+        // buffer rules as payload().
+        static PayloadWriter newOrderPayload(const string &symbol,
+                                             int pricePrecision,
+                                             const double &amount,
+                                             const double &price,
+                                             const string &side,
+                                             const string &type,
+                                             const bool &is_hidden,
+                                             const bool &is_postonly)
+        {
+            auto params = payload("/v1/order/new");
+            params.text("symbol", symbol);
+            params.decimal("amount", amount);
+            params.decimal("price", price, pricePrecision);
+            params.text("side", side);
+            params.text("type", type);
+            params.boolean("is_hidden", is_hidden);
+            params.boolean("is_postonly", is_postonly);
+            return params;
+        };
+
+        static PayloadWriter replaceOrderPayload(const long long &order_id,
+                                                 const string &symbol,
+                                                 int pricePrecision,
+                                                 const double &amount,
+                                                 const double &price,
+                                                 const string &side,
+                                                 const string &type,
+                                                 const bool &is_hidden,
+                                                 const bool &use_remaining)
+        {
+            auto params = payload("/v1/order/cancel/replace");
+            params.integer("order_id", order_id);
+            params.text("symbol", symbol);
+            params.decimal("amount", amount);
+            params.decimal("price", price, pricePrecision);
+            params.text("side", side);
+            params.text("type", type);
+            params.boolean("is_hidden", is_hidden);
+            params.boolean("use_all_available", use_remaining);
+            return params;
+        };
 
-        static string getTonce() noexcept
+        // Current time used as default "until" value of history endpoints
+        static long long getTimestamp() noexcept
         {
             using namespace std::chrono;
 
             milliseconds ms =
             duration_cast<milliseconds>(system_clock::now().time_since_epoch());
 
-            return to_string(ms.count());
+            return ms.count();
+        };
+
+        // "payload" array of /order/new/multi/ with orders at indices
+        template <typename Iterator>
+        void writeOrders(PayloadWriter &params,
+                         const vOrders &orders,
+                         Iterator first,
+                         Iterator last) const
+        {
+            params.beginArray("payload");
+            for (; first != last; ++first)
+            {
+                const sOrder &order = orders[*first];
+                params.beginObject();
+                params.text("symbol", order.symbol);
+                params.decimal("amount", order.amount);
+                params.decimal("price", order.price,
+                               symbols().pricePrecision(order.symbol));
+                params.text("side", order.side);
+                params.text("type", order.type);
+                params.endObject();
+            }
+            params.endArray();
+        };
+
+        // Single page of HistoryRange
+        template <typename T>
+        BfxClientErrors fetchPage(Endpoint endpoint,
+                                  PayloadWriter &params,
+                                  vector<T> &page) const
+        {
+            auto result = fetchAuthenticated<vector<T>>(endpoint, params.str());
+            page = std::move(result.data);
+            return chunkStatus(result);
+        };
+
+        // Performs chunks on up to concurrency threads, the calling one
+        // included. send(i, response) signs and performs chunk i; chunks
+        // rejected for nonce are signed again with fresh nonce.
+        template <typename Response, typename Send>
+        void sendChunks(vector<Response> &chunks,
+                        unsigned concurrency,
+                        Send send) const
+        {
+            std::atomic<size_t> next{0};
+            auto worker = [&chunks, &next, &send]
+            {
+                for (size_t i = next++; i < chunks.size(); i = next++)
+                {
+                    unsigned attempt = 0;
+                    do
+                        send(i, chunks[i]);
+                    while (nonceRejected(chunks[i]) &&
+                           attempt++ < NONCE_RETRIES);
+                }
+            };
+
+            vector<std::thread> threads;
+            for (size_t t = 1; t < concurrency && t < chunks.size(); ++t)
+                threads.emplace_back(worker);
+            worker();
+            for (auto &thread : threads)
+                thread.join();
+        };
+
+        // Checks symbol against symbols of context, loading them first in
+        // lazy mode. Thread-safe, failed load is retried by the next check.
+        bool knownSymbol(const string &symbol) const
+        {
+            if (!symbols().loaded() && symbolBootstrap_ == SymbolBootstrap::none)
+                return !symbol.empty();
+            return loadedSymbols() && symbols().table().contains(symbol);
+        };
+
+        // Sessions of one context wait for the one fetching symbols
+        bool loadedSymbols() const
+        {
+            if (!symbols().loaded() && symbolBootstrap_ != SymbolBootstrap::none)
+            {
+                std::lock_guard<std::mutex> lock(symbols().bootstrapMutex());
+                if (!symbols().loaded())
+                    loadSymbols();
+            }
+            return symbols().loaded();
+        };
+
+        void loadSymbols() const
+        {
+            unordered_set<string> list;
+            const auto response = fetchPublic("/symbols/");
+            if (!response.hasError() &&
+                jsonutils::jsonStrToUset(list, response.body) == noError)
+                context_->getSymbols().setSymbols(list);
+        };
+
+        const SymbolMetadata& symbols() const noexcept
+        { return context_->getSymbols(); };
+
+        const CurrencyTable& currencies() const noexcept
+        { return context_->getCurrencies(); };
+
+        const jsonutils::BfxSchemaValidator& schemaValidator() const noexcept
+        { return context_->getSchemaValidator(); };
+
+        static string pathSuffix(Endpoint endpoint, const string &path)
+        {
+            const size_t prefix = std::strlen(endpointInfo(endpoint).path);
+            return path.size() > prefix ? path.substr(prefix) : string();
+        };
+
+        // Bounds of chunks of count items, chunk i is [bounds[i],
+        // bounds[i + 1])
+        static vector<size_t> splitChunks(size_t count, size_t chunkSize)
+        {
+            if (!chunkSize)
+                chunkSize = MULTI_ORDER_CHUNK;
+            vector<size_t> bounds;
+            for (size_t bound = 0; bound < count; bound += chunkSize)
+                bounds.push_back(bound);
+            bounds.push_back(count);
+            return bounds;
+        };
+
+        // Bitfinex rejects nonce not greater than the last one it has seen,
+        // which happens to concurrent requests arriving out of order
+        static bool nonceRejected(const HTTPResponse &response)
+        {
+            return response.curlStatusCode == CURLE_OK &&
+                response.httpStatusCode >= 400 &&
+                response.body.find("Nonce is too small") != string::npos;
+        };
+
+        // Status of bulk chunk or history page, error message instead of
+        // expected response is counted as schema error
+        static BfxClientErrors chunkStatus(const HTTPResponse &response)
+        {
+            if (response.bfxApiStatusCode != noError)
+                return response.bfxApiStatusCode;
+            return response.httpStatusCode >= 400
+                ? responseSchemaError
+                : noError;
         };
 
         static bool inArray(const string &value,
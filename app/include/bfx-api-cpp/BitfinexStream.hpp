@@ -0,0 +1,469 @@
+////////////////////////////////////////////////////////////////////////////////
+//  BitfinexStream.hpp
+//
+//
+//  Bitfinex WebSocket API v2 market data client
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// internal jsonutils
+#include "jsonutils.hpp"
+
+// internal error
+#include "error.hpp"
+
+// internal WebSocket
+#include "WebSocket.hpp"
+
+namespace BfxAPI
+{
+
+    /// Streaming counterpart of getTicker(), getOrderBook() and getTrades().
+    /// Subscribes to ticker, book and trades channels of the same symbols as
+    /// the REST API ("btcusd") and delivers every update decoded in a single
+    /// SAX pass into the REST typed structs. Callbacks are invoked from
+    /// poll()/run() of the owning thread; dropped connection is reopened and
+    /// subscriptions are restored by poll(). Only stop() may be called from
+    /// other threads.
+    class BitfinexStream
+    {
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        static constexpr auto WS_URL = "wss://api-pub.bitfinex.com/ws/2";
+        // Info event codes asking clients to reconnect
+        static constexpr long long INFO_RECONNECT = 20051;
+        static constexpr long long INFO_MAINTENANCE_END = 20061;
+        // conf event flag enabling book checksum messages
+        static constexpr long long FLAG_CHECKSUM = 131072;
+        // Delay between reconnection attempts
+        static constexpr long RECONNECT_DELAY_MS = 1000;
+
+    public:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Typedefs
+        ////////////////////////////////////////////////////////////////////////
+
+        using TickerCallback =
+        std::function<void(const string &symbol, const Ticker &ticker)>;
+        // Snapshot replaces whole book. Update level with zero amount
+        // removes price level, other amounts replace it.
+        using BookCallback =
+        std::function<void(const string &symbol,
+                           const OrderBook &book,
+                           bool snapshot)>;
+        // Signed CRC32 of best 25 levels sent after every book update, see
+        // LocalOrderBook::verify()
+        using ChecksumCallback =
+        std::function<void(const string &symbol, long long checksum)>;
+        using TradesCallback =
+        std::function<void(const string &symbol,
+                           const vector<Trade> &trades,
+                           bool snapshot)>;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor - Destructor
+        ////////////////////////////////////////////////////////////////////////
+
+        explicit BitfinexStream(const string &url = WS_URL,
+                                const HTTPSettings &settings = HTTPSettings()):
+        url_(url),
+        socket_(settings)
+        {}
+
+        BitfinexStream(const BitfinexStream&) = delete;
+        BitfinexStream& operator = (const BitfinexStream&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Accessors
+        ////////////////////////////////////////////////////////////////////////
+
+        bool isConnected() const noexcept { return socket_.isOpen(); }
+
+        CURLcode getCurlStatusCode() const noexcept
+        { return curlStatusCode_; }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Subscriptions
+        ////////////////////////////////////////////////////////////////////////
+
+        // Best bid/ask and daily statistics, updated on every trade
+        void subscribeTicker(const string &symbol, TickerCallback callback)
+        {
+            Subscription subscription("ticker", symbol);
+            subscription.onTicker = std::move(callback);
+            subscribe(std::move(subscription));
+        }
+
+        // precision is "P0" (most precise) to "P4" price aggregation, length
+        // is number of levels per side: 1, 25, 100 or 250. With onChecksum
+        // set, checksum messages are enabled for the whole connection.
+        void subscribeBook(const string &symbol,
+                           BookCallback callback,
+                           const string &precision = "P0",
+                           unsigned length = 25,
+                           ChecksumCallback onChecksum = nullptr)
+        {
+            Subscription subscription("book", symbol);
+            subscription.precision = precision;
+            subscription.length = length;
+            subscription.onBook = std::move(callback);
+            subscription.onChecksum = std::move(onChecksum);
+            subscribe(std::move(subscription));
+        }
+
+        void subscribeTrades(const string &symbol, TradesCallback callback)
+        {
+            Subscription subscription("trades", symbol);
+            subscription.onTrades = std::move(callback);
+            subscribe(std::move(subscription));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Event loop
+        ////////////////////////////////////////////////////////////////////////
+
+        // Opens connection and sends all subscriptions
+        BfxClientErrors connect()
+        {
+            channels_.clear();
+            checksums_ = false;
+            lastConnect_ = std::chrono::steady_clock::now();
+            curlStatusCode_ = socket_.open(url_);
+            if (curlStatusCode_ != CURLE_OK)
+                return curlERR;
+
+            for (const auto &subscription : subscriptions_)
+            {
+                if (sendSubscribe(subscription) != noError)
+                    return curlERR;
+            }
+            return noError;
+        }
+
+        // Dispatches received messages, waiting at most timeoutMs for them.
+        // Reconnects dropped connection at most once per second.
+        BfxClientErrors poll(int timeoutMs = 0)
+        {
+            if (!socket_.isOpen())
+            {
+                using std::chrono::duration_cast;
+                using std::chrono::milliseconds;
+                const long delayMs = RECONNECT_DELAY_MS;
+                const auto left = milliseconds(delayMs) - duration_cast<
+                    milliseconds>(std::chrono::steady_clock::now() -
+                                  lastConnect_);
+                if (left.count() > 0)
+                {
+                    if (timeoutMs > 0)
+                        std::this_thread::sleep_for(
+                            std::min(left, milliseconds(timeoutMs)));
+                    return curlERR;
+                }
+                const auto status = connect();
+                if (status != noError)
+                    return status;
+            }
+
+            BfxClientErrors status = noError;
+            curlStatusCode_ = socket_.poll(timeoutMs,
+                                           [this, &status](const string &json)
+            {
+                const auto messageStatus = dispatch(json);
+                if (messageStatus != noError)
+                    status = messageStatus;
+            });
+            return curlStatusCode_ != CURLE_OK ? curlERR : status;
+        }
+
+        // Runs poll() until stop() is called
+        void run()
+        {
+            stopped_ = false;
+            while (!stopped_)
+                poll(100);
+        }
+
+        void stop() noexcept { stopped_ = true; }
+
+        void close()
+        {
+            socket_.close();
+            channels_.clear();
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        struct Subscription
+        {
+            Subscription(const string &inChannel, const string &inSymbol):
+            channel(inChannel),
+            symbol(inSymbol),
+            pair(toPair(inSymbol))
+            {}
+
+            string channel;
+            string symbol;      // as subscribed, e.g. "btcusd"
+            string pair;        // API v2 symbol, e.g. "tBTCUSD"
+            string precision;
+            unsigned length = 0;
+            TickerCallback onTicker;
+            BookCallback onBook;
+            ChecksumCallback onChecksum;
+            TradesCallback onTrades;
+        };
+
+        string url_;
+        WebSocket socket_;
+        CURLcode curlStatusCode_ = CURLE_OK;
+        std::atomic<bool> stopped_{false};
+        bool checksums_ = false; // conf event with FLAG_CHECKSUM sent
+        std::chrono::steady_clock::time_point lastConnect_;
+        vector<Subscription> subscriptions_;
+        // chanId of subscribed channel to subscriptions_ index
+        unordered_map<long long, size_t> channels_;
+        // Decoded message and typed updates, reused between messages
+        jsonutils::StreamFrame frame_;
+        jsonutils::ParseArena arena_;
+        Ticker ticker_;
+        OrderBook book_;
+        vector<Trade> trades_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        // "btcusd" -> "tBTCUSD", API v2 symbols are kept
+        static string toPair(const string &symbol)
+        {
+            if (!symbol.empty() && (symbol[0] == 't' || symbol[0] == 'f') &&
+                symbol.size() > 1 && std::isupper(symbol[1]))
+                return symbol;
+
+            string pair = "t";
+            for (const auto c : symbol)
+                pair.push_back(static_cast<char>(std::toupper(c)));
+            return pair;
+        }
+
+        static double now() noexcept
+        {
+            using namespace std::chrono;
+            return duration<double>(
+                system_clock::now().time_since_epoch()).count();
+        }
+
+        void subscribe(Subscription subscription)
+        {
+            subscriptions_.push_back(std::move(subscription));
+            if (socket_.isOpen())
+                sendSubscribe(subscriptions_.back());
+        }
+
+        BfxClientErrors sendSubscribe(const Subscription &subscription)
+        {
+            if (subscription.onChecksum && !checksums_)
+            {
+                const string conf = "{\"event\":\"conf\",\"flags\":" +
+                                    std::to_string(FLAG_CHECKSUM) + "}";
+                curlStatusCode_ = socket_.sendText(conf);
+                if (curlStatusCode_ != CURLE_OK)
+                    return curlERR;
+                checksums_ = true;
+            }
+
+            rj::StringBuffer sb;
+            rj::Writer<rj::StringBuffer> writer(sb);
+            writer.StartObject();
+            writer.Key("event");
+            writer.String("subscribe");
+            writer.Key("channel");
+            writer.String(subscription.channel.c_str());
+            writer.Key("symbol");
+            writer.String(subscription.pair.c_str());
+            if (subscription.channel == "book")
+            {
+                writer.Key("prec");
+                writer.String(subscription.precision.c_str());
+                writer.Key("len");
+                writer.String(std::to_string(subscription.length).c_str());
+            }
+            writer.EndObject();
+
+            curlStatusCode_ = socket_.sendText(sb.GetString());
+            return curlStatusCode_ == CURLE_OK ? noError : curlERR;
+        }
+
+        BfxClientErrors dispatch(const string &json)
+        {
+            if (!jsonutils::decodeStreamFrame(json, frame_, arena_))
+            {
+                cerr << "Invalid json - stream message:" << endl;
+                cerr << json << endl;
+                return responseParseError;
+            }
+
+            if (frame_.isEvent)
+                return dispatchEvent();
+
+            auto it = channels_.find(frame_.chanId);
+            // Heartbeats and channels of unknown subscriptions
+            if (it == channels_.end() || frame_.tag == "hb")
+                return noError;
+
+            const auto &subscription = subscriptions_[it->second];
+            if (subscription.onTicker)
+                dispatchTicker(subscription);
+            else if (subscription.onBook)
+                dispatchBook(subscription);
+            else if (subscription.onTrades)
+                dispatchTrades(subscription);
+            return noError;
+        }
+
+        BfxClientErrors dispatchEvent()
+        {
+            if (frame_.event == "subscribed")
+            {
+                for (size_t i = 0; i < subscriptions_.size(); ++i)
+                {
+                    const auto &subscription = subscriptions_[i];
+                    if (subscription.channel == frame_.channel &&
+                        subscription.pair == frame_.symbol &&
+                        (frame_.precision.empty() ||
+                         subscription.precision == frame_.precision))
+                    {
+                        bool taken = false;
+                        for (const auto &channel : channels_)
+                            taken = taken || channel.second == i;
+                        if (!taken)
+                        {
+                            channels_[frame_.chanId] = i;
+                            break;
+                        }
+                    }
+                }
+            }
+            else if (frame_.event == "error")
+            {
+                // Subscription rejected, typically unknown symbol
+                cerr << "Stream error " << frame_.code << ": "
+                     << frame_.message << endl;
+                return badSymbol;
+            }
+            else if (frame_.event == "info" &&
+                     (frame_.code == INFO_RECONNECT ||
+                      frame_.code == INFO_MAINTENANCE_END))
+            {
+                // Reconnected by next poll()
+                close();
+                lastConnect_ = std::chrono::steady_clock::time_point();
+            }
+            return noError;
+        }
+
+        // [BID, BID_SIZE, ASK, ASK_SIZE, DAILY_CHANGE, DAILY_CHANGE_RELATIVE,
+        //  LAST_PRICE, VOLUME, HIGH, LOW]
+        void dispatchTicker(const Subscription &subscription)
+        {
+            size_t width = 0;
+            if (!frame_.rows())
+                return;
+            const double *v = frame_.row(0, width);
+            if (width < 10)
+                return;
+
+            ticker_.bid = v[0];
+            ticker_.ask = v[2];
+            ticker_.mid = (v[0] + v[2]) / 2;
+            ticker_.lastPrice = v[6];
+            ticker_.volume = v[7];
+            ticker_.high = v[8];
+            ticker_.low = v[9];
+            ticker_.timestamp = now();
+            subscription.onTicker(subscription.symbol, ticker_);
+        }
+
+        // Levels [PRICE, COUNT, AMOUNT], positive amount is bid, zero count
+        // removes level
+        void dispatchBook(const Subscription &subscription)
+        {
+            if (frame_.tag == "cs")
+            {
+                if (subscription.onChecksum && !frame_.values.empty())
+                    subscription.onChecksum(
+                        subscription.symbol,
+                        static_cast<long long>(frame_.values[0]));
+                return;
+            }
+            if (!frame_.tag.empty())
+                return;
+
+            book_.bids.clear();
+            book_.asks.clear();
+            const double timestamp = now();
+            for (size_t i = 0; i < frame_.rows(); ++i)
+            {
+                size_t width = 0;
+                const double *v = frame_.row(i, width);
+                if (width < 3)
+                    continue;
+                auto &side = v[2] > 0 ? book_.bids : book_.asks;
+                side.push_back({v[0], v[1] ? std::fabs(v[2]) : 0, timestamp});
+            }
+            if (frame_.rows())
+                subscription.onBook(subscription.symbol, book_,
+                                    frame_.isSnapshot);
+        }
+
+        // Trades [ID, MTS, AMOUNT, PRICE], negative amount is sell. Updates
+        // are delivered on "te" (executed), duplicate "tu" is skipped.
+        void dispatchTrades(const Subscription &subscription)
+        {
+            if (!frame_.tag.empty() && frame_.tag != "te")
+                return;
+
+            trades_.clear();
+            for (size_t i = 0; i < frame_.rows(); ++i)
+            {
+                size_t width = 0;
+                const double *v = frame_.row(i, width);
+                if (width < 4)
+                    continue;
+                trades_.emplace_back();
+                auto &trade = trades_.back();
+                trade.tid = static_cast<long long>(v[0]);
+                trade.timestamp = v[1] / 1000;
+                trade.amount = std::fabs(v[2]);
+                trade.price = v[3];
+                trade.exchange = "bitfinex";
+                trade.type = v[2] < 0 ? "sell" : "buy";
+            }
+            if (!trades_.empty() || frame_.isSnapshot)
+                subscription.onTrades(subscription.symbol, trades_,
+                                      frame_.isSnapshot);
+        }
+    };
+}
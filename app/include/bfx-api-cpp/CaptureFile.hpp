@@ -0,0 +1,607 @@
+////////////////////////////////////////////////////////////////////////////////
+//  CaptureFile.hpp
+//
+//
+//  Bitfinex REST API C++ client - columnar capture of trades and order books
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// POSIX mmap
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// internal responses
+#include "responses.hpp"
+
+namespace BfxAPI
+{
+
+    /// Capture file layout, integers little endian:
+    ///   "BFXCAP1\n"
+    ///   blocks of
+    ///     u32 kind, u32 rows, u32 bids (book) or 0, u32 symbol length
+    ///     i64 capture time in microseconds since epoch
+    ///     u64 length of columns
+    ///     symbol, zero padded to 8 bytes
+    ///     columns, each u32 length followed by its bytes, zero padded to
+    ///     8 bytes at the end
+    /// Times are milliseconds, prices and amounts fixed point of
+    /// CAPTURE_SCALE. Trade columns: timestamp, tid and price delta encoded,
+    /// amount, buy side bitmap. Book columns, bids then asks: price delta
+    /// encoded, amount, timestamp delta encoded. Integers are zigzag LEB128
+    /// varints.
+    namespace capture
+    {
+
+        constexpr char MAGIC[] = "BFXCAP1\n";
+        constexpr size_t MAGIC_LENGTH = sizeof(MAGIC) - 1;
+        constexpr size_t BLOCK_HEADER_LENGTH = 32;
+        constexpr double CAPTURE_SCALE = 1e8;
+
+        enum class BlockKind: uint32_t
+        {
+            trades = 1,
+            book = 2
+        };
+
+        inline int64_t toFixed(double value) noexcept
+        { return static_cast<int64_t>(std::llround(value * CAPTURE_SCALE)); }
+
+        inline double fromFixed(int64_t value) noexcept
+        { return static_cast<double>(value) / CAPTURE_SCALE; }
+
+        inline int64_t toMillis(double seconds) noexcept
+        { return static_cast<int64_t>(std::llround(seconds * 1000)); }
+
+        inline void putUint(std::string &out, uint64_t value, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                out += static_cast<char>((value >> 8 * i) & 0xff);
+        }
+
+        inline uint64_t getUint(const uint8_t *in, size_t size) noexcept
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < size; ++i)
+                value |= uint64_t(in[i]) << 8 * i;
+            return value;
+        }
+
+        inline void putVarint(std::string &out, int64_t value)
+        {
+            uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^
+                static_cast<uint64_t>(value >> 63);
+            while (zigzag >= 0x80)
+            {
+                out += static_cast<char>(zigzag | 0x80);
+                zigzag >>= 7;
+            }
+            out += static_cast<char>(zigzag);
+        }
+
+        // Returns false on truncated varint
+        inline bool getVarint(const uint8_t *&in, const uint8_t *end,
+                              int64_t &value) noexcept
+        {
+            uint64_t zigzag = 0;
+            for (unsigned shift = 0; in < end && shift < 64; shift += 7)
+            {
+                const uint8_t byte = *in++;
+                zigzag |= uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                {
+                    value = static_cast<int64_t>(zigzag >> 1) ^
+                        -static_cast<int64_t>(zigzag & 1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline void pad(std::string &out)
+        {
+            while (out.size() % 8)
+                out += '\0';
+        }
+
+        inline size_t padded(size_t length) noexcept
+        { return (length + 7) / 8 * 8; }
+
+        // Offset of columns of block whose header is at offset, 0 when
+        // symbol or columns extend past length
+        inline size_t blockColumns(const uint8_t *header, size_t offset,
+                                   size_t length) noexcept
+        {
+            const size_t columns = offset + BLOCK_HEADER_LENGTH +
+                padded(getUint(header + 12, 4));
+            return columns > length || getUint(header + 24, 8) >
+                length - columns ? 0 : columns;
+        }
+
+    }
+
+    /// Decoded trades block, one vector per column
+    struct TradeColumns
+    {
+        std::vector<int64_t> timestamp;  // milliseconds since epoch
+        std::vector<int64_t> tid;
+        std::vector<double> price;
+        std::vector<double> amount;
+        std::vector<uint8_t> buy;        // 1 for buy, 0 for sell
+
+        size_t size() const noexcept { return tid.size(); }
+    };
+
+    /// Decoded order book block, rows [0, bids) are bids, the rest asks
+    struct BookColumns
+    {
+        size_t bids = 0;
+        std::vector<double> price;
+        std::vector<double> amount;
+        std::vector<int64_t> timestamp;  // milliseconds since epoch
+
+        size_t size() const noexcept { return price.size(); }
+    };
+
+    /// Appends decoded trades and order book snapshots to capture file.
+    /// Each write() is one block, flushed so that the file stays readable
+    /// while being written. Thread-safe.
+    class CaptureWriter
+    {
+
+    public:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        // Existing capture file is appended to, after its last complete
+        // block
+        explicit CaptureWriter(const std::string &path): path_(path)
+        {
+            if (!truncatePartialBlock())
+                return;
+            file_.open(path_, std::ios::binary | std::ios::app);
+            if (!file_.is_open())
+            {
+                std::cerr << "Unable to open capture file " << path_
+                          << std::endl;
+                return;
+            }
+            file_.seekp(0, std::ios::end);
+            if (file_.tellp() == 0)
+                file_.write(capture::MAGIC, capture::MAGIC_LENGTH);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Writing
+        ////////////////////////////////////////////////////////////////////////
+
+        void write(const std::string &symbol, const std::vector<Trade> &trades)
+        {
+            if (trades.empty())
+                return;
+            thread_local std::string columns, column;
+            columns.clear();
+
+            int64_t previous = 0;
+            column.clear();
+            for (const auto &trade : trades)
+            {
+                const int64_t value = capture::toMillis(trade.timestamp);
+                capture::putVarint(column, value - previous);
+                previous = value;
+            }
+            addColumn(columns, column);
+
+            previous = 0;
+            column.clear();
+            for (const auto &trade : trades)
+            {
+                capture::putVarint(column, trade.tid - previous);
+                previous = trade.tid;
+            }
+            addColumn(columns, column);
+
+            previous = 0;
+            column.clear();
+            for (const auto &trade : trades)
+            {
+                const int64_t value = capture::toFixed(trade.price);
+                capture::putVarint(column, value - previous);
+                previous = value;
+            }
+            addColumn(columns, column);
+
+            column.clear();
+            for (const auto &trade : trades)
+                capture::putVarint(column, capture::toFixed(trade.amount));
+            addColumn(columns, column);
+
+            column.assign((trades.size() + 7) / 8, '\0');
+            for (size_t i = 0; i < trades.size(); ++i)
+            {
+                if (trades[i].type == "buy")
+                    column[i / 8] = static_cast<char>(
+                        column[i / 8] | (1 << i % 8));
+            }
+            addColumn(columns, column);
+
+            writeBlock(capture::BlockKind::trades, symbol, trades.size(), 0,
+                       columns);
+        }
+
+        void write(const std::string &symbol, const OrderBook &book)
+        {
+            const size_t rows = book.bids.size() + book.asks.size();
+            if (!rows)
+                return;
+            thread_local std::string columns, column;
+            columns.clear();
+
+            int64_t previous = 0;
+            column.clear();
+            for (const auto *side : {&book.bids, &book.asks})
+            {
+                for (const auto &level : *side)
+                {
+                    const int64_t value = capture::toFixed(level.price);
+                    capture::putVarint(column, value - previous);
+                    previous = value;
+                }
+            }
+            addColumn(columns, column);
+
+            column.clear();
+            for (const auto *side : {&book.bids, &book.asks})
+            {
+                for (const auto &level : *side)
+                    capture::putVarint(column, capture::toFixed(level.amount));
+            }
+            addColumn(columns, column);
+
+            previous = 0;
+            column.clear();
+            for (const auto *side : {&book.bids, &book.asks})
+            {
+                for (const auto &level : *side)
+                {
+                    const int64_t value = capture::toMillis(level.timestamp);
+                    capture::putVarint(column, value - previous);
+                    previous = value;
+                }
+            }
+            addColumn(columns, column);
+
+            writeBlock(capture::BlockKind::book, symbol, rows,
+                       book.bids.size(), columns);
+        }
+
+        bool isOpen() const noexcept { return file_.is_open(); }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        std::string path_;
+        std::mutex mutex_;
+        std::ofstream file_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        // Cuts trailing partial block, e.g. of interrupted writer, so that
+        // blocks appended after it stay readable. False when file isn't
+        // capture file or can't be truncated.
+        bool truncatePartialBlock() const
+        {
+            std::ifstream in(path_, std::ios::binary | std::ios::ate);
+            if (!in.is_open())
+                return true;
+            const size_t length = static_cast<size_t>(in.tellg());
+            char magic[capture::MAGIC_LENGTH];
+            const size_t magicLength = std::min(length, sizeof magic);
+            in.seekg(0);
+            if (!in.read(magic, magicLength) ||
+                std::memcmp(magic, capture::MAGIC, magicLength))
+            {
+                std::cerr << path_ << " is not a capture file" << std::endl;
+                return false;
+            }
+
+            // Partial magic is written again
+            size_t end = 0;
+            uint8_t header[capture::BLOCK_HEADER_LENGTH];
+            if (magicLength == capture::MAGIC_LENGTH)
+                end = capture::padded(capture::MAGIC_LENGTH);
+            while (end && end + sizeof header <= length &&
+                   in.seekg(end) &&
+                   in.read(reinterpret_cast<char*>(header), sizeof header))
+            {
+                const size_t columns =
+                    capture::blockColumns(header, end, length);
+                if (!columns)
+                    break;
+                end = columns + capture::getUint(header + 24, 8);
+            }
+            in.close();
+
+            if (end == length ||
+                !::truncate(path_.c_str(), static_cast<off_t>(end)))
+                return true;
+            std::cerr << "Unable to truncate partial block of capture file "
+                      << path_ << std::endl;
+            return false;
+        }
+
+        static void addColumn(std::string &columns, const std::string &column)
+        {
+            capture::putUint(columns, column.size(), 4);
+            columns += column;
+        }
+
+        void writeBlock(capture::BlockKind kind,
+                        const std::string &symbol,
+                        size_t rows,
+                        size_t bids,
+                        std::string &columns)
+        {
+            using namespace std::chrono;
+
+            capture::pad(columns);
+            std::string header;
+            capture::putUint(header, static_cast<uint32_t>(kind), 4);
+            capture::putUint(header, rows, 4);
+            capture::putUint(header, bids, 4);
+            capture::putUint(header, symbol.size(), 4);
+            capture::putUint(header, static_cast<uint64_t>(
+                duration_cast<microseconds>(
+                    system_clock::now().time_since_epoch()).count()), 8);
+            capture::putUint(header, columns.size(), 8);
+            header += symbol;
+            capture::pad(header);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!file_.is_open())
+                return;
+            file_.write(header.data(), header.size());
+            file_.write(columns.data(), columns.size());
+            file_.flush();
+        }
+    };
+
+    /// Memory mapped capture file. Blocks are indexed on open by walking
+    /// their headers; columns are decoded on demand into caller owned
+    /// vectors, which keep their capacity between blocks. Truncated last
+    /// block, e.g. of a file still being written, is ignored. const methods
+    /// are thread-safe.
+    class CaptureReader
+    {
+
+    public:
+
+        struct Block
+        {
+            capture::BlockKind kind;
+            size_t rows;
+            size_t bids;
+            int64_t captureMicros;  // capture time since epoch
+            std::string symbol;
+            const uint8_t *columns;
+            size_t columnsLength;
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor - Destructor
+        ////////////////////////////////////////////////////////////////////////
+
+        explicit CaptureReader(const std::string &path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            struct stat info;
+            if (fd < 0 || ::fstat(fd, &info))
+            {
+                std::cerr << "Unable to open capture file " << path
+                          << std::endl;
+                if (fd >= 0)
+                    ::close(fd);
+                return;
+            }
+            length_ = static_cast<size_t>(info.st_size);
+            if (length_)
+            {
+                void *data = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE,
+                                    fd, 0);
+                if (data != MAP_FAILED)
+                {
+                    data_ = static_cast<const uint8_t*>(data);
+                    ::madvise(data, length_, MADV_SEQUENTIAL);
+                }
+            }
+            ::close(fd);
+
+            if (!data_ || length_ < capture::MAGIC_LENGTH ||
+                std::memcmp(data_, capture::MAGIC, capture::MAGIC_LENGTH))
+            {
+                std::cerr << path << " is not a capture file" << std::endl;
+                return;
+            }
+            index(path);
+        }
+
+        CaptureReader(const CaptureReader&) = delete;
+        CaptureReader& operator = (const CaptureReader&) = delete;
+
+        ~CaptureReader()
+        {
+            if (data_)
+                ::munmap(const_cast<uint8_t*>(data_), length_);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Reading
+        ////////////////////////////////////////////////////////////////////////
+
+        size_t size() const noexcept { return blocks_.size(); }
+
+        const Block& block(size_t i) const { return blocks_[i]; }
+
+        // False when block i isn't trades block or is corrupt
+        bool read(size_t i, TradeColumns &out) const
+        {
+            const Block &block = blocks_[i];
+            if (block.kind != capture::BlockKind::trades)
+                return false;
+            const uint8_t *in = block.columns;
+            const uint8_t *end = in + block.columnsLength;
+            const uint8_t *bitmap = nullptr;
+            return deltas(in, end, block.rows, out.timestamp) &&
+                deltas(in, end, block.rows, out.tid) &&
+                fixed(in, end, block.rows, true, out.price) &&
+                fixed(in, end, block.rows, false, out.amount) &&
+                column(in, end, (block.rows + 7) / 8, bitmap) &&
+                sides(bitmap, block.rows, out.buy);
+        }
+
+        // False when block i isn't book block or is corrupt
+        bool read(size_t i, BookColumns &out) const
+        {
+            const Block &block = blocks_[i];
+            if (block.kind != capture::BlockKind::book)
+                return false;
+            const uint8_t *in = block.columns;
+            const uint8_t *end = in + block.columnsLength;
+            out.bids = block.bids;
+            return fixed(in, end, block.rows, true, out.price) &&
+                fixed(in, end, block.rows, false, out.amount) &&
+                deltas(in, end, block.rows, out.timestamp);
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        const uint8_t *data_ = nullptr;
+        size_t length_ = 0;
+        std::vector<Block> blocks_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        void index(const std::string &path)
+        {
+            size_t offset = capture::padded(capture::MAGIC_LENGTH);
+            while (offset + capture::BLOCK_HEADER_LENGTH <= length_)
+            {
+                const uint8_t *header = data_ + offset;
+                Block block;
+                block.kind = static_cast<capture::BlockKind>(
+                    capture::getUint(header, 4));
+                block.rows = capture::getUint(header + 4, 4);
+                block.bids = capture::getUint(header + 8, 4);
+                const size_t symbolLength = capture::getUint(header + 12, 4);
+                block.captureMicros = static_cast<int64_t>(
+                    capture::getUint(header + 16, 8));
+                block.columnsLength = capture::getUint(header + 24, 8);
+
+                const size_t columns =
+                    capture::blockColumns(header, offset, length_);
+                if (!columns)
+                {
+                    std::cerr << "Truncated block ignored in " << path
+                              << std::endl;
+                    break;
+                }
+                block.symbol.assign(reinterpret_cast<const char*>(
+                    header + capture::BLOCK_HEADER_LENGTH), symbolLength);
+                block.columns = data_ + columns;
+                blocks_.push_back(std::move(block));
+                offset = columns + blocks_.back().columnsLength;
+            }
+        }
+
+        // Column bytes of given minimum length, in is moved past column and
+        // so bounds its data
+        static bool column(const uint8_t *&in, const uint8_t *end,
+                           size_t minLength, const uint8_t *&data) noexcept
+        {
+            if (end - in < 4)
+                return false;
+            const size_t length = capture::getUint(in, 4);
+            in += 4;
+            if (static_cast<size_t>(end - in) < length || length < minLength)
+                return false;
+            data = in;
+            in += length;
+            return true;
+        }
+
+        static bool deltas(const uint8_t *&in, const uint8_t *end,
+                           size_t rows, std::vector<int64_t> &out)
+        {
+            const uint8_t *data = nullptr;
+            if (!column(in, end, 0, data))
+                return false;
+            out.resize(rows);
+            int64_t value = 0, delta = 0;
+            for (size_t i = 0; i < rows; ++i)
+            {
+                if (!capture::getVarint(data, in, delta))
+                    return false;
+                value += delta;
+                out[i] = value;
+            }
+            return true;
+        }
+
+        static bool fixed(const uint8_t *&in, const uint8_t *end,
+                          size_t rows, bool deltaEncoded,
+                          std::vector<double> &out)
+        {
+            const uint8_t *data = nullptr;
+            if (!column(in, end, 0, data))
+                return false;
+            out.resize(rows);
+            int64_t value = 0, varint = 0;
+            for (size_t i = 0; i < rows; ++i)
+            {
+                if (!capture::getVarint(data, in, varint))
+                    return false;
+                value = deltaEncoded ? value + varint : varint;
+                out[i] = capture::fromFixed(value);
+            }
+            return true;
+        }
+
+        static bool sides(const uint8_t *bitmap, size_t rows,
+                          std::vector<uint8_t> &out)
+        {
+            out.resize(rows);
+            for (size_t i = 0; i < rows; ++i)
+                out[i] = (bitmap[i / 8] >> i % 8) & 1;
+            return true;
+        }
+    };
+}
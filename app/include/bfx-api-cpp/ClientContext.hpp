@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////////////
+//  ClientContext.hpp
+//
+//
+//  Bitfinex REST API C++ client - state shared by sessions of several
+//  accounts
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// internal ConnectionPool, HTTPSettings
+#include "ConnectionPool.hpp"
+
+// internal RateLimiter
+#include "RateLimiter.hpp"
+
+// internal LatencyMetrics
+#include "LatencyMetrics.hpp"
+
+// internal ResponseCache
+#include "ResponseCache.hpp"
+
+// internal SymbolTable, CurrencyTable
+#include "SymbolTable.hpp"
+
+// internal jsonutils
+#include "jsonutils.hpp"
+
+// internal SymbolDetails
+#include "responses.hpp"
+
+namespace BfxAPI
+{
+
+    /// Valid symbols and their price precisions. Symbol tables are never
+    /// modified: a different symbol list is swapped in by pointer and the
+    /// old table is kept, so ids and references held by other threads stay
+    /// valid for the lifetime of the instance. Precisions are immutable
+    /// snapshots freed when the last reader releases them. Setting the same
+    /// symbols or precisions again publishes nothing, so periodic refreshes
+    /// keep memory flat. Thread-safe.
+    class SymbolMetadata
+    {
+
+        // Precisions by name, also indexed by ids of current symbol table
+        struct Precisions
+        {
+            std::unordered_map<std::string, int> byName;
+            const SymbolTable *table = nullptr;
+            std::vector<int> byIndex;
+        };
+
+        using PrecisionsPtr = std::shared_ptr<const Precisions>;
+
+    public:
+
+        SymbolMetadata():
+        table_(&noSymbols()),
+        precisions_(std::make_shared<const Precisions>())
+        {}
+
+        SymbolMetadata(const SymbolMetadata&) = delete;
+        SymbolMetadata& operator = (const SymbolMetadata&) = delete;
+
+        // Current table, empty before symbols are set
+        const SymbolTable& table() const noexcept
+        { return *table_.load(std::memory_order_acquire); }
+
+        bool loaded() const noexcept
+        { return loaded_.load(std::memory_order_acquire); }
+
+        // symbols may be any container of strings
+        template <typename Container>
+        void setSymbols(const Container &symbols)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!sameSymbols(symbols))
+            {
+                tables_.emplace_back(new SymbolTable(symbols));
+                const SymbolTable *table = tables_.back().get();
+                publishPrecisions(std::unique_ptr<Precisions>(new Precisions{
+                    precisions()->byName, table, {}}));
+                table_.store(table, std::memory_order_release);
+            }
+            loaded_.store(true, std::memory_order_release);
+        }
+
+        // Significant digits of order prices, 0 when unknown
+        int pricePrecision(const std::string &symbol) const
+        { return precision(*precisions(), symbol); }
+
+        // Id of current table is one array read, ids of replaced tables
+        // fall back to lookup by name. symbol must be valid.
+        int pricePrecision(SymbolId symbol) const
+        {
+            const PrecisionsPtr precisions = this->precisions();
+            const uint32_t index = symbol.index();
+            if (index < precisions->byIndex.size() &&
+                precisions->table->at(index) == symbol)
+                return precisions->byIndex[index];
+            return precision(*precisions, symbol.name());
+        }
+
+        // Precisions of details are merged into the current ones
+        void setPricePrecisions(const std::vector<SymbolDetails> &details)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const PrecisionsPtr current = precisions();
+            std::unique_ptr<Precisions> next;
+            for (const auto &symbol : details)
+            {
+                const int digits = static_cast<int>(symbol.pricePrecision);
+                if (digits <= 0 ||
+                    (!next && precision(*current, symbol.pair) == digits))
+                    continue;
+                if (!next)
+                    next.reset(new Precisions{
+                        current->byName,
+                        table_.load(std::memory_order_relaxed), {}});
+                next->byName[symbol.pair] = digits;
+            }
+            if (next)
+                publishPrecisions(std::move(next));
+        }
+
+        // Held by the session fetching symbols, so that concurrent sessions
+        // wait for it instead of fetching them again
+        std::mutex& bootstrapMutex() const noexcept { return bootstrapMutex_; }
+
+    private:
+
+        std::atomic<const SymbolTable*> table_;
+        PrecisionsPtr precisions_;  // accessed with atomic_load/atomic_store
+        std::atomic<bool> loaded_{false};
+        std::vector<std::unique_ptr<const SymbolTable>> tables_;
+        std::mutex mutex_; // guards replacement of tables
+        mutable std::mutex bootstrapMutex_;
+
+        PrecisionsPtr precisions() const noexcept
+        { return std::atomic_load_explicit(&precisions_,
+                                           std::memory_order_acquire); }
+
+        static int precision(const Precisions &precisions,
+                             const std::string &symbol)
+        {
+            auto it = precisions.byName.find(symbol);
+            return it != precisions.byName.cend() ? it->second : 0;
+        }
+
+        // True when distinct symbols equal names of current table, mutex_
+        // must be held
+        template <typename Container>
+        bool sameSymbols(const Container &symbols) const
+        {
+            if (!loaded())
+                return false;
+            const SymbolTable &table = this->table();
+            std::vector<bool> seen(table.size(), false);
+            size_t distinct = 0;
+            for (const auto &symbol : symbols)
+            {
+                const SymbolId id = table.find(symbol);
+                if (!id)
+                    return false;
+                if (!seen[id.index()])
+                {
+                    seen[id.index()] = true;
+                    ++distinct;
+                }
+            }
+            return distinct == table.size();
+        }
+
+        // Indexes precisions by ids of their table, mutex_ must be held
+        void publishPrecisions(std::unique_ptr<Precisions> next)
+        {
+            const SymbolTable &table = *next->table;
+            next->byIndex.resize(table.size());
+            for (size_t i = 0; i < table.size(); ++i)
+                next->byIndex[i] = precision(*next, table.at(i).name());
+            std::atomic_store_explicit(&precisions_,
+                                       PrecisionsPtr(std::move(next)),
+                                       std::memory_order_release);
+        }
+
+        static const SymbolTable& noSymbols()
+        {
+            static const SymbolTable table;
+            return table;
+        }
+    };
+
+    /// Everything BitfinexAPI sessions of several accounts can share:
+    /// connection pool, rate limiter, latency metrics, response cache,
+    /// compiled schemas, currencies and symbol metadata. Sessions created
+    /// with BitfinexAPI(context, accessKey, secretKey) keep only their keys,
+    /// last response and curl handles created on first use, so /symbols/
+    /// is fetched and definitions.json is parsed once per context instead
+    /// of once per account. Setters take effect for sessions created
+    /// afterwards. Thread-safe otherwise.
+    class ClientContext
+    {
+
+    public:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        // Process-wide pool, rate limiter, metrics and cache by default, as
+        // used by standalone BitfinexAPI instances
+        explicit ClientContext(const HTTPSettings &settings = HTTPSettings()):
+        settings_(settings),
+        pool_(ConnectionPool::shared()),
+        limiter_(RateLimiter::shared()),
+        metrics_(LatencyMetrics::shared()),
+        cache_(ResponseCache::shared()),
+        currencies_(std::vector<std::string>
+        {
+            "BTG",
+            "DSH",
+            "ETC",
+            "ETP",
+            "EUR",
+            "GBP",
+            "IOT",
+            "JPY",
+            "LTC",
+            "NEO",
+            "OMG",
+            "SAN",
+            "USD",
+            "XMR",
+            "XRP",
+            "ZEC"
+        })
+        {}
+
+        static std::shared_ptr<ClientContext> create(
+            const HTTPSettings &settings = HTTPSettings())
+        { return std::make_shared<ClientContext>(settings); }
+
+        ClientContext(const ClientContext&) = delete;
+        ClientContext& operator = (const ClientContext&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Accessors
+        ////////////////////////////////////////////////////////////////////////
+
+        const HTTPSettings& getHTTPSettings() const noexcept
+        { return settings_; }
+
+        const std::shared_ptr<ConnectionPool>& getConnectionPool() const
+        noexcept
+        { return pool_; }
+
+        const std::shared_ptr<RateLimiter>& getRateLimiter() const noexcept
+        { return limiter_; }
+
+        const std::shared_ptr<LatencyMetrics>& getLatencyMetrics() const
+        noexcept
+        { return metrics_; }
+
+        const std::shared_ptr<ResponseCache>& getResponseCache() const
+        noexcept
+        { return cache_; }
+
+        // Validation modes set here apply to all sessions
+        jsonutils::BfxSchemaValidator& getSchemaValidator() noexcept
+        { return validator_; }
+
+        const jsonutils::BfxSchemaValidator& getSchemaValidator() const
+        noexcept
+        { return validator_; }
+
+        SymbolMetadata& getSymbols() noexcept { return symbols_; }
+
+        const SymbolMetadata& getSymbols() const noexcept { return symbols_; }
+
+        const CurrencyTable& getCurrencies() const noexcept
+        { return currencies_; }
+
+        void setHTTPSettings(const HTTPSettings &settings)
+        { settings_ = settings; }
+
+        void setConnectionPool(std::shared_ptr<ConnectionPool> pool) noexcept
+        { pool_ = std::move(pool); }
+
+        // nullptr disables client side rate limiting
+        void setRateLimiter(std::shared_ptr<RateLimiter> limiter) noexcept
+        { limiter_ = std::move(limiter); }
+
+        void setLatencyMetrics(std::shared_ptr<LatencyMetrics> metrics)
+        noexcept
+        { metrics_ = std::move(metrics); }
+
+        void setResponseCache(std::shared_ptr<ResponseCache> cache) noexcept
+        { cache_ = std::move(cache); }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        HTTPSettings settings_;
+        std::shared_ptr<ConnectionPool> pool_;
+        std::shared_ptr<RateLimiter> limiter_;
+        std::shared_ptr<LatencyMetrics> metrics_;
+        std::shared_ptr<ResponseCache> cache_;
+        jsonutils::BfxSchemaValidator validator_;
+        SymbolMetadata symbols_;
+        CurrencyTable currencies_;
+    };
+}
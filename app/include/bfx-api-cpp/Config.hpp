@@ -0,0 +1,30 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Config.hpp
+//
+//
+//  Bitfinex REST API C++ client - header-only or compiled library build
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// Header-only by default: every function is defined in headers.
+//
+// BFX_SEPARATE_COMPILATION (set on bfxapicpp target by BFX_COMPILED_LIBRARY
+// option of CMakeLists.txt) leaves heavy definitions out of including
+// translation units: schema compilation, HMAC signing and decoding of typed
+// responses (explicit instantiations of BFX_DECODED_RESPONSES). They are
+// compiled once into the library by src/bfxapicpp.cpp, which defines
+// BFX_IMPLEMENTATION before including headers.
+#if defined(BFX_SEPARATE_COMPILATION) && !defined(BFX_IMPLEMENTATION)
+#define BFX_HEADER_DEFINITIONS 0
+#else
+#define BFX_HEADER_DEFINITIONS 1
+#endif
+
+// Declares separately compiled functions, inline when header-only
+#ifdef BFX_SEPARATE_COMPILATION
+#define BFX_DECL
+#else
+#define BFX_DECL inline
+#endif
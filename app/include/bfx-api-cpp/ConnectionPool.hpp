@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+//  ConnectionPool.hpp
+//
+//
+//  Bitfinex REST API C++ client - persistent connection settings and pool
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+// curl
+#include <curl/curl.h>
+
+namespace BfxAPI {
+
+  // Connection settings applied to every curl easy handle of HTTPRequest
+  struct HTTPSettings {
+    long timeout = 30L;             // whole request timeout [s]
+    long connectTimeout = 10L;      // connect + TLS handshake timeout [s]
+    bool tcpKeepAlive = true;       // TCP keepalive probes
+    long tcpKeepIdle = 60L;         // idle time before first probe [s]
+    long tcpKeepInterval = 30L;     // interval between probes [s]
+    bool tcpNoDelay = true;         // disable Nagle's algorithm
+    long dnsCacheTimeout = 600L;    // DNS cache entry lifetime [s]
+    bool http2 = true;              // HTTP/2 over TLS with HTTP/1.1 fallback
+    long maxConnects = 8L;          // connections cached per easy handle
+    long maxHostConnections = 8L;   // connections per host of a multi handle
+    bool verbose = false;           // curl debug output
+  };
+
+  // Pool of TLS sessions and DNS entries shared between curl easy handles of
+  // one or more HTTPRequest instances. The pool is thread-safe, handles using
+  // it may run in different threads. Live connections are not shared: libcurl
+  // does not support one connection cache used by concurrently running
+  // threads, so every easy handle (or multi handle) keeps its own cache and
+  // warm connections are reused through the idle handles of HTTPRequest.
+  class ConnectionPool {
+
+    public:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Constructor / Destructor
+      ////////////////////////////////////////////////////////////////////////
+
+      ConnectionPool() {
+        share = curl_share_init();
+        if (share) {
+          curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockCallback);
+          curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+          curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+          curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+          curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        }
+      };
+
+      ~ConnectionPool() {
+        if (share)
+          curl_share_cleanup(share);
+      };
+
+      ConnectionPool(const ConnectionPool&) = delete;
+      ConnectionPool& operator = (const ConnectionPool&) = delete;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Public methods
+      ////////////////////////////////////////////////////////////////////////
+
+      // Applies settings and attaches handle to the pool
+      void setup(CURL *handle, const HTTPSettings &settings) const noexcept {
+        if (!handle)
+          return;
+
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT, settings.timeout);
+        curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT,
+                         settings.connectTimeout);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE,
+                         settings.tcpKeepAlive ? 1L : 0L);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, settings.tcpKeepIdle);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL,
+                         settings.tcpKeepInterval);
+        curl_easy_setopt(handle, CURLOPT_TCP_NODELAY,
+                         settings.tcpNoDelay ? 1L : 0L);
+        curl_easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT,
+                         settings.dnsCacheTimeout);
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION,
+                         settings.http2
+                           ? CURL_HTTP_VERSION_2TLS
+                           : CURL_HTTP_VERSION_1_1);
+        curl_easy_setopt(handle, CURLOPT_MAXCONNECTS, settings.maxConnects);
+        curl_easy_setopt(handle, CURLOPT_VERBOSE, settings.verbose ? 1L : 0L);
+        if (share)
+          curl_easy_setopt(handle, CURLOPT_SHARE, share);
+      }
+
+      // Default pool shared by all HTTPRequest instances of the process
+      static std::shared_ptr<ConnectionPool> shared() {
+        static const auto pool = std::make_shared<ConnectionPool>();
+        return pool;
+      }
+
+    private:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private properties
+      ////////////////////////////////////////////////////////////////////////
+
+      CURLSH *share;
+      std::mutex locks[CURL_LOCK_DATA_LAST];
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private methods
+      ////////////////////////////////////////////////////////////////////////
+
+      static void lockCallback(
+        CURL *,
+        curl_lock_data data,
+        curl_lock_access,
+        void *userp) noexcept
+      {
+        static_cast <ConnectionPool*>(userp)->locks[data].lock();
+      };
+
+      static void unlockCallback(
+        CURL *,
+        curl_lock_data data,
+        void *userp) noexcept
+      {
+        static_cast <ConnectionPool*>(userp)->locks[data].unlock();
+      };
+
+  };
+
+}
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Decimal.hpp
+//
+//
+//  Bitfinex REST API C++ client - fixed-point decimal prices and amounts
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// rapidjson Grisu2 shortest decimal digits
+#include "rapidjson/internal/dtoa.h"
+
+namespace BfxAPI
+{
+
+    /// Exact decimal value mantissa * 10^-scale. Conversion from double
+    /// starts from shortest decimal digits which round-trip to the same double
+    /// (Grisu2), so 0.1 stays 0.1 and 1.005 rounds to 1.01 rather than to
+    /// binary artefacts. Formatting is locale independent and never uses
+    /// exponent notation. Mantissa holds at most 18 digits, doubles of 10^18
+    /// and above, infinities and NaN can't be converted.
+    class Decimal
+    {
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        static constexpr int MAX_DIGITS = 18;
+
+    public:
+
+        // Decimal places accepted by Bitfinex for prices and amounts
+        static constexpr int MAX_SCALE = 8;
+        // Buffer size sufficient for write()
+        static constexpr size_t MAX_LENGTH = MAX_DIGITS + 4;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+        ////////////////////////////////////////////////////////////////////////
+
+        constexpr Decimal() noexcept: mantissa_(0), scale_(0) {}
+
+        constexpr Decimal(long long mantissa, int scale) noexcept:
+        mantissa_(mantissa),
+        scale_(scale)
+        {}
+
+        // value rounded half away from zero to decimals places, false when
+        // value can't be converted
+        static bool fromDouble(double value,
+                               Decimal &out,
+                               int decimals = MAX_SCALE) noexcept
+        { return round(value, 0, decimals, out); }
+
+        // value rounded to significant digits, but to at most decimals
+        // places, false when value can't be converted
+        static bool fromSignificant(double value,
+                                    int digits,
+                                    Decimal &out,
+                                    int decimals = MAX_SCALE) noexcept
+        { return round(value, digits, decimals, out); }
+
+        // As above, but zero when value can't be converted
+        static Decimal fromDouble(double value, int decimals = MAX_SCALE)
+        noexcept
+        {
+            Decimal out;
+            return fromDouble(value, out, decimals) ? out : Decimal();
+        }
+
+        static Decimal fromSignificant(double value,
+                                       int digits,
+                                       int decimals = MAX_SCALE) noexcept
+        {
+            Decimal out;
+            return fromSignificant(value, digits, out, decimals)
+                ? out
+                : Decimal();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Accessors
+        ////////////////////////////////////////////////////////////////////////
+
+        constexpr long long mantissa() const noexcept { return mantissa_; }
+        constexpr int scale() const noexcept { return scale_; }
+
+        double toDouble() const noexcept
+        { return static_cast<double>(mantissa_) / pow10(scale_); }
+
+        // Writes plain decimal without trailing zeros, e.g. "-0.00012345",
+        // into out of at least MAX_LENGTH chars. Returns end of written text.
+        char* write(char *out) const noexcept
+        {
+            char digits[MAX_DIGITS + 2];
+            unsigned long long m = mantissa_ < 0
+                ? 0ULL - static_cast<unsigned long long>(mantissa_)
+                : static_cast<unsigned long long>(mantissa_);
+            int scale = scale_;
+            while (scale > 0 && m % 10 == 0)
+            {
+                m /= 10;
+                --scale;
+            }
+
+            int length = 0;
+            do
+            {
+                digits[length++] = static_cast<char>('0' + m % 10);
+                m /= 10;
+            }
+            while (m);
+
+            if (mantissa_ < 0 && (length > 1 || digits[0] != '0'))
+                *out++ = '-';
+            if (length <= scale)
+            {
+                *out++ = '0';
+                *out++ = '.';
+                for (int i = length; i < scale; ++i)
+                    *out++ = '0';
+            }
+            for (int i = length - 1; i >= 0; --i)
+            {
+                *out++ = digits[i];
+                if (i == scale && i)
+                    *out++ = '.';
+            }
+            return out;
+        }
+
+    private:
+
+        long long mantissa_;
+        int scale_;
+
+        static long long pow10(int exponent) noexcept
+        {
+            long long result = 1;
+            while (exponent-- > 0)
+                result *= 10;
+            return result;
+        }
+
+        // Rounds shortest digits of value to significant digits (0 means all)
+        // and decimals places, whichever is coarser. False for non-finite
+        // value and for integer part longer than MAX_DIGITS.
+        static bool round(double value,
+                          int significant,
+                          int decimals,
+                          Decimal &out) noexcept
+        {
+            if (!std::isfinite(value))
+                return false;
+            if (value == 0.0)
+            {
+                out = Decimal();
+                return true;
+            }
+
+            const bool negative = value < 0;
+            char digits[MAX_DIGITS + 8];
+            int length, K;
+            rapidjson::internal::Grisu2(negative ? -value : value,
+                                        digits, &length, &K);
+            // value = 0.d1d2...dn * 10^kk
+            const int kk = length + K;
+            if (kk > MAX_DIGITS)
+                return false;
+
+            if (significant > 0)
+                decimals = std::min(decimals, significant - kk);
+            decimals = std::min(decimals, MAX_DIGITS - kk);
+
+            // Every rounded digit at or above 10^-decimals, none when value
+            // rounds to zero
+            const int keep = kk + decimals;
+            if (keep < 0)
+            {
+                out = Decimal();
+                return true;
+            }
+            long long mantissa = 0;
+            for (int i = 0; i < std::min(keep, length); ++i)
+                mantissa = mantissa * 10 + (digits[i] - '0');
+            if (keep < length && digits[keep] >= '5')
+                ++mantissa;
+            if (keep > length)
+                mantissa *= pow10(keep - length);
+
+            // Coarser than units, e.g. 123456 at 5 significant digits. At
+            // most kk digits, so mantissa stays in range.
+            int scale = decimals;
+            if (scale < 0)
+            {
+                mantissa *= pow10(-scale);
+                scale = 0;
+            }
+            out = Decimal(negative ? -mantissa : mantissa, scale);
+            return true;
+        }
+    };
+}
@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Endpoints.hpp
+//
+//
+//  Bitfinex REST API C++ client - compile-time table of v1 REST endpoints
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace BfxAPI
+{
+
+    /// Priority lanes of requests sharing one RateLimiter bucket, lower
+    /// value is served first
+    enum class RequestPriority
+    {
+        high = 0,   // order management
+        normal,     // everything else
+        low         // history polling
+    };
+
+    enum class HTTPMethod
+    {
+        get,
+        post
+    };
+
+    /// Bitfinex v1 REST endpoints, values index the endpoint table
+    enum class Endpoint
+    {
+        // Public, path followed by symbol or currency
+        pubticker,
+        stats,
+        book,
+        trades,
+        lendbook,
+        lends,
+        // Public
+        symbols,
+        symbolsDetails,
+        // Authenticated
+        accountInfos,
+        accountFees,
+        summary,
+        depositNew,
+        keyInfo,
+        marginInfos,
+        balances,
+        transfer,
+        withdraw,
+        orderNew,
+        orderNewMulti,
+        orderCancel,
+        orderCancelMulti,
+        orderCancelAll,
+        orderCancelReplace,
+        orderStatus,
+        orders,
+        ordersHist,
+        positions,
+        positionClaim,
+        history,
+        historyMovements,
+        mytrades,
+        offerNew,
+        offerCancel,
+        offerStatus,
+        credits,
+        offers,
+        offersHist,
+        mytradesFunding,
+        takenFunds,
+        unusedTakenFunds,
+        totalTakenFunds,
+        fundingClose,
+        positionClose,
+        // Paths not in the table, also count of endpoints
+        unknown
+    };
+
+    constexpr size_t ENDPOINT_COUNT = static_cast<size_t>(Endpoint::unknown);
+
+    // Endpoints followed by symbol or currency come first
+    constexpr size_t PARAMETERIZED_ENDPOINT_COUNT =
+        static_cast<size_t>(Endpoint::symbols);
+
+    /// Static description of endpoint
+    struct EndpointInfo
+    {
+        Endpoint id;
+        const char *path;           // e.g. "/book/"
+        const char *schema;         // definitions.json schema name
+        bool parameterized;         // path is followed by symbol or currency
+        const char *rateBucket;     // default RateLimiter bucket
+        RequestPriority priority;   // default RateLimiter lane
+    };
+
+    namespace detail
+    {
+        // Class template static member, so that the table has single
+        // definition in header-only library
+        template <typename Tag>
+        struct EndpointTable
+        {
+            static constexpr EndpointInfo entries[ENDPOINT_COUNT + 1] =
+            {
+                {Endpoint::pubticker, "/pubticker/", "pubticker",
+                 true, "pubticker", RequestPriority::normal},
+                {Endpoint::stats, "/stats/", "stats",
+                 true, "stats", RequestPriority::normal},
+                {Endpoint::book, "/book/", "book",
+                 true, "book", RequestPriority::normal},
+                {Endpoint::trades, "/trades/", "trades",
+                 true, "trades", RequestPriority::normal},
+                {Endpoint::lendbook, "/lendbook/", "lendbook",
+                 true, "lendbook", RequestPriority::normal},
+                {Endpoint::lends, "/lends/", "lends",
+                 true, "lends", RequestPriority::normal},
+                {Endpoint::symbols, "/symbols/", "symbols",
+                 false, "symbols", RequestPriority::normal},
+                {Endpoint::symbolsDetails, "/symbols_details/",
+                 "symbols_details",
+                 false, "symbols_details", RequestPriority::normal},
+                {Endpoint::accountInfos, "/account_infos/", "account_infos",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::accountFees, "/account_fees/", "account_fees",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::summary, "/summary/", "summary",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::depositNew, "/deposit/new/", "deposit_new",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::keyInfo, "/key_info/", "key_info",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::marginInfos, "/margin_infos/", "margin_infos",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::balances, "/balances/", "balances",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::transfer, "/transfer/", "transfer",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::withdraw, "/withdraw/", "withdraw",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::orderNew, "/order/new/", "order_new",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::orderNewMulti, "/order/new/multi/",
+                 "order_new_multi",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::orderCancel, "/order/cancel/", "order_cancel",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::orderCancelMulti, "/order/cancel/multi/",
+                 "order_cancel_multi",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::orderCancelAll, "/order/cancel/all/",
+                 "order_cancel_all",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::orderCancelReplace, "/order/cancel/replace/",
+                 "order_cancel_replace",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::orderStatus, "/order/status/", "order_status",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::orders, "/orders/", "orders",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::ordersHist, "/orders/hist/", "orders_hist",
+                 false, "authenticated", RequestPriority::low},
+                {Endpoint::positions, "/positions/", "positions",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::positionClaim, "/position/claim/", "position_claim",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::history, "/history/", "history",
+                 false, "authenticated", RequestPriority::low},
+                {Endpoint::historyMovements, "/history/movements/",
+                 "history_movements",
+                 false, "authenticated", RequestPriority::low},
+                {Endpoint::mytrades, "/mytrades/", "mytrades",
+                 false, "authenticated", RequestPriority::low},
+                {Endpoint::offerNew, "/offer/new/", "offer_new",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::offerCancel, "/offer/cancel/", "offer_cancel",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::offerStatus, "/offer/status/", "offer_status",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::credits, "/credits/", "credits",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::offers, "/offers/", "offers",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::offersHist, "/offers/hist/", "offers_hist",
+                 false, "authenticated", RequestPriority::low},
+                {Endpoint::mytradesFunding, "/mytrades_funding/",
+                 "mytrades_funding",
+                 false, "authenticated", RequestPriority::low},
+                {Endpoint::takenFunds, "/taken_funds/", "taken_funds",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::unusedTakenFunds, "/unused_taken_funds/",
+                 "unused_taken_funds",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::totalTakenFunds, "/total_taken_funds/",
+                 "total_taken_funds",
+                 false, "authenticated", RequestPriority::normal},
+                {Endpoint::fundingClose, "/funding/close/", "funding_close",
+                 false, "authenticated", RequestPriority::high},
+                {Endpoint::positionClose, "/position/close/", "position_close",
+                 false, "authenticated", RequestPriority::high},
+                // Unknown paths are validated against schema accepting any
+                // document and aren't rate limited by endpoint
+                {Endpoint::unknown, "", "",
+                 false, "", RequestPriority::normal}
+            };
+        };
+
+        template <typename Tag>
+        constexpr EndpointInfo EndpointTable<Tag>::entries[];
+
+        constexpr bool endpointTableOrdered(size_t i = 0)
+        {
+            return i > ENDPOINT_COUNT ||
+                   (static_cast<size_t>(EndpointTable<void>::entries[i].id)
+                    == i && endpointTableOrdered(i + 1));
+        }
+
+        constexpr bool endpointTableGrouped(size_t i = 0)
+        {
+            return i >= ENDPOINT_COUNT ||
+                   (EndpointTable<void>::entries[i].parameterized ==
+                    (i < PARAMETERIZED_ENDPOINT_COUNT) &&
+                    endpointTableGrouped(i + 1));
+        }
+
+        static_assert(endpointTableOrdered(),
+                      "Endpoint table entries must follow Endpoint order");
+        static_assert(endpointTableGrouped(),
+                      "Parameterized endpoints must come first");
+    }
+
+    /// O(1) lookup of endpoint description
+    constexpr const EndpointInfo& endpointInfo(Endpoint endpoint) noexcept
+    {
+        return detail::EndpointTable<void>::entries
+            [static_cast<size_t>(endpoint)];
+    }
+
+    /// Maps request path, e.g. "/book/btcusd", to endpoint. Parameterized
+    /// endpoints match path prefix followed by single non-empty segment,
+    /// others match whole path. No allocation.
+    inline Endpoint findEndpoint(const char *path, size_t length) noexcept
+    {
+        for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+        {
+            const EndpointInfo &info = detail::EndpointTable<void>::entries[i];
+            const size_t prefixLength = std::strlen(info.path);
+            if (length < prefixLength ||
+                std::memcmp(path, info.path, prefixLength))
+                continue;
+            if (!info.parameterized)
+            {
+                if (length == prefixLength)
+                    return info.id;
+            }
+            else if (length > prefixLength &&
+                     !std::memchr(path + prefixLength, '/',
+                                  length - prefixLength))
+                return info.id;
+        }
+        return Endpoint::unknown;
+    }
+
+    inline Endpoint findEndpoint(const std::string &path) noexcept
+    { return findEndpoint(path.data(), path.size()); }
+}
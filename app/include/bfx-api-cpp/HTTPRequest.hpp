@@ -22,36 +22,80 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <string>
+#include <utility>
+#include <vector>
 
 // curl
 #include <curl/curl.h>
 
-// cryptopp
-#include <cryptopp/base64.h>
-#include <cryptopp/hex.h>
-#include <cryptopp/hmac.h>
-#include <cryptopp/osrng.h>
+// internal error
+#include "error.hpp"
+
+// internal ConnectionPool
+#include "ConnectionPool.hpp"
+
+// internal HmacSigner
+#include "HmacSigner.hpp"
+
+// internal RateLimiter
+#include "RateLimiter.hpp"
+
+// internal Endpoint table
+#include "Endpoints.hpp"
+
+// internal LatencyMetrics
+#include "LatencyMetrics.hpp"
+
+// internal Transport
+#include "Transport.hpp"
 
+// internal RetryPolicy
+#include "RetryPolicy.hpp"
+
+// internal ResponseCache
+#include "ResponseCache.hpp"
+
+using std::cerr;
+using std::endl;
 using std::string;
 using std::map;
 
-// CRYPTOPP_NO_GLOBAL_BYTE signals byte is at CryptoPP::byte
-#ifdef CRYPTOPP_NO_GLOBAL_BYTE
-using CryptoPP::byte;
-#endif
-
 namespace BfxAPI {
 
+  // Self contained result of single HTTP request
+  struct HTTPResponse {
+    string path;
+    // Set by callers which know it, otherwise matched from path
+    Endpoint endpoint = Endpoint::unknown;
+    string body;
+    CURLcode curlStatusCode = CURLE_OK;
+    long httpStatusCode = 0;
+    BfxClientErrors bfxApiStatusCode = noError;
+    RequestTimings timings;
+
+    bool hasError() const noexcept {
+      return curlStatusCode != CURLE_OK || bfxApiStatusCode != noError;
+    }
+  };
+
   class HTTPRequest {
 
     ////////////////////////////////////////////////////////////////////////
     // Class constants
     ////////////////////////////////////////////////////////////////////////
     
-    static constexpr auto CURL_TIMEOUT = 30L;
-    static constexpr auto CURL_DEBUG_VERBOSE = 0L;
+    // Initial response buffer capacity. Buffer grows to the largest
+    // response seen (or announced by Content-Length) and keeps it.
+    static constexpr size_t RESPONSE_BUFFER_CAPACITY = 16 * 1024;
 
     public:
       
@@ -59,36 +103,53 @@ namespace BfxAPI {
       // Constructor / Destructor
       ////////////////////////////////////////////////////////////////////////
       
-      HTTPRequest(string inEndpoint) {
+      HTTPRequest(string inEndpoint,
+                  const HTTPSettings &inSettings = HTTPSettings(),
+                  std::shared_ptr<ConnectionPool> inPool =
+                    ConnectionPool::shared()):
+      pool(inPool) {
         endpoint = inEndpoint;
-        curlGET = curl_easy_init();
-        curlPOST = curl_easy_init();
+        response.reserve(RESPONSE_BUFFER_CAPACITY);
+        setSettings(inSettings);
       };
 
       ~HTTPRequest() {
         curl_easy_cleanup(curlGET);
         curl_easy_cleanup(curlPOST);
+        curl_slist_free_all(staticHeader);
+        for (auto handle : idleHandles)
+          curl_easy_cleanup(handle);
       };
 
       ////////////////////////////////////////////////////////////////////////
       // Public methods
       ////////////////////////////////////////////////////////////////////////
 
-      string get(string inPath, map<string, string> params = {}) {
-        response = "";
-        if (curlGET) {
+      const string& get(const string &inPath,
+                        const map<string, string> &params = {}) {
+        responseBuffer->clear();
+        ++responseSerial;
+        if (transport) {
+          path = inPath;
+          TransportRequest request;
+          request.path = inPath;
+          request.query = parseParams(params);
+          performLast(request);
+        } else if (lastRequestHandle(curlGET)) {
           path = inPath;
           string url = endpoint + path + "?" + parseParams(params);
 
-          setupHeader();
-          curl_easy_setopt(curlPOST, CURLOPT_HTTPHEADER, curlHeader);
-          curl_easy_setopt(curlGET, CURLOPT_TIMEOUT, CURL_TIMEOUT);
+          curl_easy_setopt(curlGET, CURLOPT_HTTPHEADER, staticHeader);
           curl_easy_setopt(curlGET, CURLOPT_URL, url.c_str());
-          curl_easy_setopt(curlGET, CURLOPT_VERBOSE, CURL_DEBUG_VERBOSE);
-          curl_easy_setopt(curlGET, CURLOPT_WRITEDATA, &response);
+          curl_easy_setopt(curlGET, CURLOPT_WRITEDATA, responseBuffer);
           curl_easy_setopt(curlGET, CURLOPT_WRITEFUNCTION, writeCallback);
+          curl_easy_setopt(curlGET, CURLOPT_HEADERDATA, responseBuffer);
+          curl_easy_setopt(curlGET, CURLOPT_HEADERFUNCTION, headerCallback);
 
-          curlStatusCode = curl_easy_perform(curlGET);
+          curlStatusCode = cachedGet(curlGET, *responseBuffer, path, url,
+                                     staticHeader, httpStatusCode,
+                                     lastTimings);
+          recordTimings(findEndpoint(path), lastTimings);
           // libcurl internal error handling
           if (curlStatusCode != CURLE_OK) {
             cerr << "libcurl error in Request.get():" << endl;
@@ -97,41 +158,51 @@ namespace BfxAPI {
         } else {
           cerr << "curl not properly initialized curlGET = nullptr";
         }
-        return response;
+        return *responseBuffer;
       };
 
-      string post(string inPath, string json = "") {
-        response = "";
-        if (curlPOST) {
+      const string& post(const string &inPath, const string &json = "") {
+        responseBuffer->clear();
+        ++responseSerial;
+        lastTimings.clear();
+        if (transport) {
+          path = inPath;
+          TransportRequest request;
+          request.method = HTTPMethod::post;
+          request.path = inPath;
+          request.payload = json;
+          performLast(request);
+        } else if (lastRequestHandle(curlPOST)) {
           path = inPath;
           string url = endpoint + path;
-          string payload;
-          getBase64(json, payload);
-
-          if (accessKey != "") {
-            header["X-BFX-APIKEY"] = accessKey;
-          }
-
-          if (secretKey != "") {
-            header["X-BFX-SIGNATURE"] = getSignature(payload);
+          string cacheKey;
+          if (cacheable(path)) {
+            cacheKey = signedCacheKey(url);
+            if (cacheHit(path, cacheKey, *responseBuffer, httpStatusCode)) {
+              curlStatusCode = CURLE_OK;
+              return *responseBuffer;
+            }
           }
 
-          if (payload != "") {
-           header["X-BFX-PAYLOAD"] = payload;
-          }
-
-          setupHeader();
-          curl_easy_setopt(curlPOST, CURLOPT_HTTPHEADER, curlHeader);
+          curl_easy_setopt(curlPOST, CURLOPT_HTTPHEADER,
+                           linkSignedHeader(signedHeader, json));
           curl_easy_setopt(curlPOST, CURLOPT_POST, 1);
           curl_easy_setopt(curlPOST, CURLOPT_POSTFIELDS, "\n");
-          curl_easy_setopt(curlPOST, CURLOPT_TIMEOUT, CURL_TIMEOUT);
           curl_easy_setopt(curlPOST, CURLOPT_URL, url.c_str());
-          curl_easy_setopt(curlPOST, CURLOPT_VERBOSE, CURL_DEBUG_VERBOSE);
-          curl_easy_setopt(curlPOST, CURLOPT_WRITEDATA, &response);
+          curl_easy_setopt(curlPOST, CURLOPT_WRITEDATA, responseBuffer);
           curl_easy_setopt(curlPOST, CURLOPT_WRITEFUNCTION, writeCallback);
+          curl_easy_setopt(curlPOST, CURLOPT_HEADERDATA, responseBuffer);
+          curl_easy_setopt(curlPOST, CURLOPT_HEADERFUNCTION, headerCallback);
 
+          if (limiter)
+            limiter->acquire(path);
           curlStatusCode = curl_easy_perform(curlPOST);
-          clearHeader();
+          curl_easy_getinfo(curlPOST, CURLINFO_RESPONSE_CODE, &httpStatusCode);
+          readTimings(curlPOST, lastTimings);
+          recordTimings(findEndpoint(path), lastTimings);
+          if (!cacheKey.empty() && curlStatusCode == CURLE_OK &&
+              httpStatusCode == 200)
+            cacheStore(cacheKey, *responseBuffer, false);
           // libcurl internal error handling
           if (curlStatusCode != CURLE_OK) {
             cerr << "libcurl error in Request.post():" << endl;
@@ -141,10 +212,85 @@ namespace BfxAPI {
           cerr << "curl not properly initialized curlPOST = nullptr";
         }
 
-        return response;
+        return *responseBuffer;
       };
 
-      string parseParams(map<string, string> params) {
+      ////////////////////////////////////////////////////////////////////////
+      // Thread-safe public methods
+      ////////////////////////////////////////////////////////////////////////
+
+      // perform() and performSigned() may be called concurrently from
+      // multiple threads. Each call borrows curl handle from internal pool
+      // and writes into caller owned response, no per-call state is kept in
+      // HTTPRequest. Keys must not be changed while calls are in flight.
+
+      void perform(HTTPResponse &out,
+                   const string &inPath,
+                   const map<string, string> &params = {}) const {
+        out.path = inPath;
+        TransportRequest request;
+        request.path = inPath;
+        request.query = parseParams(params);
+        perform(out, request);
+      };
+
+      void performSigned(HTTPResponse &out,
+                         const string &inPath,
+                         const string &json = "") const {
+        out.path = inPath;
+        TransportRequest request;
+        request.method = HTTPMethod::post;
+        request.path = inPath;
+        request.payload = json;
+        perform(out, request);
+      };
+
+      // Sends request through transport, libcurl when none is set
+      void perform(HTTPResponse &out, const TransportRequest &request) const {
+        out.path = request.path;
+        out.body.clear();
+        out.httpStatusCode = 0;
+        out.bfxApiStatusCode = noError;
+        out.timings.clear();
+        if (transport)
+          transport->perform(request, out);
+        else
+          performCurl(request, out);
+        recordTimings(out.endpoint != Endpoint::unknown
+                        ? out.endpoint
+                        : findEndpoint(out.path),
+                      out.timings);
+      };
+
+      // Header lines of signed POST request with json payload, e.g. for
+      // AsyncHTTPRequest::post()
+      std::vector<string> signedHeaderLines(const string &json) const {
+        SignedHeader lines;
+        std::vector<string> out;
+        for (auto node = linkSignedHeader(lines, json); node; node = node->next)
+          out.emplace_back(node->data);
+        return out;
+      };
+
+      // Requests are sent by transport instead of libcurl, nullptr restores
+      // libcurl. Transport is responsible for rate limiting, caching and
+      // retries, which HTTPRequest applies only to its own libcurl requests.
+      void setTransport(std::shared_ptr<Transport> inTransport) noexcept {
+        transport = std::move(inTransport);
+      }
+
+      const std::shared_ptr<Transport>& getTransport() const noexcept {
+        return transport;
+      }
+
+      // libcurl transport of this request with its keys, connection pool,
+      // rate limiter, cache and retries, e.g. to be wrapped by
+      // RecordingTransport. Must not outlive this HTTPRequest.
+      std::shared_ptr<Transport> curlTransport() const {
+        return std::make_shared<CurlTransport>(*this);
+      }
+
+      string parseParams(const map<string, string> &params) const {
         string pp = "";
         for (auto it = params.begin(); it != params.end(); it++) {
           pp += it->first + "=" + it->second + "&";
@@ -152,57 +298,137 @@ namespace BfxAPI {
         return pp;
       };
 
-      string getSignature(string payload) {
-        string signature;
-        getHmacSha384(secretKey, payload, signature);
+      string getSignature(const string &payload) const {
+        HmacSigner::Signature signature;
+        signer.sign(payload, signature);
         return signature;
       }
 
-      const CURLcode getLastStatusCode() const noexcept {
+      CURLcode getLastStatusCode() const noexcept {
         return curlStatusCode;
       }
 
-      const string getLastResponse() const noexcept {
-        return response;
+      long getLastHTTPStatusCode() const noexcept {
+        return httpStatusCode;
+      }
+
+      const string& getLastResponse() const noexcept {
+        return *responseBuffer;
       }
 
-      const string getLastPath() const noexcept {
+      const string& getLastPath() const noexcept {
         return path;
       }
 
-      const bool hasError() const noexcept {
+      // Timings of last get() or post()
+      const RequestTimings& getLastTimings() const noexcept {
+        return lastTimings;
+      }
+
+      bool hasError() const noexcept {
         return curlStatusCode != CURLE_OK;
       }
 
       void setSecretKey(string inSecretKey) {
         secretKey = inSecretKey;
+        if (secretKey != "")
+          signer.setKey(secretKey);
       }
 
       void setAccessKey(string inAccessKey) {
         accessKey = inAccessKey;
+        apiKeyLine = "X-BFX-APIKEY: " + accessKey;
       }
 
+      // Headers sent with every request. curl list is built here once
+      // instead of on every request.
       void setHeader(map<string, string> inHeader) {
         header = inHeader;
+        curl_slist_free_all(staticHeader);
+        staticHeader = nullptr;
+        for (const auto &field : header) {
+          staticHeader = curl_slist_append(
+            staticHeader,
+            (field.first + ": " + field.second).c_str()
+          );
+        }
       }
 
-    private:
+      // Applies connection settings to both curl handles. Connections,
+      // TLS sessions and DNS entries are kept warm in the connection pool.
+      void setSettings(const HTTPSettings &inSettings) {
+        settings = inSettings;
+        pool->setup(curlGET, settings);
+        pool->setup(curlPOST, settings);
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        for (auto handle : idleHandles)
+          pool->setup(handle, settings);
+      }
 
-      ////////////////////////////////////////////////////////////////////////
-      // Private properties
-      ////////////////////////////////////////////////////////////////////////
-      
-      string endpoint, path, secretKey, accessKey, response;
-      map<string, string> header;
-      struct curl_slist *curlHeader = nullptr;
+      const HTTPSettings& getSettings() const noexcept {
+        return settings;
+      }
 
-      // Curl properties
-      CURL *curlGET;
-      CURL *curlPOST;
-      CURLcode curlStatusCode;
+      const std::shared_ptr<ConnectionPool>& getPool() const noexcept {
+        return pool;
+      }
+
+      // Requests wait for limiter budget before they are sent, nullptr
+      // disables client side rate limiting
+      void setRateLimiter(std::shared_ptr<RateLimiter> inLimiter) noexcept {
+        limiter = std::move(inLimiter);
+      }
+
+      const std::shared_ptr<RateLimiter>& getRateLimiter() const noexcept {
+        return limiter;
+      }
+
+      // Responses of endpoints with cache TTL are served from cache while
+      // fresh, nullptr disables caching
+      void setResponseCache(std::shared_ptr<ResponseCache> inCache) noexcept {
+        cache = std::move(inCache);
+      }
+
+      const std::shared_ptr<ResponseCache>& getResponseCache() const noexcept {
+        return cache;
+      }
+
+      // Network timings of every request are recorded into metrics,
+      // nullptr disables recording
+      void setLatencyMetrics(std::shared_ptr<LatencyMetrics> inMetrics)
+      noexcept {
+        metrics = std::move(inMetrics);
+      }
+
+      const std::shared_ptr<LatencyMetrics>& getLatencyMetrics() const
+      noexcept {
+        return metrics;
+      }
+
+      // Incremented by every get() and post(), identifies last response
+      unsigned long long getResponseSerial() const noexcept {
+        return responseSerial;
+      }
+
+      // Per endpoint retry and hedging of GET requests. Signed POST
+      // requests are never retried.
+      RetryPolicies& getRetryPolicies() noexcept {
+        return retryPolicies;
+      }
+
+      // Responses are written into caller owned buffer until
+      // resetResponseBuffer() is called. Buffer capacity is kept between
+      // requests so that it can be reused without reallocations.
+      void setResponseBuffer(string &buffer) noexcept {
+        responseBuffer = &buffer;
+      }
+
+      void resetResponseBuffer() noexcept {
+        responseBuffer = &response;
+      }
 
       ////////////////////////////////////////////////////////////////////////
-      // Private methods
+      // Curl callbacks (shared with AsyncHTTPRequest)
       ////////////////////////////////////////////////////////////////////////
 
       // Curl write callback function. Appends fetched *content to *userp
@@ -220,67 +446,666 @@ namespace BfxAPI {
         return size * nmemb;
       };
 
-      static void getBase64(const string &content, string &encoded) {
-        using CryptoPP::Base64Encoder;
-        using CryptoPP::StringSink;
-        using CryptoPP::StringSource;
+      // Curl header callback function. Reserves *userp response buffer
+      // capacity according to Content-Length header so that writeCallback
+      // appends without reallocations. Buffer capacity is never shrunk.
+      static size_t headerCallback(
+        char *data,
+        size_t size,
+        size_t nitems,
+        void *userp) noexcept
+      {
+        static constexpr char contentLength[] = "content-length:";
+        const size_t length = size * nitems;
+        const size_t prefixLength = sizeof(contentLength) - 1;
+
+        if (length > prefixLength) {
+          for (size_t i = 0; i < prefixLength; ++i) {
+            if (::tolower(data[i]) != contentLength[i])
+              return length;
+          }
+          size_t value = 0;
+          for (size_t i = prefixLength; i < length; ++i) {
+            if (data[i] >= '0' && data[i] <= '9')
+              value = value * 10 + (data[i] - '0');
+          }
+          auto buffer = static_cast <string*>(userp);
+          if (value > buffer->capacity()) {
+            try {
+              buffer->reserve(value);
+            } catch (...) {
+              // writeCallback will grow the buffer on its own
+            }
+          }
+        }
+        return length;
+      };
+
+      // Network phases of transfer completed on handle, validate phase is
+      // left untouched
+      static void readTimings(CURL *handle, RequestTimings &timings) noexcept {
+        // Cumulative times since transfer start
+        long long lookup = 0, connect = 0, handshake = 0, pretransfer = 0,
+                  firstByte = 0, total = 0;
+        #if LIBCURL_VERSION_NUM >= 0x073d00
+        const std::pair<CURLINFO, long long*> infos[] = {
+          {CURLINFO_NAMELOOKUP_TIME_T, &lookup},
+          {CURLINFO_CONNECT_TIME_T, &connect},
+          {CURLINFO_APPCONNECT_TIME_T, &handshake},
+          {CURLINFO_PRETRANSFER_TIME_T, &pretransfer},
+          {CURLINFO_STARTTRANSFER_TIME_T, &firstByte},
+          {CURLINFO_TOTAL_TIME_T, &total}
+        };
+        for (const auto &info : infos) {
+          curl_off_t micros = 0;
+          if (curl_easy_getinfo(handle, info.first, &micros) == CURLE_OK)
+            *info.second = static_cast<long long>(micros);
+        }
+        #else
+        const std::pair<CURLINFO, long long*> infos[] = {
+          {CURLINFO_NAMELOOKUP_TIME, &lookup},
+          {CURLINFO_CONNECT_TIME, &connect},
+          {CURLINFO_APPCONNECT_TIME, &handshake},
+          {CURLINFO_PRETRANSFER_TIME, &pretransfer},
+          {CURLINFO_STARTTRANSFER_TIME, &firstByte},
+          {CURLINFO_TOTAL_TIME, &total}
+        };
+        for (const auto &info : infos) {
+          double seconds = 0;
+          if (curl_easy_getinfo(handle, info.first, &seconds) == CURLE_OK)
+            *info.second = static_cast<long long>(seconds * 1e6);
+        }
+        #endif
+        auto between = [](long long from, long long to) {
+          return to > from ? to - from : 0;
+        };
+        timings[LatencyPhase::dns] = lookup;
+        timings[LatencyPhase::connect] = between(lookup, connect);
+        timings[LatencyPhase::tls] = handshake ? between(connect, handshake) : 0;
+        timings[LatencyPhase::firstByte] = between(pretransfer, firstByte);
+        timings[LatencyPhase::transfer] = between(firstByte, total);
+        timings[LatencyPhase::total] = total;
+      };
+
+      // Standard base64 without line breaks, encoded directly from content
+      // and appended to encoded. encoded is resized in place, so reusing the
+      // same output string across calls avoids reallocation once it's large
+      // enough.
+      static void appendBase64(const string &content, string &encoded) {
+        static constexpr char alphabet[] =
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        const auto *in = reinterpret_cast<const unsigned char*>(content.data());
+        const size_t length = content.length();
+        const size_t offset = encoded.size();
+        encoded.resize(offset + 4 * ((length + 2) / 3));
+        char *out = &encoded[offset];
+
+        size_t i = 0;
+        for (; i + 2 < length; i += 3) {
+          const unsigned long triple = (in[i] << 16) | (in[i + 1] << 8) |
+                                       in[i + 2];
+          *out++ = alphabet[(triple >> 18) & 0x3f];
+          *out++ = alphabet[(triple >> 12) & 0x3f];
+          *out++ = alphabet[(triple >> 6) & 0x3f];
+          *out++ = alphabet[triple & 0x3f];
+        }
+        if (i < length) {
+          const unsigned long triple = (in[i] << 16) |
+                                       (i + 1 < length ? in[i + 1] << 8 : 0);
+          *out++ = alphabet[(triple >> 18) & 0x3f];
+          *out++ = alphabet[(triple >> 12) & 0x3f];
+          *out++ = i + 1 < length ? alphabet[(triple >> 6) & 0x3f] : '=';
+          *out++ = '=';
+        }
+      };
+
+    private:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private properties
+      ////////////////////////////////////////////////////////////////////////
+      
+      // X-BFX-* lines of single signed request. nodes are caller owned
+      // curl_slist entries pointing into the lines and linked in front of
+      // staticHeader, which therefore is never modified per request.
+      struct SignedHeader {
+        string signatureLine, payloadLine;
+        struct curl_slist nodes[3];
+      };
+
+      string endpoint, path, secretKey, accessKey, response;
+      string apiKeyLine;
+      string *responseBuffer = &response;
+      unsigned long long responseSerial = 0;
+      // HMAC keyed by secretKey
+      mutable HmacSigner signer;
+      map<string, string> header;
+      // curl list of header, built by setHeader()
+      struct curl_slist *staticHeader = nullptr;
+      // Lines of post() reused between requests
+      SignedHeader signedHeader;
+      HTTPSettings settings;
+      std::shared_ptr<ConnectionPool> pool;
+
+      // Curl properties, handles of get() and post() are created on first use
+      CURL *curlGET = nullptr;
+      CURL *curlPOST = nullptr;
+      CURLcode curlStatusCode = CURLE_OK;
+      long httpStatusCode = 0;
+      std::shared_ptr<RateLimiter> limiter;
+      mutable RetryPolicies retryPolicies;
+      std::shared_ptr<ResponseCache> cache;
+      std::shared_ptr<LatencyMetrics> metrics;
+      RequestTimings lastTimings;
+      std::shared_ptr<Transport> transport;
+      // Curl handles used by thread-safe methods
+      mutable std::mutex handlesMutex;
+      mutable std::vector<CURL*> idleHandles;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private methods
+      ////////////////////////////////////////////////////////////////////////
+
+      CURL* acquireHandle() const {
+        {
+          std::lock_guard<std::mutex> lock(handlesMutex);
+          if (!idleHandles.empty()) {
+            CURL *handle = idleHandles.back();
+            idleHandles.pop_back();
+            return handle;
+          }
+        }
+        CURL *handle = curl_easy_init();
+        pool->setup(handle, settings);
+        return handle;
+      };
+
+      void releaseHandle(CURL *handle) const {
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        idleHandles.push_back(handle);
+      };
+
+      CURL* lastRequestHandle(CURL *&handle) {
+        if (!handle) {
+          handle = curl_easy_init();
+          pool->setup(handle, settings);
+        }
+        return handle;
+      };
+
+      // libcurl transport, see curlTransport()
+      class CurlTransport: public Transport {
 
-        byte buffer[1024] = {};
+        public:
 
-        for (auto i = 0; i < content.length(); ++i)
-            buffer[i] = content[i];
+          explicit CurlTransport(const HTTPRequest &inOwner): owner(inOwner) {}
+
+          void perform(const TransportRequest &request,
+                       HTTPResponse &response) override {
+            owner.performCurl(request, response);
+          }
+
+        private:
+
+          const HTTPRequest &owner;
+
+      };
+
+      // Sends request on pooled handle, signed POST requests are signed
+      // here. Response cache is consulted first.
+      void performCurl(const TransportRequest &request,
+                       HTTPResponse &out) const {
+        if (request.method == HTTPMethod::get) {
+          perform(out, endpoint + request.path + "?" + request.query, false,
+                  staticHeader);
+          return;
+        }
+
+        string cacheKey;
+        if (cacheable(request.path)) {
+          cacheKey = signedCacheKey(endpoint + request.path);
+          if (cacheHit(request.path, cacheKey, out.body, out.httpStatusCode)) {
+            out.curlStatusCode = CURLE_OK;
+            return;
+          }
+        }
+
+        SignedHeader requestHeader;
+        struct curl_slist *signedHeader =
+          linkSignedHeader(requestHeader, request.payload);
+        perform(out, endpoint + request.path, true, signedHeader);
+        if (!cacheKey.empty() && out.curlStatusCode == CURLE_OK &&
+            out.httpStatusCode == 200)
+          cacheStore(cacheKey, out.body, false);
+      };
 
-        StringSource ss(
-          buffer,
-          content.length(),
-          true,
-          new Base64Encoder(new StringSink(encoded), false)
-        );
+      // Fills last response of get() and post() from transport
+      void performLast(const TransportRequest &request) {
+        HTTPResponse response;
+        perform(response, request);
+        responseBuffer->swap(response.body);
+        curlStatusCode = response.curlStatusCode;
+        httpStatusCode = response.httpStatusCode;
+        lastTimings = response.timings;
       };
 
-      static void getHmacSha384(
-        const string &key,
-        const string &content,
-        string &digest)
+      void perform(HTTPResponse &out,
+                   const string &url,
+                   bool isPost,
+                   struct curl_slist *requestHeader) const {
+        out.body.clear();
+        out.httpStatusCode = 0;
+        out.bfxApiStatusCode = noError;
+        out.timings.clear();
+
+        CURL *handle = acquireHandle();
+        if (!handle) {
+          cerr << "curl not properly initialized in HTTPRequest.perform()";
+          cerr << endl;
+          out.curlStatusCode = CURLE_FAILED_INIT;
+          return;
+        }
+
+        curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, requestHeader);
+        if (isPost) {
+          curl_easy_setopt(handle, CURLOPT_POST, 1L);
+          curl_easy_setopt(handle, CURLOPT_POSTFIELDS, "\n");
+        } else {
+          curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+        }
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, &out.body);
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, &out.body);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, headerCallback);
+
+        if (!isPost) {
+          out.curlStatusCode = cachedGet(handle, out.body, out.path, url,
+                                         requestHeader, out.httpStatusCode,
+                                         out.timings);
+        } else {
+          if (limiter)
+            limiter->acquire(out.path);
+          out.curlStatusCode = curl_easy_perform(handle);
+          curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE,
+                            &out.httpStatusCode);
+          readTimings(handle, out.timings);
+        }
+        // Header list is owned by caller
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, nullptr);
+        releaseHandle(handle);
+
+        // libcurl internal error handling
+        if (out.curlStatusCode != CURLE_OK) {
+          cerr << "libcurl error in Request.perform():" << endl;
+          cerr << "CURLcode: " << out.curlStatusCode << endl;
+        }
+      };
+
+      ////////////////////////////////////////////////////////////////////////
+      // Response cache
+      ////////////////////////////////////////////////////////////////////////
+
+      // Validators of response captured for conditional revalidation
+      struct CacheHeaders {
+        string *body;
+        string etag;
+        string lastModified;
+      };
+
+      // Request header list and header capture of GET, shared by primary
+      // and hedged handle
+      struct GetHeaders {
+        struct curl_slist *list;
+        CacheHeaders *cache;  // null when response isn't cached
+      };
+
+      static size_t cacheHeaderCallback(
+        char *data,
+        size_t size,
+        size_t nitems,
+        void *userp) noexcept
       {
-          using CryptoPP::HashFilter;
-          using CryptoPP::HexEncoder;
-          using CryptoPP::HMAC;
-          using CryptoPP::SecByteBlock;
-          using CryptoPP::StringSink;
-          using CryptoPP::StringSource;
-          using CryptoPP::SHA384;
-          using std::transform;
-
-          SecByteBlock byteKey((const byte*)key.data(), key.size());
-          string mac;
-          digest.clear();
-
-          HMAC<SHA384> hmac(byteKey, byteKey.size());
-          StringSource ss1(
-            content, true,
-            new HashFilter(hmac, new StringSink(mac))
-          );
-          StringSource ss2(mac, true, new HexEncoder(new StringSink(digest)));
-          transform(digest.cbegin(), digest.cend(), digest.begin(), ::tolower);
+        auto headers = static_cast <CacheHeaders*>(userp);
+        const size_t length = size * nitems;
+        captureHeader(data, length, "etag:", headers->etag);
+        captureHeader(data, length, "last-modified:", headers->lastModified);
+        return headerCallback(data, size, nitems, headers->body);
       };
 
-      void setupHeader() {
-        curlHeader = nullptr;
-        for (auto it = header.begin(); it != header.end(); it++) {
-          curlHeader = curl_slist_append(
-            curlHeader,
-            (it->first + ": " + it->second).c_str()
-          );
+      // Copies trimmed value of header line data if it's named by name
+      // (lowercase, with colon)
+      static void captureHeader(const char *data,
+                                size_t length,
+                                const char *name,
+                                string &value) noexcept
+      {
+        size_t i = 0;
+        for (; name[i]; ++i) {
+          if (i >= length || ::tolower(data[i]) != name[i])
+            return;
+        }
+        while (i < length && data[i] == ' ')
+          ++i;
+        while (length > i && (data[length - 1] == '\r' ||
+                              data[length - 1] == '\n'))
+          --length;
+        try {
+          value.assign(data + i, length - i);
+        } catch (...) {
+          value.clear();
         }
       };
 
-      void clearHeader() {
-        curlHeader = nullptr;
-        header.erase("X-BFX-APIKEY");
-        header.erase("X-BFX-SIGNATURE");
-        header.erase("X-BFX-PAYLOAD");
-      }
+      bool cacheable(const string &inPath) const {
+        return cache && cache->getTTL(inPath).count() > 0;
+      };
+
+      // Signed responses are cached per access key
+      string signedCacheKey(const string &url) const {
+        return url + "#" + std::to_string(std::hash<string>()(accessKey));
+      };
+
+      bool cacheHit(const string &inPath,
+                    const string &key,
+                    string &body,
+                    long &httpCode) const {
+        ResponseCache::Entry entry;
+        bool fresh = false;
+        if (!cache->lookup(inPath, key, entry, fresh) || !fresh)
+          return false;
+        body = entry.body;
+        httpCode = 200;
+        return true;
+      };
+
+      void cacheStore(const string &key,
+                      const string &body,
+                      bool persistent) const {
+        ResponseCache::Entry entry;
+        entry.body = body;
+        entry.persistent = persistent;
+        cache->store(key, std::move(entry));
+      };
+
+      // Serves GET from cache while fresh, otherwise performs it, sending
+      // If-None-Match / If-Modified-Since for expired entry. 304 Not
+      // Modified response is served from cache. handle is set up with
+      // requestHeader.
+      CURLcode cachedGet(CURL *handle,
+                         string &body,
+                         const string &inPath,
+                         const string &url,
+                         struct curl_slist *requestHeader,
+                         long &httpCode,
+                         RequestTimings &timings) const {
+        timings.clear();
+        if (!cacheable(inPath)) {
+          const GetHeaders headers{requestHeader, nullptr};
+          return performGet(handle, body, inPath, url, headers, httpCode,
+                            timings);
+        }
+
+        ResponseCache::Entry entry;
+        bool fresh = false;
+        const bool cached = cache->lookup(inPath, url, entry, fresh);
+        if (cached && fresh) {
+          body = entry.body;
+          httpCode = 200;
+          return CURLE_OK;
+        }
+
+        string conditionLines[2];
+        struct curl_slist conditionNodes[2];
+        struct curl_slist *conditionalHeader = requestHeader;
+        size_t conditions = 0;
+        if (cached && !entry.etag.empty())
+          conditionLines[conditions++] = "If-None-Match: " + entry.etag;
+        if (cached && !entry.lastModified.empty())
+          conditionLines[conditions++] =
+            "If-Modified-Since: " + entry.lastModified;
+        for (size_t i = 0; i < conditions; ++i) {
+          conditionNodes[i].data = &conditionLines[i][0];
+          conditionNodes[i].next = conditionalHeader;
+          conditionalHeader = &conditionNodes[i];
+        }
+
+        CacheHeaders captured{&body, "", ""};
+        const GetHeaders headers{conditionalHeader, &captured};
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, conditionalHeader);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, cacheHeaderCallback);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, &captured);
+        const CURLcode code = performGet(handle, body, inPath, url, headers,
+                                         httpCode, timings);
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, requestHeader);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, headerCallback);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, &body);
+
+        if (code == CURLE_OK && httpCode == 304 && cached) {
+          body = entry.body;
+          httpCode = 200;
+          cache->refresh(url);
+        } else if (code == CURLE_OK && httpCode == 200) {
+          entry.body = body;
+          entry.etag = captured.etag;
+          entry.lastModified = captured.lastModified;
+          entry.persistent = true;
+          cache->store(url, std::move(entry));
+        }
+        return code;
+      };
+
+      // Performs GET on handle set up for url, headers and writing into
+      // body. Retryable failures are retried with jittered exponential
+      // backoff, each attempt takes own rate limiter token. timings are
+      // those of last attempt.
+      CURLcode performGet(CURL *handle,
+                          string &body,
+                          const string &inPath,
+                          const string &url,
+                          const GetHeaders &headers,
+                          long &httpCode,
+                          RequestTimings &timings) const {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        using std::chrono::steady_clock;
+
+        const RetryPolicy policy = retryPolicies.get(inPath);
+        for (unsigned attempt = 0; ; ++attempt) {
+          if (attempt)
+            std::this_thread::sleep_for(RetryPolicies::backoff(policy,
+                                                               attempt));
+          body.clear();
+          httpCode = 0;
+          if (limiter)
+            limiter->acquire(inPath);
+
+          const auto start = steady_clock::now();
+          const CURLcode code = policy.hedge
+            ? performHedged(handle, body, inPath, url, headers, httpCode,
+                            timings)
+            : curl_easy_perform(handle);
+          if (!policy.hedge) {
+            curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &httpCode);
+            readTimings(handle, timings);
+          }
+
+          if (code == CURLE_OK && httpCode < 400) {
+            retryPolicies.recordLatency(inPath, static_cast<long>(
+              duration_cast<milliseconds>(steady_clock::now() - start)
+              .count()));
+          }
+          if (attempt >= policy.maxRetries ||
+              !RetryPolicies::isRetryable(code, httpCode))
+            return code;
+        }
+      };
+
+      // Sends second request on pooled handle when primary handle hasn't
+      // completed within hedge delay, first successful response wins. Both
+      // send same headers and capture response headers alike.
+      CURLcode performHedged(CURL *primary,
+                             string &body,
+                             const string &inPath,
+                             const string &url,
+                             const GetHeaders &headers,
+                             long &httpCode,
+                             RequestTimings &timings) const {
+        CURLM *multi = curl_multi_init();
+        if (!multi)
+          return CURLE_OUT_OF_MEMORY;
+        curl_multi_add_handle(multi, primary);
+
+        const auto hedgeAt = std::chrono::steady_clock::now() +
+          std::chrono::milliseconds(retryPolicies.hedgeDelayMs(inPath));
+        CURL *secondary = nullptr;
+        string secondaryBody;
+        CacheHeaders secondaryCaptured{&secondaryBody, "", ""};
+        bool hedged = false;
+        CURL *winner = nullptr;
+        CURLcode result = CURLE_OK;
+        int active = 1;
+
+        while (!winner) {
+          int running = 0;
+          curl_multi_perform(multi, &running);
+
+          int queued = 0;
+          while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE || winner)
+              continue;
+            CURL *done = message->easy_handle;
+            curl_multi_remove_handle(multi, done);
+            --active;
+            long code = 0;
+            curl_easy_getinfo(done, CURLINFO_RESPONSE_CODE, &code);
+            // Failure wins only when nothing else is in flight
+            if ((message->data.result == CURLE_OK && code < 500) || !active) {
+              winner = done;
+              result = message->data.result;
+            }
+          }
+          if (winner)
+            break;
+
+          const auto now = std::chrono::steady_clock::now();
+          if (!hedged && now >= hedgeAt) {
+            hedged = true;
+            secondary = acquireHandle();
+            // Hedge takes own rate limiter token and is skipped without one
+            if (secondary && !canHedge(inPath)) {
+              releaseHandle(secondary);
+              secondary = nullptr;
+            }
+            if (secondary) {
+              curl_easy_setopt(secondary, CURLOPT_URL, url.c_str());
+              curl_easy_setopt(secondary, CURLOPT_HTTPHEADER, headers.list);
+              curl_easy_setopt(secondary, CURLOPT_HTTPGET, 1L);
+              curl_easy_setopt(secondary, CURLOPT_WRITEDATA, &secondaryBody);
+              curl_easy_setopt(secondary, CURLOPT_WRITEFUNCTION,
+                               writeCallback);
+              if (headers.cache) {
+                curl_easy_setopt(secondary, CURLOPT_HEADERDATA,
+                                 &secondaryCaptured);
+                curl_easy_setopt(secondary, CURLOPT_HEADERFUNCTION,
+                                 cacheHeaderCallback);
+              } else {
+                curl_easy_setopt(secondary, CURLOPT_HEADERDATA,
+                                 &secondaryBody);
+                curl_easy_setopt(secondary, CURLOPT_HEADERFUNCTION,
+                                 headerCallback);
+              }
+              curl_multi_add_handle(multi, secondary);
+              ++active;
+              continue;
+            }
+          }
+
+          int timeoutMs = 100;
+          if (!hedged) {
+            timeoutMs = static_cast<int>(
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                hedgeAt - now).count()) + 1;
+          }
+          #if LIBCURL_VERSION_NUM >= 0x074200
+          curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+          #else
+          curl_multi_wait(multi, nullptr, 0, timeoutMs, nullptr);
+          #endif
+        }
+
+        // Status and timings are those of response served
+        curl_easy_getinfo(winner, CURLINFO_RESPONSE_CODE, &httpCode);
+        readTimings(winner, timings);
+        curl_multi_remove_handle(multi, primary);
+        if (secondary) {
+          curl_multi_remove_handle(multi, secondary);
+          curl_easy_setopt(secondary, CURLOPT_HTTPHEADER, nullptr);
+          releaseHandle(secondary);
+        }
+        curl_multi_cleanup(multi);
+
+        if (winner == secondary) {
+          body.swap(secondaryBody);
+          if (headers.cache) {
+            headers.cache->etag.swap(secondaryCaptured.etag);
+            headers.cache->lastModified.swap(secondaryCaptured.lastModified);
+          }
+        }
+        return result;
+      };
+
+      void recordTimings(Endpoint endpointId,
+                         const RequestTimings &timings) const {
+        if (metrics && timings[LatencyPhase::total] > 0)
+          metrics->record(endpointId, timings);
+      };
+
+      // Takes token of hedged request if rate limiter budget has one
+      // without waiting
+      bool canHedge(const string &inPath) const {
+        RateLimiter::Clock::duration wait;
+        return !limiter || limiter->tryAcquire(inPath, wait);
+      };
+
+      // Writes X-BFX-* lines of json payload into out and returns header
+      // list of the request. Lines keep their capacity, so a reused out
+      // makes no allocations.
+      struct curl_slist* linkSignedHeader(SignedHeader &out,
+                                          const string &json) const {
+        static constexpr char signaturePrefix[] = "X-BFX-SIGNATURE: ";
+        static constexpr char payloadPrefix[] = "X-BFX-PAYLOAD: ";
+        static constexpr size_t payloadOffset = sizeof(payloadPrefix) - 1;
+
+        struct curl_slist *head = staticHeader;
+        struct curl_slist *node = out.nodes;
+        auto link = [&head, &node](const string &line) {
+          node->data = const_cast<char*>(line.c_str());
+          node->next = head;
+          head = node++;
+        };
+
+        out.payloadLine.assign(payloadPrefix);
+        appendBase64(json, out.payloadLine);
+        const size_t payloadLength = out.payloadLine.size() - payloadOffset;
+
+        if (payloadLength) {
+          link(out.payloadLine);
+        }
+        if (secretKey != "") {
+          HmacSigner::Signature signature;
+          signer.sign(out.payloadLine.data() + payloadOffset, payloadLength,
+                      signature);
+          out.signatureLine.assign(signaturePrefix);
+          out.signatureLine.append(signature, HmacSigner::SIGNATURE_LENGTH);
+          link(out.signatureLine);
+        }
+        if (accessKey != "") {
+          link(apiKeyLine);
+        }
+        return head;
+      };
 
   };
 
@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////////
+//  HistoryRange.hpp
+//
+//
+//  Bitfinex REST API C++ client - paginated history endpoints as ranges
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// internal error enumeration, responses
+#include "error.hpp"
+#include "responses.hpp"
+
+namespace BfxAPI
+{
+
+    /// Records of history endpoint from until back to since, newest first.
+    /// Pages of at most limit records are fetched by walking the until
+    /// window backwards; the next page is requested in background as soon
+    /// as the current one arrives, so at most two pages are held in memory
+    /// however long the history is. Records repeated at page boundary (same
+    /// second) are skipped. Iteration stops at the first failed page, see
+    /// status(). Single pass, not thread-safe, must not outlive BitfinexAPI
+    /// which created it.
+    template <typename T>
+    class HistoryRange
+    {
+
+    public:
+
+        // Fetches page of records with timestamp not after until
+        using FetchPage = std::function<BfxClientErrors(time_t until,
+                                                        std::vector<T> &page)>;
+
+        class iterator
+        {
+
+        public:
+
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            iterator() = default;
+            explicit iterator(HistoryRange *range): range_(range)
+            { settle(); }
+
+            reference operator * () const { return range_->current(); }
+            pointer operator -> () const { return &range_->current(); }
+
+            iterator& operator ++ ()
+            {
+                range_->advance();
+                settle();
+                return *this;
+            }
+
+            bool operator == (const iterator &other) const noexcept
+            { return range_ == other.range_; }
+
+            bool operator != (const iterator &other) const noexcept
+            { return range_ != other.range_; }
+
+        private:
+
+            HistoryRange *range_ = nullptr;
+
+            void settle()
+            {
+                if (range_ && range_->exhausted())
+                    range_ = nullptr;
+            }
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+        ////////////////////////////////////////////////////////////////////////
+
+        HistoryRange(FetchPage fetch,
+                     time_t since,
+                     time_t until,
+                     unsigned limit):
+        fetch_(std::move(fetch)),
+        since_(since),
+        limit_(limit ? limit : 1)
+        {
+            request(until ? until : std::time(nullptr));
+        }
+
+        // Range rejected before sending any request
+        explicit HistoryRange(BfxClientErrors status): status_(status) {}
+
+        HistoryRange(HistoryRange &&) = default;
+        HistoryRange& operator = (HistoryRange &&) = default;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Iteration
+        ////////////////////////////////////////////////////////////////////////
+
+        // First call waits for the first page
+        iterator begin() { return iterator(this); }
+        iterator end() noexcept { return iterator(); }
+
+        // Error of failed page, noError when history was read completely
+        BfxClientErrors status() const noexcept { return status_; }
+
+        // Pages received so far
+        size_t pages() const noexcept { return pages_; }
+
+    private:
+
+        using Page = std::pair<BfxClientErrors, std::vector<T>>;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        FetchPage fetch_;
+        time_t since_ = 0;
+        unsigned limit_ = 1;
+        BfxClientErrors status_ = noError;
+        size_t pages_ = 0;
+        std::future<Page> next_; // page in flight, invalid after last one
+        std::vector<T> page_;    // unread records of current page
+        size_t position_ = 0;
+        // Records of last page in its oldest second, repeated by next page
+        std::vector<T> boundary_;
+        time_t boundarySecond_ = 0;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        void request(time_t until)
+        {
+            FetchPage fetch = fetch_;
+            next_ = std::async(std::launch::async, [fetch, until]
+            {
+                Page page;
+                page.first = fetch(until, page.second);
+                return page;
+            });
+        }
+
+        const T& current() const { return page_[position_]; }
+
+        void advance() { ++position_; }
+
+        // Receives pages until a record is available or history ends
+        bool exhausted()
+        {
+            while (position_ == page_.size())
+            {
+                if (!next_.valid())
+                    return true;
+                receive(next_.get());
+            }
+            return false;
+        }
+
+        void receive(Page page)
+        {
+            ++pages_;
+            page_.clear();
+            position_ = 0;
+            if (page.first != noError)
+            {
+                status_ = page.first;
+                return;
+            }
+
+            std::vector<T> &records = page.second;
+            for (auto &record : records)
+            {
+                if (since_ && record.timestamp < since_)
+                    continue;
+                if (repeated(record))
+                    continue;
+                page_.push_back(record);
+            }
+
+            // Short page is the last one
+            if (records.size() < limit_)
+                return;
+
+            // Oldest second of page is asked for again unless the page held
+            // nothing new, e.g. more than limit records in the same second
+            time_t oldest = static_cast<time_t>(std::floor(
+                records.back().timestamp));
+            for (const auto &record : records)
+                oldest = std::min(oldest, static_cast<time_t>(
+                    std::floor(record.timestamp)));
+            if (since_ && oldest < since_)
+                return;
+
+            time_t until = oldest;
+            if (page_.empty())
+            {
+                --until;
+                boundary_.clear();
+            }
+            else
+            {
+                boundary_.clear();
+                for (auto &record : records)
+                {
+                    if (record.timestamp < oldest + 1)
+                        boundary_.push_back(std::move(record));
+                }
+            }
+            boundarySecond_ = oldest;
+            request(until);
+        }
+
+        bool repeated(const T &record) const
+        {
+            if (record.timestamp >= boundarySecond_ + 1)
+                return false;
+            for (const auto &seen : boundary_)
+            {
+                if (sameRecord(seen, record))
+                    return true;
+            }
+            return false;
+        }
+
+        // Identity of records, by exchange id where the endpoint has one
+        static bool sameRecord(const PastTrade &a, const PastTrade &b)
+        { return a.tid == b.tid; }
+
+        static bool sameRecord(const FundingTrade &a, const FundingTrade &b)
+        { return a.tid == b.tid; }
+
+        static bool sameRecord(const Movement &a, const Movement &b)
+        { return a.id == b.id; }
+
+        static bool sameRecord(const BalanceHistoryEntry &a,
+                               const BalanceHistoryEntry &b)
+        {
+            return a.timestamp == b.timestamp && a.amount == b.amount &&
+                a.balance == b.balance && a.currency == b.currency &&
+                a.description == b.description;
+        }
+    };
+}
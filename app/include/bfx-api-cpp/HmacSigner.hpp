@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+//  HmacSigner.hpp
+//
+//
+//  Bitfinex REST API C++ client - reusable HMAC-SHA384 payload signer
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+// internal BFX_DECL
+#include "Config.hpp"
+
+namespace BfxAPI {
+
+  // HMAC-SHA384 signer keyed once by setKey(), empty key until then or
+  // when key is set to empty string. Every signature reuses keyed
+  // HMAC state (CryptoPP restarts it after each Final()) and is hex encoded
+  // in lowercase straight into caller's fixed buffer, so signing makes no
+  // heap allocations. Signing is serialized by internal mutex, thus one
+  // signer can be shared by multiple threads. CryptoPP state is allocated
+  // once by constructor, so that this header doesn't need CryptoPP headers.
+  class HmacSigner {
+
+    public:
+
+      // Hex encoded SHA384 digest length
+      static constexpr size_t SIGNATURE_LENGTH = 2 * 48;
+
+      using Signature = char[SIGNATURE_LENGTH + 1];
+
+      HmacSigner();
+      ~HmacSigner();
+
+      ////////////////////////////////////////////////////////////////////////
+      // Public methods
+      ////////////////////////////////////////////////////////////////////////
+
+      void setKey(const std::string &key);
+
+      // Writes NUL terminated lowercase hex signature of content into out
+      void sign(const char *content, size_t length, Signature &out);
+
+      void sign(const std::string &content, Signature &out) {
+        sign(content.data(), content.size(), out);
+      }
+
+    private:
+
+      struct State;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private properties
+      ////////////////////////////////////////////////////////////////////////
+
+      std::unique_ptr<State> state;
+      std::mutex mutex;
+
+  };
+
+}
+
+#if BFX_HEADER_DEFINITIONS
+
+// cryptopp
+#include <cryptopp/hmac.h>
+#include <cryptopp/sha.h>
+
+// CRYPTOPP_NO_GLOBAL_BYTE signals byte is at CryptoPP::byte
+#ifdef CRYPTOPP_NO_GLOBAL_BYTE
+using CryptoPP::byte;
+#endif
+
+namespace BfxAPI {
+
+  static_assert(HmacSigner::SIGNATURE_LENGTH ==
+                2 * CryptoPP::SHA384::DIGESTSIZE,
+                "SIGNATURE_LENGTH must match SHA384 digest");
+
+  struct HmacSigner::State {
+    CryptoPP::HMAC<CryptoPP::SHA384> hmac;
+  };
+
+  BFX_DECL HmacSigner::HmacSigner():
+  state(new State)
+  {
+    setKey(std::string());
+  }
+
+  BFX_DECL HmacSigner::~HmacSigner() = default;
+
+  BFX_DECL void HmacSigner::setKey(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    state->hmac.SetKey(reinterpret_cast<const byte*>(key.data()), key.size());
+  }
+
+  BFX_DECL void HmacSigner::sign(const char *content,
+                                 size_t length,
+                                 Signature &out) {
+    static constexpr char hexDigits[] = "0123456789abcdef";
+    byte digest[CryptoPP::SHA384::DIGESTSIZE];
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      state->hmac.Update(reinterpret_cast<const byte*>(content), length);
+      state->hmac.Final(digest);
+    }
+    for (size_t i = 0; i < sizeof(digest); ++i) {
+      out[2 * i] = hexDigits[digest[i] >> 4];
+      out[2 * i + 1] = hexDigits[digest[i] & 0x0f];
+    }
+    out[SIGNATURE_LENGTH] = '\0';
+  }
+
+}
+
+#endif
@@ -0,0 +1,400 @@
+////////////////////////////////////////////////////////////////////////////////
+//  LatencyMetrics.hpp
+//
+//
+//  Bitfinex REST API C++ client - per endpoint request latency histograms
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// internal endpoint table
+#include "Endpoints.hpp"
+
+namespace BfxAPI
+{
+
+    /// Phases of single request in microseconds
+    enum class LatencyPhase
+    {
+        dns,        // name lookup
+        connect,    // TCP connect after name lookup
+        tls,        // TLS handshake after connect
+        firstByte,  // request sent to first response byte (server time)
+        transfer,   // first to last response byte
+        total,      // whole transfer as measured by curl
+        validate    // JSON parse, schema validation and decoding (one pass)
+    };
+
+    constexpr size_t LATENCY_PHASE_COUNT =
+        static_cast<size_t>(LatencyPhase::validate) + 1;
+
+    /// Timing breakdown of one request. Network phases are 0 for responses
+    /// served from cache, dns, connect and tls are 0 on reused connections.
+    struct RequestTimings
+    {
+        long long micros[LATENCY_PHASE_COUNT] = {};
+
+        long long& operator [] (LatencyPhase phase) noexcept
+        { return micros[static_cast<size_t>(phase)]; }
+
+        long long operator [] (LatencyPhase phase) const noexcept
+        { return micros[static_cast<size_t>(phase)]; }
+
+        void clear() noexcept
+        { std::fill(micros, micros + LATENCY_PHASE_COUNT, 0); }
+    };
+
+    /// High dynamic range histogram of microsecond values: every power of
+    /// two range is split into 16 linear sub-buckets, so any value is
+    /// recorded with at most 1/16 relative error. Recording is one relaxed
+    /// atomic increment per counter, readers may run concurrently and see
+    /// a slightly inconsistent but never torn state.
+    class LatencyHistogram
+    {
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        static constexpr unsigned SUB_BUCKET_BITS = 4;
+        static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+        // Values from 2^MAX_EXPONENT us (~71 minutes) on share last bucket
+        static constexpr unsigned MAX_EXPONENT = 32;
+
+    public:
+
+        static constexpr size_t BUCKET_COUNT =
+            (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        LatencyHistogram() noexcept { reset(); }
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator = (const LatencyHistogram&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Recording
+        ////////////////////////////////////////////////////////////////////////
+
+        void record(long long micros) noexcept
+        {
+            const uint64_t value = micros > 0 ? micros : 0;
+            buckets_[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while (value > max &&
+                   !max_.compare_exchange_weak(max, value,
+                                               std::memory_order_relaxed))
+                ;
+        }
+
+        // Not atomic with respect to concurrent record()
+        void reset() noexcept
+        {
+            for (auto &counter : buckets_)
+                counter.store(0, std::memory_order_relaxed);
+            count_.store(0, std::memory_order_relaxed);
+            sum_.store(0, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Queries
+        ////////////////////////////////////////////////////////////////////////
+
+        uint64_t count() const noexcept
+        { return count_.load(std::memory_order_relaxed); }
+
+        uint64_t sum() const noexcept
+        { return sum_.load(std::memory_order_relaxed); }
+
+        uint64_t max() const noexcept
+        { return max_.load(std::memory_order_relaxed); }
+
+        double mean() const noexcept
+        {
+            const uint64_t n = count();
+            return n ? static_cast<double>(sum()) / n : 0;
+        }
+
+        // Upper bound of bucket holding quantile q in [0, 1], never above
+        // max(). 0 when empty.
+        uint64_t quantile(double q) const noexcept
+        {
+            uint64_t total = 0;
+            for (const auto &counter : buckets_)
+                total += counter.load(std::memory_order_relaxed);
+            if (!total)
+                return 0;
+
+            const uint64_t rank = std::max<uint64_t>(
+                1, static_cast<uint64_t>(std::ceil(
+                       std::min(std::max(q, 0.0), 1.0) * total)));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKET_COUNT; ++i)
+            {
+                seen += buckets_[i].load(std::memory_order_relaxed);
+                if (seen >= rank)
+                    return std::min(upperBound(i), max());
+            }
+            return max();
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> buckets_[BUCKET_COUNT];
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> sum_;
+        std::atomic<uint64_t> max_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        // Values below 2 * SUB_BUCKETS map to themselves, above that bucket
+        // index grows by SUB_BUCKETS per power of two. Exponent
+        // MAX_EXPONENT - 1 fills the last row, larger values are clamped
+        // into the last bucket.
+        static size_t bucket(uint64_t value) noexcept
+        {
+            if (value < 2 * SUB_BUCKETS)
+                return static_cast<size_t>(value);
+            const unsigned exponent = log2(value);
+            if (exponent >= MAX_EXPONENT)
+                return BUCKET_COUNT - 1;
+            const unsigned shift = exponent - SUB_BUCKET_BITS;
+            return static_cast<size_t>(
+                (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS +
+                ((value >> shift) & (SUB_BUCKETS - 1)));
+        }
+
+        static uint64_t lowerBound(size_t index) noexcept
+        {
+            if (index < 2 * SUB_BUCKETS)
+                return index;
+            const unsigned exponent = static_cast<unsigned>(
+                index / SUB_BUCKETS + SUB_BUCKET_BITS - 1);
+            return (SUB_BUCKETS + index % SUB_BUCKETS)
+                << (exponent - SUB_BUCKET_BITS);
+        }
+
+        static uint64_t upperBound(size_t index) noexcept
+        {
+            return index + 1 < BUCKET_COUNT
+                ? lowerBound(index + 1) - 1
+                : UINT64_MAX;
+        }
+
+        static unsigned log2(uint64_t value) noexcept
+        {
+            #if defined(__GNUC__) || defined(__clang__)
+            return 63 - static_cast<unsigned>(__builtin_clzll(value));
+            #else
+            unsigned exponent = 0;
+            while (value >>= 1)
+                ++exponent;
+            return exponent;
+            #endif
+        }
+    };
+
+    /// Latency histograms of every endpoint and phase, filled by
+    /// HTTPRequest and AsyncHTTPRequest (network phases) and BitfinexAPI
+    /// (validation). Histograms of endpoint are allocated on its first
+    /// request. Recording and reading are lock-free and thread-safe.
+    class LatencyMetrics
+    {
+
+    public:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor / Destructor
+        ////////////////////////////////////////////////////////////////////////
+
+        LatencyMetrics() noexcept
+        {
+            for (auto &histograms : endpoints_)
+                histograms.store(nullptr, std::memory_order_relaxed);
+        }
+
+        ~LatencyMetrics()
+        {
+            for (auto &histograms : endpoints_)
+                delete histograms.load(std::memory_order_relaxed);
+        }
+
+        LatencyMetrics(const LatencyMetrics&) = delete;
+        LatencyMetrics& operator = (const LatencyMetrics&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Recording
+        ////////////////////////////////////////////////////////////////////////
+
+        // Records non-zero phases of timings. Responses without network
+        // time (cache hits, rejected requests) only record validation.
+        void record(Endpoint endpoint, const RequestTimings &timings)
+        {
+            EndpointHistograms &histograms = acquire(endpoint);
+            for (size_t i = 0; i < LATENCY_PHASE_COUNT; ++i)
+            {
+                if (timings.micros[i] > 0)
+                    histograms.phases[i].record(timings.micros[i]);
+            }
+        }
+
+        void record(Endpoint endpoint, LatencyPhase phase, long long micros)
+        {
+            acquire(endpoint).phases[static_cast<size_t>(phase)]
+                .record(micros);
+        }
+
+        // Clears all histograms
+        void reset() noexcept
+        {
+            for (auto &slot : endpoints_)
+            {
+                auto histograms = slot.load(std::memory_order_acquire);
+                if (!histograms)
+                    continue;
+                for (auto &phase : histograms->phases)
+                    phase.reset();
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Queries
+        ////////////////////////////////////////////////////////////////////////
+
+        // Empty histogram when endpoint had no request yet
+        const LatencyHistogram& histogram(Endpoint endpoint,
+                                          LatencyPhase phase) const noexcept
+        {
+            static const LatencyHistogram empty;
+            const auto histograms =
+                endpoints_[static_cast<size_t>(endpoint)]
+                .load(std::memory_order_acquire);
+            return histograms
+                ? histograms->phases[static_cast<size_t>(phase)]
+                : empty;
+        }
+
+        static const char* phaseName(LatencyPhase phase) noexcept
+        {
+            static constexpr const char *names[LATENCY_PHASE_COUNT] =
+            {
+                "dns", "connect", "tls", "first_byte", "transfer", "total",
+                "validate"
+            };
+            return names[static_cast<size_t>(phase)];
+        }
+
+        // Prometheus text exposition format: one summary family with
+        // endpoint and phase labels, values in seconds
+        void writePrometheus(std::ostream &out) const
+        {
+            static constexpr double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+            static constexpr auto name = "bfx_request_phase_seconds";
+
+            out << "# HELP " << name
+                << " Bitfinex REST request latency by phase\n"
+                << "# TYPE " << name << " summary\n";
+            for (size_t e = 0; e <= ENDPOINT_COUNT; ++e)
+            {
+                const Endpoint endpoint = static_cast<Endpoint>(e);
+                if (!endpoints_[e].load(std::memory_order_acquire))
+                    continue;
+                const char *endpointName = e < ENDPOINT_COUNT
+                    ? endpointInfo(endpoint).schema
+                    : "unknown";
+                for (size_t p = 0; p < LATENCY_PHASE_COUNT; ++p)
+                {
+                    const LatencyPhase phase = static_cast<LatencyPhase>(p);
+                    const LatencyHistogram &h = histogram(endpoint, phase);
+                    if (!h.count())
+                        continue;
+                    const std::string labels =
+                        std::string("endpoint=\"") + endpointName +
+                        "\",phase=\"" + phaseName(phase) + "\"";
+                    for (const double q : quantiles)
+                        out << name << "{" << labels << ",quantile=\"" << q
+                            << "\"} " << seconds(h.quantile(q)) << "\n";
+                    out << name << "_sum{" << labels << "} "
+                        << seconds(h.sum()) << "\n"
+                        << name << "_count{" << labels << "} "
+                        << h.count() << "\n";
+                }
+            }
+        }
+
+        std::string prometheus() const
+        {
+            std::ostringstream out;
+            writePrometheus(out);
+            return out.str();
+        }
+
+        // Default metrics shared by all BitfinexAPI instances of the process
+        static std::shared_ptr<LatencyMetrics> shared()
+        {
+            static const auto metrics = std::make_shared<LatencyMetrics>();
+            return metrics;
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        struct EndpointHistograms
+        {
+            LatencyHistogram phases[LATENCY_PHASE_COUNT];
+        };
+
+        // Indexed by Endpoint, unknown last
+        std::atomic<EndpointHistograms*> endpoints_[ENDPOINT_COUNT + 1];
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        // Racing first requests allocate, one of them wins
+        EndpointHistograms& acquire(Endpoint endpoint)
+        {
+            auto &slot = endpoints_[static_cast<size_t>(endpoint)];
+            EndpointHistograms *histograms =
+                slot.load(std::memory_order_acquire);
+            if (histograms)
+                return *histograms;
+
+            std::unique_ptr<EndpointHistograms> created(
+                new EndpointHistograms);
+            if (slot.compare_exchange_strong(histograms, created.get(),
+                                             std::memory_order_acq_rel))
+                return *created.release();
+            return *histograms;
+        }
+
+        static double seconds(uint64_t micros) noexcept
+        { return static_cast<double>(micros) / 1e6; }
+    };
+}
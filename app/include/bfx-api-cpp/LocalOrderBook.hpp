@@ -0,0 +1,303 @@
+////////////////////////////////////////////////////////////////////////////////
+//  LocalOrderBook.hpp
+//
+//
+//  Bitfinex REST API C++ client - incrementally maintained order book
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// rapidjson Grisu2 shortest decimal digits
+#include "rapidjson/internal/dtoa.h"
+
+// internal responses
+#include "responses.hpp"
+
+namespace BfxAPI
+{
+
+    /// Order book kept in sync from /book/ snapshots and streamed deltas.
+    /// Each side is one contiguous array sorted so that the best level is
+    /// the last element: top of book is O(1), and the frequent updates close
+    /// to the top move only the few levels above them. Levels are looked up
+    /// by binary search on exact price, which is exact because prices are
+    /// decoded from the same decimal text every time. Not thread-safe.
+    class LocalOrderBook
+    {
+
+    public:
+
+        struct Level
+        {
+            double price;
+            double amount;
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        // maxDepth > 0 drops levels beyond maxDepth on each side, matching
+        // book channel subscribed with that length
+        explicit LocalOrderBook(size_t maxDepth = 0): maxDepth_(maxDepth) {}
+
+        ////////////////////////////////////////////////////////////////////////
+        // Updates
+        ////////////////////////////////////////////////////////////////////////
+
+        void clear() noexcept
+        {
+            bids_.clear();
+            asks_.clear();
+        }
+
+        // Replaces book, levels may come in any order
+        void applySnapshot(const OrderBook &book)
+        {
+            clear();
+            bids_.reserve(book.bids.size());
+            asks_.reserve(book.asks.size());
+            for (const auto &level : book.bids)
+            {
+                if (level.amount > 0)
+                    bids_.push_back({level.price, level.amount});
+            }
+            for (const auto &level : book.asks)
+            {
+                if (level.amount > 0)
+                    asks_.push_back({level.price, level.amount});
+            }
+            std::sort(bids_.begin(), bids_.end(), bidOrder);
+            std::sort(asks_.begin(), asks_.end(), askOrder);
+            truncate();
+        }
+
+        // Levels with zero amount are removed, others are inserted or
+        // replaced
+        void applyUpdate(const OrderBook &update)
+        {
+            for (const auto &level : update.bids)
+                set(bids_, level.price, level.amount, bidOrder);
+            for (const auto &level : update.asks)
+                set(asks_, level.price, level.amount, askOrder);
+            truncate();
+        }
+
+        // Signature of BitfinexStream::BookCallback without symbol
+        void apply(const OrderBook &book, bool snapshot)
+        {
+            if (snapshot)
+                applySnapshot(book);
+            else
+                applyUpdate(book);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Queries
+        ////////////////////////////////////////////////////////////////////////
+
+        bool empty() const noexcept { return bids_.empty() && asks_.empty(); }
+
+        size_t bidDepth() const noexcept { return bids_.size(); }
+        size_t askDepth() const noexcept { return asks_.size(); }
+
+        // Best level or nullptr when side is empty
+        const Level* bestBid() const noexcept
+        { return bids_.empty() ? nullptr : &bids_.back(); }
+
+        const Level* bestAsk() const noexcept
+        { return asks_.empty() ? nullptr : &asks_.back(); }
+
+        // Level i counted from best, i < bidDepth()
+        const Level& bid(size_t i) const noexcept
+        { return bids_[bids_.size() - 1 - i]; }
+
+        const Level& ask(size_t i) const noexcept
+        { return asks_[asks_.size() - 1 - i]; }
+
+        // 0 when either side is empty
+        double spread() const noexcept
+        {
+            return bids_.empty() || asks_.empty()
+                ? 0
+                : asks_.back().price - bids_.back().price;
+        }
+
+        double mid() const noexcept
+        {
+            return bids_.empty() || asks_.empty()
+                ? 0
+                : (asks_.back().price + bids_.back().price) / 2;
+        }
+
+        // Total amount of best levels count
+        double bidAmount(size_t levels) const noexcept
+        { return topAmount(bids_, levels); }
+
+        double askAmount(size_t levels) const noexcept
+        { return topAmount(asks_, levels); }
+
+        // Total amount of bids at price or higher
+        double bidAmountTo(double price) const noexcept
+        {
+            auto first = std::lower_bound(bids_.cbegin(), bids_.cend(),
+                                          Level{price, 0}, bidOrder);
+            return sum(first, bids_.cend());
+        }
+
+        // Total amount of asks at price or lower
+        double askAmountTo(double price) const noexcept
+        {
+            auto first = std::lower_bound(asks_.cbegin(), asks_.cend(),
+                                          Level{price, 0}, askOrder);
+            return sum(first, asks_.cend());
+        }
+
+        // Bitfinex book checksum of best levels, see "cs" messages of book
+        // channel: signed CRC32 of "bid:amount:ask:-amount:..." over levels
+        // interleaved from the best, numbers in shortest form.
+        int32_t checksum(size_t levels = 25) const
+        {
+            checksumBuffer_.clear();
+            for (size_t i = 0; i < levels; ++i)
+            {
+                if (i < bids_.size())
+                {
+                    appendNumber(bid(i).price);
+                    appendNumber(bid(i).amount);
+                }
+                if (i < asks_.size())
+                {
+                    appendNumber(ask(i).price);
+                    appendNumber(-ask(i).amount);
+                }
+            }
+            if (!checksumBuffer_.empty())
+                checksumBuffer_.pop_back();
+            return static_cast<int32_t>(crc32(checksumBuffer_.data(),
+                                              checksumBuffer_.size()));
+        }
+
+        // False means book is out of sync and should be resubscribed
+        bool verify(long long checksumValue, size_t levels = 25) const
+        { return checksum(levels) == static_cast<int32_t>(checksumValue); }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        // Best level last
+        std::vector<Level> bids_;   // ascending price
+        std::vector<Level> asks_;   // descending price
+        size_t maxDepth_;
+        mutable std::vector<char> checksumBuffer_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        static bool bidOrder(const Level &a, const Level &b) noexcept
+        { return a.price < b.price; }
+
+        static bool askOrder(const Level &a, const Level &b) noexcept
+        { return a.price > b.price; }
+
+        template <typename Order>
+        static void set(std::vector<Level> &side,
+                        double price,
+                        double amount,
+                        Order order)
+        {
+            auto it = std::lower_bound(side.begin(), side.end(),
+                                       Level{price, 0}, order);
+            const bool found = it != side.end() && it->price == price;
+            if (amount > 0)
+            {
+                if (found)
+                    it->amount = amount;
+                else
+                    side.insert(it, {price, amount});
+            }
+            else if (found)
+                side.erase(it);
+        }
+
+        // Drops worst levels, which are at the front
+        void truncate()
+        {
+            if (!maxDepth_)
+                return;
+            if (bids_.size() > maxDepth_)
+                bids_.erase(bids_.begin(),
+                            bids_.begin() + (bids_.size() - maxDepth_));
+            if (asks_.size() > maxDepth_)
+                asks_.erase(asks_.begin(),
+                            asks_.begin() + (asks_.size() - maxDepth_));
+        }
+
+        static double topAmount(const std::vector<Level> &side, size_t levels)
+        noexcept
+        {
+            levels = std::min(levels, side.size());
+            return sum(side.cend() - levels, side.cend());
+        }
+
+        static double sum(std::vector<Level>::const_iterator first,
+                          std::vector<Level>::const_iterator last) noexcept
+        {
+            double total = 0;
+            for (; first != last; ++first)
+                total += first->amount;
+            return total;
+        }
+
+        // Shortest round-trip form as written by the server, e.g. "100",
+        // "0.25", "1e-7", followed by ':'
+        void appendNumber(double value) const
+        {
+            char buffer[32];
+            char *end = buffer;
+            if (value == 0)
+                *end++ = '0';
+            else
+            {
+                end = rapidjson::internal::dtoa(value, buffer);
+                // Integral values without ".0"
+                if (end - buffer > 2 && end[-2] == '.' && end[-1] == '0')
+                    end -= 2;
+            }
+            checksumBuffer_.insert(checksumBuffer_.end(), buffer, end);
+            checksumBuffer_.push_back(':');
+        }
+
+        static uint32_t crc32(const char *data, size_t length) noexcept
+        {
+            static const auto table = []
+            {
+                std::vector<uint32_t> entries(256);
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    uint32_t c = i;
+                    for (int bit = 0; bit < 8; ++bit)
+                        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                    entries[i] = c;
+                }
+                return entries;
+            }();
+
+            uint32_t crc = 0xffffffffu;
+            for (size_t i = 0; i < length; ++i)
+                crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^
+                      (crc >> 8);
+            return crc ^ 0xffffffffu;
+        }
+    };
+}
@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+//  NonceGenerator.hpp
+//
+//
+//  Bitfinex REST API C++ client - strictly increasing request nonce
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+namespace BfxAPI
+{
+
+    /// Process-wide source of strictly increasing nonces shared by all
+    /// threads and BitfinexAPI instances. Nonces are microseconds since epoch,
+    /// bumped by one whenever the clock didn't advance or stepped backwards,
+    /// so two requests in the same millisecond never share a nonce. next() is
+    /// lock-free; with persistence enabled the high-water mark is stored
+    /// ahead of use so that nonces keep increasing across restarts. Failed
+    /// writes are reported once and retried by every next nonce until the
+    /// mark is stored again.
+    class NonceGenerator
+    {
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        // Nonces reserved by each write of persistence file (~1s of clock)
+        static constexpr unsigned long long PERSIST_RESERVE = 1000000ULL;
+
+    public:
+
+        static NonceGenerator& instance()
+        {
+            static NonceGenerator generator;
+            return generator;
+        }
+
+        NonceGenerator(const NonceGenerator&) = delete;
+        NonceGenerator& operator = (const NonceGenerator&) = delete;
+
+        unsigned long long next() noexcept
+        {
+            const auto now = clockMicroseconds();
+            auto last = last_.load(std::memory_order_relaxed);
+            unsigned long long nonce;
+            do
+            {
+                nonce = now > last ? now : last + 1;
+            }
+            while (!last_.compare_exchange_weak(last, nonce,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_relaxed));
+
+            if (nonce >= reserved_.load(std::memory_order_acquire))
+                reserve(nonce);
+
+            return nonce;
+        }
+
+        // Enables persistence of nonce high-water mark in path. Stored value
+        // seeds the generator so that nonces stay above those issued by
+        // previous runs even if the clock went backwards meanwhile.
+        void setPersistencePath(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(persistMutex_);
+            path_ = path;
+            persistFailed_ = false;
+
+            unsigned long long stored = 0;
+            std::ifstream inFile(path_);
+            if (inFile >> stored)
+            {
+                auto last = last_.load(std::memory_order_relaxed);
+                while (stored > last &&
+                       !last_.compare_exchange_weak(last, stored,
+                                                    std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed))
+                    ;
+            }
+            // Force write of new high-water mark on next nonce
+            reserved_.store(0, std::memory_order_release);
+        }
+
+    private:
+
+        std::atomic<unsigned long long> last_{0};
+        // Nonces below reserved_ are already covered by persistence file
+        std::atomic<unsigned long long> reserved_{~0ULL};
+        std::mutex persistMutex_;
+        std::string path_;
+        bool persistFailed_ = false;  // guarded by persistMutex_
+
+        NonceGenerator() {}
+
+        static unsigned long long clockMicroseconds() noexcept
+        {
+            using namespace std::chrono;
+
+            return duration_cast<microseconds>(
+                system_clock::now().time_since_epoch()).count();
+        }
+
+        // Slow path, taken about once per PERSIST_RESERVE nonces. Doesn't
+        // throw, reserved_ advances only once the new mark is written.
+        void reserve(unsigned long long nonce) noexcept
+        {
+            try
+            {
+                std::lock_guard<std::mutex> lock(persistMutex_);
+                if (path_.empty())
+                {
+                    reserved_.store(~0ULL, std::memory_order_release);
+                    return;
+                }
+                if (nonce < reserved_.load(std::memory_order_acquire))
+                    return;
+
+                const auto reserved = nonce + PERSIST_RESERVE;
+                std::ofstream outFile(path_, std::ofstream::trunc);
+                outFile << reserved << std::endl;
+                outFile.close();
+                if (outFile.fail())
+                {
+                    if (!persistFailed_)
+                        std::cerr << "Unable to persist nonce to " << path_
+                                  << std::endl;
+                    persistFailed_ = true;
+                    return;
+                }
+                persistFailed_ = false;
+                reserved_.store(reserved, std::memory_order_release);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Unable to persist nonce: " << e.what()
+                          << std::endl;
+            }
+        }
+    };
+}
@@ -0,0 +1,260 @@
+////////////////////////////////////////////////////////////////////////////////
+//  OrderCache.hpp
+//
+//
+//  Bitfinex REST API C++ client - own active orders kept from responses
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// internal responses
+#include "responses.hpp"
+
+namespace BfxAPI
+{
+
+    /// Active orders of one account as last reported by the exchange. Set
+    /// with BitfinexAPI::setOrderCache(), it is updated from every decoded
+    /// new order, replace, cancel and order status response, so the state
+    /// of own orders is known without polling /orders/. Fills and
+    /// cancellations made elsewhere (exchange side stops, other clients)
+    /// are only seen by reconciliation with a full /orders/ snapshot, which
+    /// BitfinexAPI::reconcileOrders() makes when needsReconcile(): after
+    /// reconcileInterval, or at once after a gap, i.e. an order request
+    /// whose outcome is unknown. Changes applied while the snapshot was in
+    /// flight are newer than it and survive it. Thread-safe.
+    class OrderCache
+    {
+
+    public:
+
+        using Clock = std::chrono::steady_clock;
+
+        // Counters since construction
+        struct Stats
+        {
+            uint64_t updates = 0;          // orders applied from responses
+            uint64_t reconciliations = 0;  // snapshots applied
+            uint64_t drift = 0;            // orders snapshot had to correct
+            uint64_t gaps = 0;             // markGap() calls
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        explicit OrderCache(Clock::duration reconcileInterval =
+                                std::chrono::seconds(30)):
+        interval_(reconcileInterval)
+        {}
+
+        OrderCache(const OrderCache&) = delete;
+        OrderCache& operator = (const OrderCache&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Updates
+        ////////////////////////////////////////////////////////////////////////
+
+        // Order state from new order or order status response; orders no
+        // longer live are removed
+        void apply(const Order &order)
+        {
+            if (!order.id)
+                return;
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.updates;
+            store(order, Clock::now());
+        }
+
+        // Order accepted by cancel or cancel multi request
+        void remove(long long orderId)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.updates;
+            erase(orderId, Clock::now());
+        }
+
+        // Order replaced by replacement of cancel/replace response
+        void replace(long long orderId, const Order &replacement)
+        {
+            const auto now = Clock::now();
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.updates;
+            erase(orderId, now);
+            if (replacement.id)
+                store(replacement, now);
+        }
+
+        // Every order cancelled by cancel all request
+        void clear()
+        {
+            const auto now = Clock::now();
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.updates;
+            for (const auto &entry : orders_)
+                removed_[entry.first] = now;
+            orders_.clear();
+        }
+
+        // Outcome of order request unknown (e.g. timeout), needsReconcile()
+        // is true until snapshot requested after at is applied
+        void markGap(Clock::time_point at = Clock::now()) noexcept
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!gap_ || at > gapAt_)
+                gapAt_ = at;
+            gap_ = true;
+            ++stats_.gaps;
+        }
+
+        // Replaces cache with complete /orders/ response to request sent
+        // at requested. Orders changed or removed since then keep their
+        // newer state.
+        void applySnapshot(const std::vector<Order> &active,
+                           Clock::time_point requested)
+        {
+            Orders orders;
+            orders.reserve(active.size());
+            for (const auto &order : active)
+                orders.emplace(order.id, Entry{order, requested});
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t drift = 0;
+            for (const auto &cached : orders_)
+            {
+                auto it = orders.find(cached.first);
+                if (cached.second.updated >= requested)
+                    orders[cached.first] = cached.second;
+                else if (it == orders.end() ||
+                         it->second.order.remainingAmount !=
+                         cached.second.order.remainingAmount)
+                    ++drift;
+            }
+            for (auto it = removed_.begin(); it != removed_.end();)
+            {
+                if (it->second >= requested)
+                {
+                    orders.erase(it->first);
+                    ++it;
+                }
+                else
+                    it = removed_.erase(it);
+            }
+            for (const auto &order : orders)
+            {
+                if (!orders_.count(order.first))
+                    ++drift;
+            }
+            orders_.swap(orders);
+            stats_.drift += drift;
+            ++stats_.reconciliations;
+            // Snapshot already in flight can't reflect request of later gap
+            if (gapAt_ < requested)
+                gap_ = false;
+            reconciled_ = requested;
+            synced_ = true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Queries
+        ////////////////////////////////////////////////////////////////////////
+
+        // False when order isn't known to be active
+        bool find(long long orderId, Order &out) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = orders_.find(orderId);
+            if (it == orders_.end())
+                return false;
+            out = it->second.order;
+            return true;
+        }
+
+        // Copy of active orders, of symbol only unless it's empty
+        std::vector<Order> activeOrders(const std::string &symbol = "") const
+        {
+            std::vector<Order> out;
+            std::lock_guard<std::mutex> lock(mutex_);
+            out.reserve(orders_.size());
+            for (const auto &entry : orders_)
+            {
+                if (symbol.empty() || entry.second.order.symbol == symbol)
+                    out.push_back(entry.second.order);
+            }
+            return out;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return orders_.size();
+        }
+
+        // True before the first snapshot, after gap and once
+        // reconcileInterval elapsed since last snapshot
+        bool needsReconcile(Clock::time_point now = Clock::now()) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return !synced_ || gap_ || now - reconciled_ >= interval_;
+        }
+
+        Stats stats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return stats_;
+        }
+
+    private:
+
+        struct Entry
+        {
+            Order order;
+            Clock::time_point updated;
+        };
+
+        using Orders = std::unordered_map<long long, Entry>;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        mutable std::mutex mutex_;
+        Orders orders_;
+        // Time of removals not yet covered by snapshot
+        std::unordered_map<long long, Clock::time_point> removed_;
+        Clock::duration interval_;
+        Clock::time_point reconciled_;
+        bool synced_ = false;
+        bool gap_ = false;
+        Clock::time_point gapAt_; // latest markGap() while gap_
+        Stats stats_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        // Caller holds mutex_
+        void store(const Order &order, Clock::time_point now)
+        {
+            if (order.isLive && !order.isCancelled)
+                orders_[order.id] = Entry{order, now};
+            else
+                erase(order.id, now);
+        }
+
+        void erase(long long orderId, Clock::time_point now)
+        {
+            orders_.erase(orderId);
+            removed_[orderId] = now;
+        }
+    };
+}
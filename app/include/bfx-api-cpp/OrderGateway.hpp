@@ -0,0 +1,457 @@
+////////////////////////////////////////////////////////////////////////////////
+//  OrderGateway.hpp
+//
+//
+//  Bitfinex REST API C++ client - order entry from dedicated I/O thread
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+// internal BitfinexAPI
+#include "BitfinexAPI.hpp"
+
+namespace BfxAPI
+{
+
+    // Destructive interference size, not reliably provided by C++14 libraries
+    constexpr size_t CACHE_LINE = 64;
+
+    /// Bounded lock-free queue of one producer thread and one consumer
+    /// thread. Capacity must be power of two. Head and tail live on separate
+    /// cache lines and each side keeps cached copy of the other one's index,
+    /// so push() and pop() touch shared line only when the cached index says
+    /// queue is full or empty. Neither allocates nor blocks.
+    template <typename T, size_t Capacity>
+    class SpscQueue
+    {
+
+        static_assert(Capacity && !(Capacity & (Capacity - 1)),
+                      "SpscQueue capacity must be power of two");
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "SpscQueue elements must be trivially copyable");
+
+        static constexpr size_t MASK = Capacity - 1;
+
+    public:
+
+        SpscQueue() = default;
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator = (const SpscQueue&) = delete;
+
+        // Producer side, false when queue is full
+        bool push(const T &value) noexcept
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - headCache_ == Capacity)
+            {
+                headCache_ = head_.load(std::memory_order_acquire);
+                if (tail - headCache_ == Capacity)
+                    return false;
+            }
+            slots_[tail & MASK] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Producer side, true when push() would fail
+        bool full() noexcept
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - headCache_ == Capacity)
+                headCache_ = head_.load(std::memory_order_acquire);
+            return tail - headCache_ == Capacity;
+        }
+
+        // Consumer side, false when queue is empty
+        bool pop(T &value) noexcept
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tailCache_)
+            {
+                tailCache_ = tail_.load(std::memory_order_acquire);
+                if (head == tailCache_)
+                    return false;
+            }
+            value = slots_[head & MASK];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        static constexpr size_t capacity() noexcept { return Capacity; }
+
+    private:
+
+        // Written by consumer
+        std::atomic<size_t> head_{0};
+        size_t tailCache_ = 0;
+        char consumerPad_[CACHE_LINE - sizeof(std::atomic<size_t>) -
+                          sizeof(size_t)];
+        // Written by producer
+        std::atomic<size_t> tail_{0};
+        size_t headCache_ = 0;
+        char producerPad_[CACHE_LINE - sizeof(std::atomic<size_t>) -
+                          sizeof(size_t)];
+        T slots_[Capacity];
+    };
+
+    enum class OrderAction : uint8_t
+    {
+        newOrder,
+        cancel,
+        replace
+    };
+
+    enum class OrderSide : uint8_t
+    {
+        buy,
+        sell
+    };
+
+    // "type" parameter of new order endpoint
+    enum class OrderType : uint8_t
+    {
+        market,
+        limit,
+        stop,
+        trailingStop,
+        fillOrKill,
+        exchangeMarket,
+        exchangeLimit,
+        exchangeStop,
+        exchangeTrailingStop,
+        exchangeFillOrKill
+    };
+
+    inline const string& orderSideName(OrderSide side)
+    {
+        static const string names[] = {"buy", "sell"};
+        return names[static_cast<size_t>(side)];
+    }
+
+    inline const string& orderTypeName(OrderType type)
+    {
+        static const string names[] =
+        {
+            "market",
+            "limit",
+            "stop",
+            "trailing-stop",
+            "fill-or-kill",
+            "exchange market",
+            "exchange limit",
+            "exchange stop",
+            "exchange trailing-stop",
+            "exchange fill-or-kill"
+        };
+        return names[static_cast<size_t>(type)];
+    }
+
+    /// Order entry request of strategy thread. Plain value so it's copied
+    /// into queue slot without allocation, symbol is interned id obtained
+    /// from BitfinexAPI::getSymbolId() beforehand.
+    struct OrderIntent
+    {
+        OrderAction action = OrderAction::newOrder;
+        OrderSide side = OrderSide::buy;
+        OrderType type = OrderType::exchangeLimit;
+        bool isHidden = false;
+        bool isPostOnly = false;     // new order only
+        bool useRemaining = false;   // replace only
+        uint64_t tag = 0;            // caller's id, returned in OrderAck
+        long long orderId = 0;       // cancel and replace
+        SymbolId symbol;             // new order and replace
+        double amount = 0;
+        double price = 0;
+        std::chrono::steady_clock::time_point submitted;
+
+        static OrderIntent newOrder(uint64_t tag,
+                                    SymbolId symbol,
+                                    double amount,
+                                    double price,
+                                    OrderSide side,
+                                    OrderType type) noexcept
+        {
+            OrderIntent intent;
+            intent.tag = tag;
+            intent.symbol = symbol;
+            intent.amount = amount;
+            intent.price = price;
+            intent.side = side;
+            intent.type = type;
+            return intent;
+        }
+
+        static OrderIntent cancel(uint64_t tag, long long orderId) noexcept
+        {
+            OrderIntent intent;
+            intent.action = OrderAction::cancel;
+            intent.tag = tag;
+            intent.orderId = orderId;
+            return intent;
+        }
+
+        static OrderIntent replace(uint64_t tag,
+                                   long long orderId,
+                                   SymbolId symbol,
+                                   double amount,
+                                   double price,
+                                   OrderSide side,
+                                   OrderType type) noexcept
+        {
+            OrderIntent intent = newOrder(tag, symbol, amount, price, side,
+                                          type);
+            intent.action = OrderAction::replace;
+            intent.orderId = orderId;
+            return intent;
+        }
+    };
+
+    /// Outcome of OrderIntent. Order fields are set when status is noError;
+    /// orderId is id of new order for newOrder and replace.
+    struct OrderAck
+    {
+        OrderAction action = OrderAction::newOrder;
+        BfxClientErrors status = noError;
+        long httpStatusCode = 0;
+        uint64_t tag = 0;
+        long long orderId = 0;
+        double price = 0;
+        double avgExecutionPrice = 0;
+        double remainingAmount = 0;
+        double executedAmount = 0;
+        bool isLive = false;
+        bool isCancelled = false;
+        long long queuedMicros = 0;  // from submit() to request start
+        long long totalMicros = 0;   // from submit() to acknowledgement
+    };
+
+    /// Order entry mode of BitfinexAPI: one I/O thread owns the connection
+    /// and signs and sends every order request, strategy threads hand over
+    /// intents through their own Channel and read acknowledgements from
+    /// it. Channel::submit() and Channel::poll() never block or allocate.
+    /// Intents of one channel are sent in submission order; channels are
+    /// served round robin. A channel with QUEUE_CAPACITY unread
+    /// acknowledgements is not served until its owner polls, so no
+    /// acknowledgement is ever dropped. The I/O thread may be pinned to a
+    /// CPU core with start(). api must outlive the gateway.
+    class OrderGateway
+    {
+
+    public:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        static constexpr size_t QUEUE_CAPACITY = 1024;
+        // Empty polls of I/O thread before it starts sleeping
+        static constexpr unsigned IDLE_SPINS = 1u << 14;
+        static constexpr long IDLE_SLEEP_US = 50;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Typedefs
+        ////////////////////////////////////////////////////////////////////////
+
+        // Queues of single strategy thread, the producer of intents and
+        // consumer of acknowledgements
+        class Channel
+        {
+
+        public:
+
+            // False when QUEUE_CAPACITY intents are waiting
+            bool submit(OrderIntent intent) noexcept
+            {
+                intent.submitted = std::chrono::steady_clock::now();
+                return intents_.push(intent);
+            }
+
+            // False when no acknowledgement is waiting
+            bool poll(OrderAck &ack) noexcept { return acks_.pop(ack); }
+
+        private:
+
+            friend class OrderGateway;
+
+            SpscQueue<OrderIntent, QUEUE_CAPACITY> intents_;
+            SpscQueue<OrderAck, QUEUE_CAPACITY> acks_;
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor - Destructor
+        ////////////////////////////////////////////////////////////////////////
+
+        explicit OrderGateway(const BitfinexAPI &api, size_t channels = 1):
+        api_(api)
+        {
+            for (size_t i = 0; i < (channels ? channels : 1); ++i)
+                channels_.emplace_back(new Channel);
+        }
+
+        ~OrderGateway() { stop(); }
+
+        OrderGateway(const OrderGateway&) = delete;
+        OrderGateway& operator = (const OrderGateway&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Public methods
+        ////////////////////////////////////////////////////////////////////////
+
+        // Channel i belongs to one strategy thread at a time
+        Channel& channel(size_t i = 0) { return *channels_.at(i); }
+
+        size_t channelCount() const noexcept { return channels_.size(); }
+
+        // Starts I/O thread, pinned to cpu unless it's negative. False when
+        // already running or pinning failed (thread runs unpinned then).
+        bool start(int cpu = -1)
+        {
+            if (running_.exchange(true))
+                return false;
+            thread_ = std::thread(&OrderGateway::run, this);
+            return cpu < 0 || pin(cpu);
+        }
+
+        // Finishes request in flight and joins I/O thread. Intents still
+        // queued are sent after next start().
+        void stop()
+        {
+            running_ = false;
+            if (thread_.joinable())
+                thread_.join();
+        }
+
+        bool isRunning() const noexcept { return running_; }
+
+        // Intents sent since construction
+        uint64_t sent() const noexcept { return sent_; }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        const BitfinexAPI &api_;
+        vector<std::unique_ptr<Channel>> channels_;
+        std::atomic<bool> running_{false};
+        std::atomic<uint64_t> sent_{0};
+        std::thread thread_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        void run()
+        {
+            unsigned idle = 0;
+            while (running_.load(std::memory_order_relaxed))
+            {
+                bool served = false;
+                for (auto &channel : channels_)
+                {
+                    OrderIntent intent;
+                    if (channel->acks_.full() ||
+                        !channel->intents_.pop(intent))
+                        continue;
+                    served = true;
+                    channel->acks_.push(send(intent));
+                    sent_.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (served)
+                    idle = 0;
+                else if (idle < IDLE_SPINS)
+                    ++idle;
+                else
+                    std::this_thread::sleep_for(std::chrono::microseconds(
+                        static_cast<long>(IDLE_SLEEP_US)));
+            }
+        }
+
+        OrderAck send(const OrderIntent &intent) const
+        {
+            using std::chrono::duration_cast;
+            using std::chrono::microseconds;
+
+            const auto started = std::chrono::steady_clock::now();
+            Result<Order> result;
+            if (intent.action == OrderAction::cancel)
+                result = api_.fetchCancelOrder(intent.orderId);
+            else if (!intent.symbol)
+                result.bfxApiStatusCode = badSymbol;
+            else if (intent.action == OrderAction::newOrder)
+                result = api_.fetchNewOrder(intent.symbol,
+                                            intent.amount,
+                                            intent.price,
+                                            orderSideName(intent.side),
+                                            orderTypeName(intent.type),
+                                            intent.isHidden,
+                                            intent.isPostOnly);
+            else
+                result = api_.fetchReplaceOrder(intent.orderId,
+                                                intent.symbol,
+                                                intent.amount,
+                                                intent.price,
+                                                orderSideName(intent.side),
+                                                orderTypeName(intent.type),
+                                                intent.isHidden,
+                                                intent.useRemaining);
+
+            OrderAck ack;
+            ack.action = intent.action;
+            ack.status = result.bfxApiStatusCode;
+            ack.httpStatusCode = result.httpStatusCode;
+            ack.tag = intent.tag;
+            ack.orderId = intent.orderId;
+            if (ack.status == noError)
+            {
+                const Order &order = result.data;
+                ack.orderId = order.id;
+                ack.price = order.price;
+                ack.avgExecutionPrice = order.avgExecutionPrice;
+                ack.remainingAmount = order.remainingAmount;
+                ack.executedAmount = order.executedAmount;
+                ack.isLive = order.isLive;
+                ack.isCancelled = order.isCancelled;
+            }
+            ack.queuedMicros = duration_cast<microseconds>(
+                started - intent.submitted).count();
+            ack.totalMicros = duration_cast<microseconds>(
+                std::chrono::steady_clock::now() - intent.submitted).count();
+            return ack;
+        }
+
+        bool pin(int cpu)
+        {
+            #ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (!pthread_setaffinity_np(thread_.native_handle(),
+                                        sizeof(set), &set))
+                return true;
+            cerr << "Unable to pin order gateway thread to CPU " << cpu
+                 << endl;
+            #else
+            cerr << "Thread pinning is not supported on this platform" << endl;
+            #endif
+            return false;
+        }
+    };
+}
@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////////////////
+//  PayloadWriter.hpp
+//
+//
+//  Bitfinex REST API C++ client - JSON payload of authenticated requests
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+
+// rapidjson integer formatting
+#include "rapidjson/internal/itoa.h"
+
+// internal Decimal
+#include "Decimal.hpp"
+
+namespace BfxAPI
+{
+
+    /// Builds {"request":...,"nonce":"...",...} payload of authenticated
+    /// endpoints directly into a thread-local buffer. Numbers are formatted
+    /// by Decimal and rapidjson itoa on the stack and the buffer keeps its capacity
+    /// between requests, so once warmed up writing a payload allocates
+    /// nothing. Only one writer per thread may be used at a time, str() stays
+    /// valid until next writer is created on the same thread.
+    class PayloadWriter
+    {
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        // Initial capacity of thread-local buffer
+        static constexpr size_t BUFFER_CAPACITY = 512;
+
+    public:
+
+        // Decimal places of quoted decimals, Bitfinex precision limit
+        static constexpr int DECIMAL_PLACES = Decimal::MAX_SCALE;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        PayloadWriter(const char *request, unsigned long long nonce):
+        buffer_(threadBuffer()),
+        needComma_(false),
+        closed_(false)
+        {
+            buffer_.clear();
+            buffer_ += '{';
+            text("request", request);
+            quotedInteger("nonce", nonce);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Object members
+        ////////////////////////////////////////////////////////////////////////
+
+        // "key":"value"
+        PayloadWriter& text(const char *key, const char *value)
+        {
+            writeKey(key);
+            writeString(value, std::char_traits<char>::length(value));
+            return *this;
+        }
+
+        PayloadWriter& text(const char *key, const std::string &value)
+        {
+            writeKey(key);
+            writeString(value.data(), value.size());
+            return *this;
+        }
+
+        // "key":true
+        PayloadWriter& boolean(const char *key, bool value)
+        {
+            writeKey(key);
+            buffer_ += value ? "true" : "false";
+            return *this;
+        }
+
+        // "key":123
+        PayloadWriter& integer(const char *key, long long value)
+        {
+            writeKey(key);
+            writeInteger(value);
+            return *this;
+        }
+
+        // "key":"123"
+        PayloadWriter& quotedInteger(const char *key, unsigned long long value)
+        {
+            char digits[24];
+            writeKey(key);
+            buffer_ += '"';
+            buffer_.append(digits, rapidjson::internal::u64toa(value, digits));
+            buffer_ += '"';
+            return *this;
+        }
+
+        // "key":"1.2345" rounded to at most DECIMAL_PLACES decimals, and to
+        // significant digits unless 0. Value out of Decimal range is written
+        // as "", which Bitfinex rejects, rather than as different number.
+        PayloadWriter& decimal(const char *key,
+                               double value,
+                               int significant = 0)
+        {
+            Decimal rounded;
+            if (Decimal::fromSignificant(value, significant, rounded,
+                                         DECIMAL_PLACES))
+                return decimal(key, rounded);
+            writeKey(key);
+            buffer_ += "\"\"";
+            return *this;
+        }
+
+        // "key":"1.2345" exactly as given
+        PayloadWriter& decimal(const char *key, const Decimal &value)
+        {
+            writeKey(key);
+            buffer_ += '"';
+            writeDecimal(value);
+            buffer_ += '"';
+            return *this;
+        }
+
+        // "key":json where json is already valid JSON value
+        PayloadWriter& raw(const char *key, const std::string &json)
+        {
+            writeKey(key);
+            buffer_ += json;
+            return *this;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Nested arrays and objects
+        ////////////////////////////////////////////////////////////////////////
+
+        PayloadWriter& beginArray(const char *key)
+        {
+            writeKey(key);
+            buffer_ += '[';
+            needComma_ = false;
+            return *this;
+        }
+
+        PayloadWriter& endArray()
+        {
+            buffer_ += ']';
+            needComma_ = true;
+            return *this;
+        }
+
+        // Array element object
+        PayloadWriter& beginObject()
+        {
+            writeSeparator();
+            buffer_ += '{';
+            needComma_ = false;
+            return *this;
+        }
+
+        PayloadWriter& endObject()
+        {
+            buffer_ += '}';
+            needComma_ = true;
+            return *this;
+        }
+
+        // Array element
+        PayloadWriter& integer(long long value)
+        {
+            writeSeparator();
+            writeInteger(value);
+            return *this;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Result
+        ////////////////////////////////////////////////////////////////////////
+
+        // Closes top level object on first call
+        const std::string& str()
+        {
+            if (!closed_)
+            {
+                buffer_ += '}';
+                closed_ = true;
+            }
+            return buffer_;
+        }
+
+    private:
+
+        std::string &buffer_;
+        bool needComma_;
+        bool closed_;
+
+        static std::string& threadBuffer()
+        {
+            thread_local std::string buffer;
+            if (buffer.capacity() < BUFFER_CAPACITY)
+                buffer.reserve(BUFFER_CAPACITY);
+            return buffer;
+        }
+
+        void writeSeparator()
+        {
+            if (needComma_)
+                buffer_ += ',';
+            needComma_ = true;
+        }
+
+        void writeKey(const char *key)
+        {
+            writeSeparator();
+            buffer_ += '"';
+            buffer_ += key;
+            buffer_ += "\":";
+        }
+
+        void writeString(const char *value, size_t length)
+        {
+            static constexpr char hexDigits[] = "0123456789abcdef";
+
+            buffer_ += '"';
+            for (size_t i = 0; i < length; ++i)
+            {
+                const unsigned char c = value[i];
+                if (c == '"' || c == '\\')
+                {
+                    buffer_ += '\\';
+                    buffer_ += c;
+                }
+                else if (c < 0x20)
+                {
+                    buffer_ += "\\u00";
+                    buffer_ += hexDigits[c >> 4];
+                    buffer_ += hexDigits[c & 0x0f];
+                }
+                else
+                    buffer_ += c;
+            }
+            buffer_ += '"';
+        }
+
+        void writeInteger(long long value)
+        {
+            char digits[24];
+            buffer_.append(digits, rapidjson::internal::i64toa(value, digits));
+        }
+
+        void writeDecimal(const Decimal &value)
+        {
+            char digits[Decimal::MAX_LENGTH];
+            buffer_.append(digits, value.write(digits));
+        }
+    };
+}
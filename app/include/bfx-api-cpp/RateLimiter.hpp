@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////////////////
+//  RateLimiter.hpp
+//
+//
+//  Bitfinex REST API C++ client - client side per endpoint rate limiting
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// internal RequestPriority, endpointInfo()
+#include "Endpoints.hpp"
+
+namespace BfxAPI
+{
+
+    /// Budget of single token bucket, requests per period seconds. Bucket
+    /// starts full so up to requests may be sent in a burst.
+    struct RateLimit
+    {
+        double requests;
+        double period;
+    };
+
+    /// Token bucket scheduler shared by all requests of the process. Request
+    /// paths are matched by the longest configured prefix to a bucket and a
+    /// priority lane; several prefixes may share one bucket. acquire() blocks
+    /// until the bucket has a token and no request of higher priority is
+    /// waiting for the same bucket, so requests are delayed to fit the budget
+    /// instead of being throttled by the server. Paths without rule are not
+    /// limited. All methods are thread-safe.
+    class RateLimiter
+    {
+
+    public:
+
+        using Clock = std::chrono::steady_clock;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        // Creates limiter with default Bitfinex v1 REST limits. Endpoints
+        // are routed to bucket and lane of endpoint table.
+        RateLimiter()
+        {
+            // Public endpoints, limited per IP
+            setBucket("pubticker", {30, 60});
+            setBucket("stats", {10, 60});
+            setBucket("lendbook", {45, 60});
+            setBucket("book", {60, 60});
+            setBucket("trades", {45, 60});
+            setBucket("lends", {45, 60});
+            setBucket("symbols", {5, 60});
+            setBucket("symbols_details", {5, 60});
+
+            // Authenticated endpoints share budget of API key, orders jump
+            // ahead of waiting history requests. Paths outside the table
+            // take the same budget.
+            setBucket("authenticated", {90, 60});
+            setRule("/", "authenticated");
+
+            for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+            {
+                const EndpointInfo &info =
+                    endpointInfo(static_cast<Endpoint>(i));
+                setRule(info.path, info.rateBucket, info.priority);
+            }
+        }
+
+        RateLimiter(const RateLimiter&) = delete;
+        RateLimiter& operator = (const RateLimiter&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Configuration
+        ////////////////////////////////////////////////////////////////////////
+
+        // Adds or replaces bucket budget, budget without positive finite rate
+        // (e.g. zero requests or period) disables it
+        void setBucket(const std::string &name, const RateLimit &limit)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto &bucket = buckets_[name];
+            bucket.limit = limit;
+            bucket.tokens = limit.requests;
+            bucket.refilled = Clock::now();
+        }
+
+        // Routes paths starting with prefix to bucket and priority lane
+        void setRule(const std::string &prefix,
+                     const std::string &bucket,
+                     RequestPriority priority = RequestPriority::normal)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rules_.erase(std::remove_if(rules_.begin(), rules_.end(),
+                                        [&prefix](const Rule &rule)
+                                        { return rule.prefix == prefix; }),
+                         rules_.end());
+            rules_.push_back({prefix, bucket, priority});
+            // Longest prefix first
+            std::stable_sort(rules_.begin(), rules_.end(),
+                             [](const Rule &a, const Rule &b)
+                             { return a.prefix.size() > b.prefix.size(); });
+        }
+
+        void clearRules()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rules_.clear();
+        }
+
+        void setEnabled(bool enabled) noexcept
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            enabled_ = enabled;
+            changed_.notify_all();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Scheduling
+        ////////////////////////////////////////////////////////////////////////
+
+        // Blocks until request on path fits its budget and takes a token
+        void acquire(const std::string &path)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            const Rule *rule = findRule(path);
+            Bucket *bucket = rule ? findBucket(rule->bucket) : nullptr;
+            if (!bucket)
+                return;
+
+            const auto lane = static_cast<size_t>(rule->priority);
+            ++bucket->waiting[lane];
+            Clock::duration wait;
+            while (enabled_ && !take(*bucket, lane, wait))
+                changed_.wait_for(lock, wait);
+            --bucket->waiting[lane];
+            changed_.notify_all();
+        }
+
+        // Takes token if available. Otherwise returns false and sets wait to
+        // the time after which a token may be available.
+        bool tryAcquire(const std::string &path, Clock::duration &wait)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const Rule *rule = findRule(path);
+            Bucket *bucket = rule ? findBucket(rule->bucket) : nullptr;
+            wait = Clock::duration::zero();
+            return !bucket || !enabled_ ||
+                   take(*bucket, static_cast<size_t>(rule->priority), wait);
+        }
+
+        // Default limiter shared by all BitfinexAPI instances of the process
+        static std::shared_ptr<RateLimiter> shared()
+        {
+            static const auto limiter = std::make_shared<RateLimiter>();
+            return limiter;
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private properties
+        ////////////////////////////////////////////////////////////////////////
+
+        static constexpr size_t LANES = 3;
+
+        struct Bucket
+        {
+            RateLimit limit{0, 0};
+            double tokens = 0;
+            Clock::time_point refilled;
+            size_t waiting[LANES] = {};
+        };
+
+        struct Rule
+        {
+            std::string prefix;
+            std::string bucket;
+            RequestPriority priority;
+        };
+
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::map<std::string, Bucket> buckets_;
+        std::vector<Rule> rules_;
+        bool enabled_ = true;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        const Rule* findRule(const std::string &path) const noexcept
+        {
+            for (const auto &rule : rules_)
+            {
+                if (!path.compare(0, rule.prefix.size(), rule.prefix))
+                    return &rule;
+            }
+            return nullptr;
+        }
+
+        // Null also for disabled bucket, take() needs rate above zero
+        Bucket* findBucket(const std::string &name) noexcept
+        {
+            auto it = buckets_.find(name);
+            if (it == buckets_.end())
+                return nullptr;
+            const RateLimit &limit = it->second.limit;
+            const double rate = limit.requests / limit.period;
+            return limit.requests > 0 && limit.period > 0 && rate > 0 &&
+                   std::isfinite(rate)
+                ? &it->second
+                : nullptr;
+        }
+
+        // Refills bucket and takes token unless higher lane is waiting
+        static bool take(Bucket &bucket, size_t lane, Clock::duration &wait)
+        {
+            using std::chrono::duration;
+            using std::chrono::duration_cast;
+
+            const auto now = Clock::now();
+            const double rate = bucket.limit.requests / bucket.limit.period;
+            const double elapsed =
+                duration<double>(now - bucket.refilled).count();
+            bucket.tokens = std::min(bucket.limit.requests,
+                                     bucket.tokens + elapsed * rate);
+            bucket.refilled = now;
+
+            bool preempted = false;
+            for (size_t higher = 0; higher < lane; ++higher)
+                preempted = preempted || bucket.waiting[higher];
+
+            if (!preempted && bucket.tokens >= 1)
+            {
+                bucket.tokens -= 1;
+                return true;
+            }
+
+            // Very slow bucket is checked again at least once a minute, so
+            // that wait stays in Clock::duration range
+            const double maxWait = 60;
+            const double missing = std::max(1 - bucket.tokens, 0.0);
+            wait = duration_cast<Clock::duration>(
+                duration<double>(std::min(missing / rate, maxWait)));
+            // Preempted lane rechecks once higher lane got its token
+            if (wait < std::chrono::milliseconds(1))
+                wait = std::chrono::milliseconds(1);
+            return false;
+        }
+    };
+}
@@ -0,0 +1,433 @@
+////////////////////////////////////////////////////////////////////////////////
+//  RecordReplay.hpp
+//
+//
+//  Bitfinex REST API C++ client - traffic recording and offline replay
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// POSIX truncate
+#include <sys/types.h>
+#include <unistd.h>
+
+// internal HTTPRequest, HTTPResponse
+#include "HTTPRequest.hpp"
+
+namespace BfxAPI {
+
+  // Recording file layout, all integers little endian:
+  //   "BFXREC1\n"
+  //   records of
+  //     u32 length of following record fields
+  //     u8 method, u32 curl code, u32 HTTP status
+  //     u64 microseconds since recording start, continued by appending
+  //         recorders
+  //     u32 network timings in LatencyPhase order (validate excluded)
+  //     u32 path, query, payload and body lengths followed by their bytes
+  // Truncated last record, e.g. after crash, is ignored by the reader and
+  // cut by the next recorder before it appends.
+  namespace recording {
+
+    constexpr char MAGIC[] = "BFXREC1\n";
+    constexpr size_t MAGIC_LENGTH = sizeof(MAGIC) - 1;
+    constexpr size_t TIMING_COUNT = LATENCY_PHASE_COUNT - 1;
+    // Length prefix and fields up to offset
+    constexpr size_t HEADER_LENGTH = 4 + 1 + 4 + 4 + 8;
+
+    inline void putU32(std::string &out, uint32_t value) {
+      for (int i = 0; i < 4; ++i)
+        out += static_cast<char>((value >> 8 * i) & 0xff);
+    }
+
+    inline void putU64(std::string &out, uint64_t value) {
+      for (int i = 0; i < 8; ++i)
+        out += static_cast<char>((value >> 8 * i) & 0xff);
+    }
+
+    // Reads little endian integer of size bytes, false past end
+    inline bool get(const char *&in, const char *end, size_t size,
+                    uint64_t &value) {
+      if (static_cast<size_t>(end - in) < size)
+        return false;
+      value = 0;
+      for (size_t i = 0; i < size; ++i)
+        value |= uint64_t(static_cast<unsigned char>(in[i])) << 8 * i;
+      in += size;
+      return true;
+    }
+
+    inline bool getString(const char *&in, const char *end, size_t size,
+                          std::string &value) {
+      if (static_cast<size_t>(end - in) < size)
+        return false;
+      value.assign(in, size);
+      in += size;
+      return true;
+    }
+
+  }
+
+  // Forwards requests to inner transport, e.g. HTTPRequest::curlTransport(),
+  // and appends every request/response pair to recording file. Records are
+  // flushed one by one, so the file stays readable while being written.
+  // Partial last record of existing file is cut first, files which aren't
+  // recordings are left untouched and not opened. Thread-safe.
+  class RecordingTransport: public Transport {
+
+    public:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Constructor
+      ////////////////////////////////////////////////////////////////////////
+
+      RecordingTransport(std::shared_ptr<Transport> inInner,
+                         const string &inPath):
+      inner(std::move(inInner)),
+      path(inPath),
+      started(std::chrono::steady_clock::now()) {
+        uint64_t lastOffset = 0;
+        if (!truncatePartialRecord(lastOffset))
+          return;
+        started -= std::chrono::microseconds(lastOffset);
+        file.open(path, std::ios::binary | std::ios::app);
+        if (!file.is_open()) {
+          cerr << "Unable to open recording file " << path << endl;
+          return;
+        }
+        file.seekp(0, std::ios::end);
+        if (file.tellp() == 0) {
+          file.write(recording::MAGIC, recording::MAGIC_LENGTH);
+          file.flush();
+        }
+      };
+
+      ////////////////////////////////////////////////////////////////////////
+      // Public methods
+      ////////////////////////////////////////////////////////////////////////
+
+      void perform(const TransportRequest &request,
+                   HTTPResponse &response) override {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        const auto sent = std::chrono::steady_clock::now();
+        inner->perform(request, response);
+        if (!file.is_open())
+          return;
+
+        thread_local string record;
+        record.clear();
+        record += static_cast<char>(request.method);
+        recording::putU32(record, static_cast<uint32_t>(
+          response.curlStatusCode));
+        recording::putU32(record, static_cast<uint32_t>(
+          response.httpStatusCode));
+        recording::putU64(record, static_cast<uint64_t>(
+          duration_cast<microseconds>(sent - started).count()));
+        for (size_t i = 0; i < recording::TIMING_COUNT; ++i)
+          recording::putU32(record, static_cast<uint32_t>(
+            response.timings.micros[i]));
+        const string *fields[] = {&request.path, &request.query,
+                                  &request.payload, &response.body};
+        for (const string *field : fields)
+          recording::putU32(record, static_cast<uint32_t>(field->size()));
+        for (const string *field : fields)
+          record += *field;
+
+        string length;
+        recording::putU32(length, static_cast<uint32_t>(record.size()));
+        std::lock_guard<std::mutex> lock(mutex);
+        file.write(length.data(), length.size());
+        file.write(record.data(), record.size());
+        file.flush();
+        ++recorded;
+      };
+
+      bool isOpen() const noexcept {
+        return file.is_open();
+      }
+
+      // Records written by this instance
+      size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return recorded;
+      }
+
+    private:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private properties
+      ////////////////////////////////////////////////////////////////////////
+
+      std::shared_ptr<Transport> inner;
+      string path;
+      std::chrono::steady_clock::time_point started;
+      mutable std::mutex mutex;
+      std::ofstream file;
+      size_t recorded = 0;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private methods
+      ////////////////////////////////////////////////////////////////////////
+
+      // Cuts trailing partial record, e.g. of interrupted recorder, so that
+      // records appended after it stay readable. lastOffset is offset of
+      // last complete record. False when file isn't recording file or
+      // can't be truncated.
+      bool truncatePartialRecord(uint64_t &lastOffset) const {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open())
+          return true;
+        const size_t length = static_cast<size_t>(in.tellg());
+        char magic[recording::MAGIC_LENGTH];
+        const size_t magicLength = std::min(length, sizeof magic);
+        in.seekg(0);
+        if (!in.read(magic, magicLength) ||
+            std::memcmp(magic, recording::MAGIC, magicLength)) {
+          cerr << path << " is not a recording file" << endl;
+          return false;
+        }
+
+        // Partial magic is written again
+        size_t end = magicLength == recording::MAGIC_LENGTH ? magicLength : 0;
+        char header[recording::HEADER_LENGTH];
+        while (end && end + sizeof header <= length &&
+               in.seekg(end) && in.read(header, sizeof header)) {
+          const char *fields = header;
+          uint64_t recordLength = 0, offset = 0;
+          recording::get(fields, header + sizeof header, 4, recordLength);
+          if (recordLength < sizeof header - 4 ||
+              recordLength > length - end - 4)
+            break;
+          fields += 1 + 4 + 4;
+          recording::get(fields, header + sizeof header, 8, offset);
+          lastOffset = std::max(lastOffset, offset);
+          end += 4 + recordLength;
+        }
+        in.close();
+
+        if (end == length || !::truncate(path.c_str(), static_cast<off_t>(end)))
+          return true;
+        cerr << "Unable to truncate partial record of recording file "
+             << path << endl;
+        return false;
+      };
+
+  };
+
+  // Serves recorded responses without network. Requests are matched by
+  // method, path and query, or by method and path alone when query differs
+  // (e.g. timestamps). Responses recorded for the same request are served
+  // in recorded order and cycled, so a short recording drives load tests of
+  // any length. Paced replay repeats the recorded timeline once per cycle.
+  // Lookup is lock-free, thread-safe.
+  class ReplayTransport: public Transport {
+
+    public:
+
+      enum class Pace {
+        fullSpeed,  // respond immediately with recorded timings
+        recorded    // respond when response completed in recording, counted
+                    // from construction of ReplayTransport
+      };
+
+      ////////////////////////////////////////////////////////////////////////
+      // Constructor
+      ////////////////////////////////////////////////////////////////////////
+
+      explicit ReplayTransport(const string &inPath,
+                               Pace inPace = Pace::fullSpeed):
+      pace(inPace) {
+        load(inPath);
+        started = std::chrono::steady_clock::now();
+      };
+
+      ////////////////////////////////////////////////////////////////////////
+      // Public methods
+      ////////////////////////////////////////////////////////////////////////
+
+      void perform(const TransportRequest &request,
+                   HTTPResponse &response) override {
+        string key = requestKey(request.method, request.path);
+        const size_t pathKeyLength = key.size();
+        key += '?';
+        key += request.query;
+
+        Responses *found = lookup(exact, key);
+        if (!found) {
+          key.resize(pathKeyLength);
+          found = lookup(byPath, key);
+        }
+        if (!found) {
+          cerr << "No recorded response for " << request.path << endl;
+          response.curlStatusCode = CURLE_COULDNT_CONNECT;
+          return;
+        }
+
+        Responses &responses = *found;
+        const size_t served =
+          responses.next.fetch_add(1, std::memory_order_relaxed);
+        const Record &record = records[responses.indices[
+          served % responses.indices.size()]];
+        if (pace == Pace::recorded)
+          std::this_thread::sleep_until(started + std::chrono::microseconds(
+            served / responses.indices.size() * duration + record.offset +
+            record.timings[static_cast<size_t>(LatencyPhase::total)]));
+
+        response.body = record.body;
+        response.curlStatusCode = static_cast<CURLcode>(record.curlCode);
+        response.httpStatusCode = record.httpStatus;
+        for (size_t i = 0; i < recording::TIMING_COUNT; ++i)
+          response.timings.micros[i] = record.timings[i];
+      };
+
+      // Number of loaded records, 0 when file is missing or invalid
+      size_t size() const noexcept {
+        return records.size();
+      }
+
+    private:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private properties
+      ////////////////////////////////////////////////////////////////////////
+
+      struct Record {
+        HTTPMethod method;
+        uint32_t curlCode;
+        long httpStatus;
+        uint64_t offset;  // from first record
+        long long timings[recording::TIMING_COUNT];
+        string path, query, payload, body;
+      };
+
+      // Records of one request and position of the next one to serve
+      struct Responses {
+        vector<size_t> indices;
+        std::atomic<size_t> next{0};
+      };
+
+      using Index = std::unordered_map<string, std::unique_ptr<Responses>>;
+
+      Pace pace;
+      std::chrono::steady_clock::time_point started;
+      uint64_t duration = 0;  // of recording [us], until last completion
+      vector<Record> records;
+      Index exact;
+      Index byPath;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private methods
+      ////////////////////////////////////////////////////////////////////////
+
+      static string requestKey(HTTPMethod method, const string &inPath) {
+        string key(1, method == HTTPMethod::get ? 'G' : 'P');
+        key += inPath;
+        return key;
+      };
+
+      void load(const string &inPath) {
+        std::ifstream file(inPath, std::ios::binary);
+        if (!file.is_open()) {
+          cerr << "Unable to open recording file " << inPath << endl;
+          return;
+        }
+        const string content((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+        if (content.compare(0, recording::MAGIC_LENGTH, recording::MAGIC)) {
+          cerr << inPath << " is not a recording file" << endl;
+          return;
+        }
+
+        const char *in = content.data() + recording::MAGIC_LENGTH;
+        const char *end = content.data() + content.size();
+        uint64_t length = 0;
+        while (recording::get(in, end, 4, length)) {
+          if (static_cast<uint64_t>(end - in) < length ||
+              !parse(in, in + length)) {
+            cerr << "Truncated record ignored in " << inPath << endl;
+            break;
+          }
+          in += length;
+        }
+
+        uint64_t first = UINT64_MAX;
+        for (const Record &record : records)
+          first = std::min(first, record.offset);
+        for (Record &record : records) {
+          record.offset -= first;
+          duration = std::max(duration, record.offset + static_cast<uint64_t>(
+            record.timings[static_cast<size_t>(LatencyPhase::total)]));
+        }
+
+        for (size_t i = 0; i < records.size(); ++i) {
+          const Record &record = records[i];
+          const string pathKey = requestKey(record.method, record.path);
+          add(byPath, pathKey, i);
+          add(exact, pathKey + "?" + record.query, i);
+        }
+      };
+
+      bool parse(const char *in, const char *end) {
+        Record record;
+        uint64_t value = 0, lengths[4];
+        if (!recording::get(in, end, 1, value))
+          return false;
+        record.method = static_cast<HTTPMethod>(value);
+        if (!recording::get(in, end, 4, value))
+          return false;
+        record.curlCode = static_cast<uint32_t>(value);
+        if (!recording::get(in, end, 4, value))
+          return false;
+        record.httpStatus = static_cast<long>(value);
+        if (!recording::get(in, end, 8, record.offset))
+          return false;
+        for (auto &timing : record.timings) {
+          if (!recording::get(in, end, 4, value))
+            return false;
+          timing = static_cast<long long>(value);
+        }
+        for (auto &fieldLength : lengths) {
+          if (!recording::get(in, end, 4, fieldLength))
+            return false;
+        }
+        if (!recording::getString(in, end, lengths[0], record.path) ||
+            !recording::getString(in, end, lengths[1], record.query) ||
+            !recording::getString(in, end, lengths[2], record.payload) ||
+            !recording::getString(in, end, lengths[3], record.body))
+          return false;
+        records.push_back(std::move(record));
+        return true;
+      };
+
+      static Responses* lookup(const Index &index, const string &key) {
+        auto it = index.find(key);
+        return it == index.end() ? nullptr : it->second.get();
+      };
+
+      static void add(Index &index, const string &key, size_t record) {
+        auto &responses = index[key];
+        if (!responses)
+          responses.reset(new Responses);
+        responses->indices.push_back(record);
+      };
+
+  };
+
+}
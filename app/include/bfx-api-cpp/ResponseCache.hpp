@@ -0,0 +1,240 @@
+////////////////////////////////////////////////////////////////////////////////
+//  ResponseCache.hpp
+//
+//
+//  Bitfinex REST API C++ client - TTL cache of slow-changing responses
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace BfxAPI
+{
+
+    /// In-memory cache of responses of slow-changing endpoints, e.g.
+    /// /symbols/, with per endpoint TTL matched by longest path prefix.
+    /// Expired entries carrying ETag or Last-Modified are kept for
+    /// conditional revalidation. Public entries can be persisted in an
+    /// on-disk snapshot so that cold start doesn't wait on the network.
+    /// Thread-safe.
+    class ResponseCache
+    {
+
+    public:
+
+        using Clock = std::chrono::system_clock;
+
+        /// Cached response
+        struct Entry
+        {
+            std::string body;
+            std::string etag;
+            std::string lastModified;
+            Clock::time_point storedAt;
+            bool persistent = true;
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        // Creates cache with default TTLs of Bitfinex metadata endpoints
+        ResponseCache()
+        {
+            setTTL("/symbols/", std::chrono::hours(1));
+            setTTL("/symbols_details/", std::chrono::hours(1));
+            setTTL("/account_fees/", std::chrono::hours(1));
+        }
+
+        ResponseCache(const ResponseCache&) = delete;
+        ResponseCache& operator = (const ResponseCache&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Configuration
+        ////////////////////////////////////////////////////////////////////////
+
+        // Paths starting with prefix are cached for ttl, zero ttl disables
+        void setTTL(const std::string &prefix, std::chrono::seconds ttl)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rules_.erase(std::remove_if(rules_.begin(), rules_.end(),
+                                        [&prefix](const Rule &rule)
+                                        { return rule.prefix == prefix; }),
+                         rules_.end());
+            rules_.push_back({prefix, ttl});
+            std::stable_sort(rules_.begin(), rules_.end(),
+                             [](const Rule &a, const Rule &b)
+                             { return a.prefix.size() > b.prefix.size(); });
+        }
+
+        std::chrono::seconds getTTL(const std::string &path) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return ttl(path);
+        }
+
+        // Loads snapshot from path if it exists and persists public entries
+        // there on every change
+        void setSnapshotPath(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            snapshotPath_ = path;
+            loadSnapshot();
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.clear();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Lookup and store
+        ////////////////////////////////////////////////////////////////////////
+
+        // Finds entry of key (request URL) requested on path. Returns true
+        // and sets fresh when entry exists, expired entries are returned
+        // only when they can be revalidated.
+        bool lookup(const std::string &path,
+                    const std::string &key,
+                    Entry &out,
+                    bool &fresh) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it == entries_.end())
+                return false;
+
+            fresh = Clock::now() - it->second.storedAt < ttl(path);
+            if (!fresh && it->second.etag.empty() &&
+                it->second.lastModified.empty())
+                return false;
+            out = it->second;
+            return true;
+        }
+
+        void store(const std::string &key, Entry entry)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entry.storedAt = Clock::now();
+            const bool persistent = entry.persistent;
+            entries_[key] = std::move(entry);
+            if (persistent)
+                saveSnapshot();
+        }
+
+        // Marks entry revalidated by 304 Not Modified response as fresh
+        void refresh(const std::string &key)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it == entries_.end())
+                return;
+            it->second.storedAt = Clock::now();
+            if (it->second.persistent)
+                saveSnapshot();
+        }
+
+        // Default cache shared by all BitfinexAPI instances of the process
+        static std::shared_ptr<ResponseCache> shared()
+        {
+            static const auto cache = std::make_shared<ResponseCache>();
+            return cache;
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private properties
+        ////////////////////////////////////////////////////////////////////////
+
+        struct Rule
+        {
+            std::string prefix;
+            std::chrono::seconds ttl;
+        };
+
+        mutable std::mutex mutex_;
+        std::vector<Rule> rules_;
+        std::unordered_map<std::string, Entry> entries_;
+        std::string snapshotPath_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        std::chrono::seconds ttl(const std::string &path) const noexcept
+        {
+            for (const auto &rule : rules_)
+            {
+                if (!path.compare(0, rule.prefix.size(), rule.prefix))
+                    return rule.ttl;
+            }
+            return std::chrono::seconds::zero();
+        }
+
+        // Snapshot record: key, etag, last modified and store time lines
+        // followed by body length line and body
+        void saveSnapshot() const
+        {
+            if (snapshotPath_.empty())
+                return;
+
+            const std::string tmpPath = snapshotPath_ + ".tmp";
+            {
+                std::ofstream outFile(tmpPath,
+                                      std::ofstream::binary |
+                                      std::ofstream::trunc);
+                for (const auto &item : entries_)
+                {
+                    const Entry &entry = item.second;
+                    if (!entry.persistent)
+                        continue;
+                    outFile << item.first << '\n'
+                            << entry.etag << '\n'
+                            << entry.lastModified << '\n'
+                            << Clock::to_time_t(entry.storedAt) << '\n'
+                            << entry.body.size() << '\n'
+                            << entry.body << '\n';
+                }
+                if (!outFile)
+                    return;
+            }
+            std::rename(tmpPath.c_str(), snapshotPath_.c_str());
+        }
+
+        void loadSnapshot()
+        {
+            std::ifstream inFile(snapshotPath_, std::ifstream::binary);
+            std::string key;
+            while (std::getline(inFile, key))
+            {
+                Entry entry;
+                std::time_t storedAt;
+                size_t length;
+                std::getline(inFile, entry.etag);
+                std::getline(inFile, entry.lastModified);
+                if (!(inFile >> storedAt >> length) || inFile.get() != '\n')
+                    break;
+                entry.body.resize(length);
+                if (length && !inFile.read(&entry.body[0], length))
+                    break;
+                inFile.ignore(1);
+                entry.storedAt = Clock::from_time_t(storedAt);
+                entries_.emplace(key, std::move(entry));
+            }
+        }
+    };
+}
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+//  RetryPolicy.hpp
+//
+//
+//  Bitfinex REST API C++ client - retry and hedging of idempotent requests
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+// curl
+#include <curl/curl.h>
+
+namespace BfxAPI
+{
+
+    /// Retry and hedging behaviour of idempotent GET requests
+    struct RetryPolicy
+    {
+        unsigned maxRetries = 2;        // attempts after the first one
+        long initialBackoffMs = 100;    // backoff before first retry
+        long maxBackoffMs = 2000;       // backoff cap
+        double backoffMultiplier = 2;   // backoff growth per retry
+        bool hedge = false;             // send second request when slow
+        long hedgeDelayMs = 0;          // 0 uses observed p95 latency
+        long hedgeFallbackMs = 500;     // delay until enough latency samples
+    };
+
+    /// Per endpoint retry policies matched by longest path prefix, with
+    /// recent latency samples of each endpoint used to pick hedging delay.
+    /// Thread-safe.
+    class RetryPolicies
+    {
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        // Latency samples kept per rule
+        static constexpr size_t SAMPLES = 128;
+        // Samples required before p95 is trusted
+        static constexpr size_t MIN_SAMPLES = 20;
+
+    public:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Configuration
+        ////////////////////////////////////////////////////////////////////////
+
+        // Policy of paths without own rule
+        void setDefault(const RetryPolicy &policy)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            default_.policy = policy;
+        }
+
+        // Policy of paths starting with prefix, e.g. "/book/"
+        void set(const std::string &prefix, const RetryPolicy &policy)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto &rule : rules_)
+            {
+                if (rule.prefix == prefix)
+                {
+                    rule.policy = policy;
+                    return;
+                }
+            }
+            rules_.push_back(Rule());
+            rules_.back().prefix = prefix;
+            rules_.back().policy = policy;
+            std::stable_sort(rules_.begin(), rules_.end(),
+                             [](const Rule &a, const Rule &b)
+                             { return a.prefix.size() > b.prefix.size(); });
+        }
+
+        RetryPolicy get(const std::string &path) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return find(path).policy;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Decisions
+        ////////////////////////////////////////////////////////////////////////
+
+        // Transient transport failures and server side errors worth retrying
+        static bool isRetryable(CURLcode curlCode, long httpCode) noexcept
+        {
+            switch (curlCode)
+            {
+                case CURLE_OK:
+                    return httpCode == 429 || httpCode >= 500;
+                case CURLE_COULDNT_RESOLVE_HOST:
+                case CURLE_COULDNT_CONNECT:
+                case CURLE_OPERATION_TIMEDOUT:
+                case CURLE_SSL_CONNECT_ERROR:
+                case CURLE_SEND_ERROR:
+                case CURLE_RECV_ERROR:
+                case CURLE_GOT_NOTHING:
+                case CURLE_PARTIAL_FILE:
+                case CURLE_HTTP2:
+                case CURLE_HTTP2_STREAM:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Exponential backoff before retry number attempt (1 based) with
+        // "equal jitter": half fixed, half uniformly random
+        static std::chrono::milliseconds backoff(const RetryPolicy &policy,
+                                                 unsigned attempt)
+        {
+            thread_local std::minstd_rand random{std::random_device{}()};
+
+            double delay = static_cast<double>(policy.initialBackoffMs);
+            for (unsigned i = 1; i < attempt; ++i)
+                delay *= policy.backoffMultiplier;
+            delay = std::min(delay, static_cast<double>(policy.maxBackoffMs));
+
+            std::uniform_real_distribution<double> jitter(0, delay / 2);
+            return std::chrono::milliseconds(
+                static_cast<long long>(delay / 2 + jitter(random)));
+        }
+
+        // Delay after which hedged request is sent
+        long hedgeDelayMs(const std::string &path) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const Rule &rule = find(path);
+            if (rule.policy.hedgeDelayMs > 0)
+                return rule.policy.hedgeDelayMs;
+            if (rule.samples.size() < MIN_SAMPLES)
+                return rule.policy.hedgeFallbackMs;
+
+            std::vector<long> sorted(rule.samples);
+            auto p95 = sorted.begin() + sorted.size() * 95 / 100;
+            std::nth_element(sorted.begin(), p95, sorted.end());
+            return std::max(*p95, 1L);
+        }
+
+        // Records latency of successful request
+        void recordLatency(const std::string &path, long latencyMs)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Rule &rule = find(path);
+            if (rule.samples.size() < SAMPLES)
+                rule.samples.push_back(latencyMs);
+            else
+                rule.samples[rule.next++ % SAMPLES] = latencyMs;
+        }
+
+    private:
+
+        struct Rule
+        {
+            std::string prefix;
+            RetryPolicy policy;
+            std::vector<long> samples;
+            size_t next = 0;
+        };
+
+        mutable std::mutex mutex_;
+        std::vector<Rule> rules_;
+        Rule default_;
+
+        const Rule& find(const std::string &path) const noexcept
+        {
+            for (const auto &rule : rules_)
+            {
+                if (!path.compare(0, rule.prefix.size(), rule.prefix))
+                    return rule;
+            }
+            return default_;
+        }
+
+        Rule& find(const std::string &path) noexcept
+        {
+            return const_cast<Rule&>(
+                static_cast<const RetryPolicies*>(this)->find(path));
+        }
+    };
+}
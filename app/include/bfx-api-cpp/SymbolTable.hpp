@@ -0,0 +1,346 @@
+////////////////////////////////////////////////////////////////////////////////
+//  SymbolTable.hpp
+//
+//
+//  Bitfinex REST API C++ client - interned symbols and currencies
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// internal endpoint table
+#include "Endpoints.hpp"
+
+namespace BfxAPI
+{
+
+    template <typename Tag>
+    class InternTable;
+
+    namespace detail
+    {
+        struct InternedEntry
+        {
+            std::string name;
+            uint32_t index;
+            // Request paths of parameterized endpoints, e.g. "/book/btcusd"
+            std::string paths[PARAMETERIZED_ENDPOINT_COUNT];
+        };
+    }
+
+    /// Handle of name interned by InternTable<Tag>. Comparison and hashing
+    /// are pointer operations and request paths are precomputed, so calls
+    /// taking ids do no string hashing or concatenation. Default constructed
+    /// id is invalid, accessors other than valid() require valid id.
+    template <typename Tag>
+    class InternedId
+    {
+
+    public:
+
+        constexpr InternedId() noexcept: entry_(nullptr) {}
+
+        bool valid() const noexcept { return entry_ != nullptr; }
+        explicit operator bool() const noexcept { return valid(); }
+
+        const std::string& name() const noexcept { return entry_->name; }
+
+        // Position in table, dense from 0 to table size
+        uint32_t index() const noexcept { return entry_->index; }
+
+        // Path of parameterized endpoint followed by name
+        const std::string& path(Endpoint endpoint) const noexcept
+        { return entry_->paths[static_cast<size_t>(endpoint)]; }
+
+        friend bool operator == (InternedId a, InternedId b) noexcept
+        { return a.entry_ == b.entry_; }
+
+        friend bool operator != (InternedId a, InternedId b) noexcept
+        { return a.entry_ != b.entry_; }
+
+    private:
+
+        friend class InternTable<Tag>;
+        friend struct std::hash<InternedId>;
+
+        explicit InternedId(const detail::InternedEntry *entry) noexcept:
+        entry_(entry)
+        {}
+
+        const detail::InternedEntry *entry_;
+    };
+
+    /// Immutable set of names with perfect hash lookup: names are
+    /// distributed into buckets, every bucket gets displacement which sends
+    /// its names to free slots (hash and displace). find() costs one hash,
+    /// two array reads and one string comparison. Ids point into the table,
+    /// so it is movable but not copyable. Thread-safe, it's never modified.
+    template <typename Tag>
+    class InternTable
+    {
+
+        ////////////////////////////////////////////////////////////////////////
+        // Class constants
+        ////////////////////////////////////////////////////////////////////////
+
+        // Displacements tried per bucket before table grows
+        static constexpr uint32_t MAX_DISPLACEMENT = 1u << 16;
+
+    public:
+
+        using Id = InternedId<Tag>;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructors
+        ////////////////////////////////////////////////////////////////////////
+
+        InternTable() = default;
+
+        // names may be any container of strings, duplicates are ignored
+        template <typename Container>
+        explicit InternTable(const Container &names)
+        {
+            std::vector<std::string> sorted(names.begin(), names.end());
+            std::sort(sorted.begin(), sorted.end());
+            sorted.erase(std::unique(sorted.begin(), sorted.end()),
+                         sorted.end());
+
+            entries_.resize(sorted.size());
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                auto &entry = entries_[i];
+                entry.name = std::move(sorted[i]);
+                entry.index = static_cast<uint32_t>(i);
+                for (size_t e = 0; e < PARAMETERIZED_ENDPOINT_COUNT; ++e)
+                    entry.paths[e] =
+                    endpointInfo(static_cast<Endpoint>(e)).path + entry.name;
+            }
+            build();
+        }
+
+        InternTable(InternTable&&) = default;
+        InternTable& operator = (InternTable&&) = default;
+
+        InternTable(const InternTable&) = delete;
+        InternTable& operator = (const InternTable&) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Lookup
+        ////////////////////////////////////////////////////////////////////////
+
+        // Invalid id when name isn't in the table
+        Id find(const char *name, size_t length) const noexcept
+        {
+            if (entries_.empty())
+                return Id();
+
+            const uint64_t h = hash(name, length);
+            const uint32_t slot = slots_[
+                this->slot(h, displacements_[bucket(h)])];
+            if (slot && matches(entries_[slot - 1], name, length))
+                return Id(&entries_[slot - 1]);
+            for (const uint32_t index : overflow_)
+            {
+                if (matches(entries_[index], name, length))
+                    return Id(&entries_[index]);
+            }
+            return Id();
+        }
+
+        Id find(const std::string &name) const noexcept
+        { return find(name.data(), name.size()); }
+
+        bool contains(const std::string &name) const noexcept
+        { return find(name).valid(); }
+
+        size_t size() const noexcept { return entries_.size(); }
+        bool empty() const noexcept { return entries_.empty(); }
+
+        // Id of index < size()
+        Id at(size_t index) const noexcept { return Id(&entries_[index]); }
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private properties
+        ////////////////////////////////////////////////////////////////////////
+
+        std::vector<detail::InternedEntry> entries_;
+        // Per bucket displacement, power of two size
+        std::vector<uint32_t> displacements_;
+        // Entry index + 1 or 0 for free slot, power of two size
+        std::vector<uint32_t> slots_;
+        // Entries without slot, only when 64 bit hashes collide
+        std::vector<uint32_t> overflow_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        // Eight bytes per step, names are mostly shorter than that
+        static uint64_t hash(const char *name, size_t length) noexcept
+        {
+            uint64_t h = length * 0x9e3779b97f4a7c15u;
+            for (; length >= 8; name += 8, length -= 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, name, 8);
+                h = (h ^ word) * 0xbf58476d1ce4e5b9u;
+                h ^= h >> 31;
+            }
+            uint64_t word = 0;
+            for (size_t i = 0; i < length; ++i)
+                word |= uint64_t(static_cast<unsigned char>(name[i])) << 8 * i;
+            return mix(h ^ word);
+        }
+
+        // splitmix64 finalizer
+        static uint64_t mix(uint64_t h) noexcept
+        {
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9u;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111ebu;
+            return h ^ (h >> 31);
+        }
+
+        size_t bucket(uint64_t h) const noexcept
+        { return (h >> 32) & (displacements_.size() - 1); }
+
+        size_t slot(uint64_t h, uint32_t displacement) const noexcept
+        {
+            return mix(h + displacement * 0x9e3779b97f4a7c15u) &
+                   (slots_.size() - 1);
+        }
+
+        static bool matches(const detail::InternedEntry &entry,
+                            const char *name,
+                            size_t length) noexcept
+        {
+            return entry.name.size() == length &&
+                   !std::memcmp(entry.name.data(), name, length);
+        }
+
+        static size_t powerOfTwo(size_t minimum) noexcept
+        {
+            size_t size = 1;
+            while (size < minimum)
+                size <<= 1;
+            return size;
+        }
+
+        // Places largest buckets first, while most slots are free. Slots
+        // are twice the names so displacement is found in a few tries.
+        void build()
+        {
+            if (entries_.empty())
+                return;
+
+            std::vector<uint64_t> hashes(entries_.size());
+            for (size_t i = 0; i < entries_.size(); ++i)
+                hashes[i] = hash(entries_[i].name.data(),
+                                 entries_[i].name.size());
+
+            for (size_t slotCount = powerOfTwo(2 * entries_.size());;
+                 slotCount *= 2)
+            {
+                displacements_.assign(powerOfTwo(entries_.size()), 0);
+                slots_.assign(slotCount, 0);
+                overflow_.clear();
+
+                std::vector<std::vector<uint32_t>> buckets(
+                    displacements_.size());
+                for (size_t i = 0; i < entries_.size(); ++i)
+                    buckets[bucket(hashes[i])].push_back(
+                        static_cast<uint32_t>(i));
+                std::stable_sort(buckets.begin(), buckets.end(),
+                                 [](const std::vector<uint32_t> &a,
+                                    const std::vector<uint32_t> &b)
+                                 { return a.size() > b.size(); });
+
+                bool placed = true;
+                for (const auto &members : buckets)
+                {
+                    if (members.empty())
+                        break;
+                    if (!place(members, hashes))
+                    {
+                        placed = false;
+                        break;
+                    }
+                }
+                // Give up growing when names can't be separated by hash
+                if (placed || slotCount >= 64 * entries_.size())
+                {
+                    if (!placed)
+                        fillOverflow();
+                    return;
+                }
+            }
+        }
+
+        bool place(const std::vector<uint32_t> &members,
+                   const std::vector<uint64_t> &hashes)
+        {
+            std::vector<size_t> taken(members.size());
+            for (uint32_t d = 0; d < MAX_DISPLACEMENT; ++d)
+            {
+                bool free = true;
+                for (size_t i = 0; i < members.size() && free; ++i)
+                {
+                    taken[i] = slot(hashes[members[i]], d);
+                    free = !slots_[taken[i]] &&
+                           std::find(taken.begin(), taken.begin() + i,
+                                     taken[i]) == taken.begin() + i;
+                }
+                if (!free)
+                    continue;
+                displacements_[bucket(hashes[members[0]])] = d;
+                for (size_t i = 0; i < members.size(); ++i)
+                    slots_[taken[i]] = members[i] + 1;
+                return true;
+            }
+            return false;
+        }
+
+        // Entries unreachable through their slot are searched linearly
+        void fillOverflow()
+        {
+            for (const auto &entry : entries_)
+            {
+                const uint64_t h = hash(entry.name.data(), entry.name.size());
+                const uint32_t slot = slots_[
+                    this->slot(h, displacements_[bucket(h)])];
+                if (slot != entry.index + 1)
+                    overflow_.push_back(entry.index);
+            }
+        }
+    };
+
+    struct SymbolTag {};
+    struct CurrencyTag {};
+
+    /// Trading pair, e.g. "btcusd"
+    using SymbolId = InternedId<SymbolTag>;
+    using SymbolTable = InternTable<SymbolTag>;
+
+    /// Currency, e.g. "USD"
+    using CurrencyId = InternedId<CurrencyTag>;
+    using CurrencyTable = InternTable<CurrencyTag>;
+}
+
+namespace std
+{
+    template <typename Tag>
+    struct hash<BfxAPI::InternedId<Tag>>
+    {
+        size_t operator () (BfxAPI::InternedId<Tag> id) const noexcept
+        { return std::hash<const void*>()(id.entry_); }
+    };
+}
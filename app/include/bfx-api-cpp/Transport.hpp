@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Transport.hpp
+//
+//
+//  Bitfinex REST API C++ client - pluggable request transport
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+// internal HTTPMethod
+#include "Endpoints.hpp"
+
+namespace BfxAPI {
+
+  struct HTTPResponse;
+
+  // Request as seen by transport, relative to API_URL
+  struct TransportRequest {
+    HTTPMethod method = HTTPMethod::get;
+    std::string path;     // e.g. "/book/btcusd"
+    std::string query;    // GET parameters, "a=1&b=2&"
+    std::string payload;  // JSON payload of signed POST, signed by transport
+  };
+
+  // Executes requests of HTTPRequest and AsyncHTTPRequest once set with
+  // setTransport(). Implementations fill response body, curlStatusCode,
+  // httpStatusCode and network timings; response path is already set.
+  // perform() may be called concurrently from multiple threads.
+  // HTTPRequest::curlTransport() is the libcurl transport, see also
+  // RecordingTransport and ReplayTransport.
+  class Transport {
+
+    public:
+
+      virtual ~Transport() = default;
+
+      virtual void perform(const TransportRequest &request,
+                           HTTPResponse &response) = 0;
+
+  };
+
+}
@@ -0,0 +1,385 @@
+////////////////////////////////////////////////////////////////////////////////
+//  WebSocket.hpp
+//
+//
+//  Bitfinex REST API C++ client - WebSocket connection on curl
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+
+// poll()
+#include <poll.h>
+
+// curl
+#include <curl/curl.h>
+
+// internal HTTPRequest
+#include "HTTPRequest.hpp"
+
+namespace BfxAPI {
+
+  // Minimal RFC 6455 client. curl resolves, connects and negotiates TLS in
+  // CONNECT_ONLY mode, upgrade handshake and framing are done here on top of
+  // curl_easy_send()/curl_easy_recv(), so no WebSocket support is required
+  // from libcurl. Text messages are reassembled from fragments, pings are
+  // answered, binary messages are dropped. Owned by a single thread.
+  class WebSocket {
+
+    public:
+
+      using MessageCallback = std::function<void(const string&)>;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Constructor / Destructor
+      ////////////////////////////////////////////////////////////////////////
+
+      WebSocket(const HTTPSettings &inSettings = HTTPSettings(),
+                std::shared_ptr<ConnectionPool> inPool =
+                  ConnectionPool::shared()):
+      settings(inSettings),
+      pool(inPool),
+      random(std::random_device{}())
+      {};
+
+      ~WebSocket() { close(); };
+
+      WebSocket(const WebSocket&) = delete;
+      WebSocket& operator = (const WebSocket&) = delete;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Public methods
+      ////////////////////////////////////////////////////////////////////////
+
+      // Connects to ws://host[:port]/path or wss://host[:port]/path
+      CURLcode open(const string &url) {
+        close();
+
+        const size_t schemeEnd = url.find("://");
+        if (schemeEnd == string::npos)
+          return CURLE_URL_MALFORMAT;
+        const string scheme = url.substr(0, schemeEnd);
+        if (scheme != "ws" && scheme != "wss")
+          return CURLE_UNSUPPORTED_PROTOCOL;
+
+        const size_t hostStart = schemeEnd + 3;
+        const size_t pathStart = url.find('/', hostStart);
+        const string authority = url.substr(hostStart, pathStart - hostStart);
+        const string target = pathStart == string::npos
+          ? "/"
+          : url.substr(pathStart);
+
+        handle = curl_easy_init();
+        if (!handle)
+          return CURLE_FAILED_INIT;
+
+        pool->setup(handle, settings);
+        const string httpUrl =
+          (scheme == "wss" ? "https://" : "http://") + authority + "/";
+        curl_easy_setopt(handle, CURLOPT_URL, httpUrl.c_str());
+        // Upgrade is HTTP/1.1 only, don't let ALPN pick h2
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+        curl_easy_setopt(handle, CURLOPT_CONNECT_ONLY, 1L);
+
+        curl_socket_t activeSocket = CURL_SOCKET_BAD;
+        CURLcode code = curl_easy_perform(handle);
+        if (code == CURLE_OK)
+          code = curl_easy_getinfo(handle, CURLINFO_ACTIVESOCKET,
+                                   &activeSocket);
+        sockfd = activeSocket;
+        if (code == CURLE_OK)
+          code = handshake(authority, target);
+        if (code != CURLE_OK)
+          drop();
+        return code;
+      };
+
+      bool isOpen() const noexcept { return handle != nullptr; };
+
+      CURLcode sendText(const string &message) {
+        return sendFrame(OPCODE_TEXT, message.data(), message.size());
+      };
+
+      // Reads available frames, waiting at most timeoutMs for data, and
+      // calls callback for every complete text message. Connection is
+      // closed when error is returned, also when peer closed it.
+      CURLcode poll(int timeoutMs, const MessageCallback &callback) {
+        if (!handle)
+          return CURLE_NO_CONNECTION_AVAILABLE;
+
+        CURLcode code = receive(timeoutMs);
+        size_t offset = 0;
+        while (code == CURLE_OK && handle) {
+          const size_t available = inbound.size() - offset;
+          const auto *head =
+            reinterpret_cast<const unsigned char*>(inbound.data() + offset);
+          if (available < 2)
+            break;
+
+          const bool fin = head[0] & 0x80;
+          const int opcode = head[0] & 0x0f;
+          uint64_t length = head[1] & 0x7f;
+          size_t headerLength = 2;
+          if (length == 126) {
+            if (available < 4)
+              break;
+            length = (head[2] << 8) | head[3];
+            headerLength = 4;
+          } else if (length == 127) {
+            if (available < 10)
+              break;
+            length = 0;
+            for (int i = 2; i < 10; ++i)
+              length = (length << 8) | head[i];
+            headerLength = 10;
+          }
+          // Servers must not mask, tolerated anyway
+          const bool masked = head[1] & 0x80;
+          if (masked)
+            headerLength += 4;
+          if (available < headerLength || available - headerLength < length)
+            break;
+
+          char *payload = &inbound[offset + headerLength];
+          if (masked) {
+            const char *mask = payload - 4;
+            for (uint64_t i = 0; i < length; ++i)
+              payload[i] ^= mask[i % 4];
+          }
+          offset += headerLength + length;
+
+          switch (opcode) {
+            case OPCODE_CONTINUATION:
+              if (!textFragments)
+                break;
+              message.append(payload, length);
+              if (fin)
+                deliver(callback);
+              break;
+            case OPCODE_TEXT:
+              message.assign(payload, length);
+              textFragments = !fin;
+              if (fin)
+                deliver(callback);
+              break;
+            case OPCODE_BINARY:
+              textFragments = false;
+              break;
+            case OPCODE_CLOSE:
+              close();
+              return CURLE_GOT_NOTHING;
+            case OPCODE_PING:
+              code = sendFrame(OPCODE_PONG, payload, length);
+              break;
+            default:
+              break;
+          }
+        }
+
+        // Callback may have closed connection and released inbound
+        if (handle)
+          inbound.erase(0, offset);
+        if (code != CURLE_OK)
+          drop();
+        return code;
+      };
+
+      // Sends close frame, best effort, and releases connection
+      void close() {
+        if (handle) {
+          // Status 1000, normal closure
+          const char status[] = {'\x03', '\xe8'};
+          sendFrame(OPCODE_CLOSE, status, sizeof status);
+        }
+        drop();
+      };
+
+    private:
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private properties
+      ////////////////////////////////////////////////////////////////////////
+
+      static constexpr int OPCODE_CONTINUATION = 0x0;
+      static constexpr int OPCODE_TEXT = 0x1;
+      static constexpr int OPCODE_BINARY = 0x2;
+      static constexpr int OPCODE_CLOSE = 0x8;
+      static constexpr int OPCODE_PING = 0x9;
+      static constexpr int OPCODE_PONG = 0xa;
+
+      HTTPSettings settings;
+      std::shared_ptr<ConnectionPool> pool;
+      std::minstd_rand random;
+
+      CURL *handle = nullptr;
+      curl_socket_t sockfd = CURL_SOCKET_BAD;
+      // Received bytes not yet decoded into frames
+      string inbound;
+      // Text message being reassembled
+      string message;
+      bool textFragments = false;
+      // Frame being sent, reused between frames
+      string outbound;
+
+      ////////////////////////////////////////////////////////////////////////
+      // Private methods
+      ////////////////////////////////////////////////////////////////////////
+
+      void drop() noexcept {
+        if (handle)
+          curl_easy_cleanup(handle);
+        handle = nullptr;
+        sockfd = CURL_SOCKET_BAD;
+        inbound.clear();
+        message.clear();
+        textFragments = false;
+      };
+
+      void deliver(const MessageCallback &callback) {
+        textFragments = false;
+        if (callback)
+          callback(message);
+      };
+
+      // Sends upgrade request and consumes 101 Switching Protocols response.
+      // Sec-WebSocket-Accept isn't verified, server is authenticated by TLS.
+      CURLcode handshake(const string &authority, const string &target) {
+        string nonce(16, '\0');
+        for (auto &byte : nonce)
+          byte = static_cast<char>(random());
+        string key;
+        HTTPRequest::appendBase64(nonce, key);
+
+        const string request =
+          "GET " + target + " HTTP/1.1\r\n"
+          "Host: " + authority + "\r\n"
+          "Upgrade: websocket\r\n"
+          "Connection: Upgrade\r\n"
+          "Sec-WebSocket-Key: " + key + "\r\n"
+          "Sec-WebSocket-Version: 13\r\n"
+          "\r\n";
+        CURLcode code = sendAll(request.data(), request.size());
+
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::seconds(settings.connectTimeout);
+        size_t headEnd;
+        while (code == CURLE_OK &&
+               (headEnd = inbound.find("\r\n\r\n")) == string::npos) {
+          const auto left = std::chrono::duration_cast<
+            std::chrono::milliseconds>(
+              deadline - std::chrono::steady_clock::now()).count();
+          if (left <= 0)
+            return CURLE_OPERATION_TIMEDOUT;
+          code = receive(static_cast<int>(left));
+        }
+        if (code != CURLE_OK)
+          return code;
+
+        // "HTTP/1.1 101 Switching Protocols"
+        const size_t status = inbound.find(' ');
+        if (status == string::npos || status > headEnd ||
+            inbound.compare(status + 1, 3, "101")) {
+          std::cerr << "WebSocket upgrade rejected: "
+                    << inbound.substr(0, inbound.find("\r\n")) << std::endl;
+          return CURLE_HTTP_RETURNED_ERROR;
+        }
+        inbound.erase(0, headEnd + 4);
+        return CURLE_OK;
+      };
+
+      // Masked frame with single fragment
+      CURLcode sendFrame(int opcode, const char *payload, size_t length) {
+        if (!handle)
+          return CURLE_NO_CONNECTION_AVAILABLE;
+
+        outbound.clear();
+        outbound.push_back(static_cast<char>(0x80 | opcode));
+        if (length < 126) {
+          outbound.push_back(static_cast<char>(0x80 | length));
+        } else if (length <= 0xffff) {
+          outbound.push_back(static_cast<char>(0x80 | 126));
+          outbound.push_back(static_cast<char>(length >> 8));
+          outbound.push_back(static_cast<char>(length));
+        } else {
+          outbound.push_back(static_cast<char>(0x80 | 127));
+          for (int shift = 56; shift >= 0; shift -= 8)
+            outbound.push_back(
+              static_cast<char>(static_cast<uint64_t>(length) >> shift));
+        }
+
+        const uint32_t maskKey = static_cast<uint32_t>(random());
+        char mask[4];
+        for (int i = 0; i < 4; ++i) {
+          mask[i] = static_cast<char>(maskKey >> (8 * i));
+          outbound.push_back(mask[i]);
+        }
+        const size_t payloadOffset = outbound.size();
+        outbound.append(payload, length);
+        for (size_t i = 0; i < length; ++i)
+          outbound[payloadOffset + i] ^= mask[i % 4];
+
+        return sendAll(outbound.data(), outbound.size());
+      };
+
+      CURLcode sendAll(const char *data, size_t length) {
+        while (length) {
+          size_t sent = 0;
+          const CURLcode code = curl_easy_send(handle, data, length, &sent);
+          if (code == CURLE_AGAIN) {
+            if (!wait(POLLOUT, static_cast<int>(settings.timeout * 1000)))
+              return CURLE_OPERATION_TIMEDOUT;
+            continue;
+          }
+          if (code != CURLE_OK)
+            return code;
+          data += sent;
+          length -= sent;
+        }
+        return CURLE_OK;
+      };
+
+      // Appends all readable bytes to inbound, waits at most timeoutMs when
+      // there are none
+      CURLcode receive(int timeoutMs) {
+        char buffer[16384];
+        bool received = false;
+        bool waited = false;
+        for (;;) {
+          size_t length = 0;
+          const CURLcode code = curl_easy_recv(handle, buffer, sizeof buffer,
+                                               &length);
+          if (code == CURLE_AGAIN) {
+            // Drained until EAGAIN, so TLS layer holds no buffered data
+            if (received || waited || timeoutMs <= 0)
+              return CURLE_OK;
+            waited = true;
+            wait(POLLIN, timeoutMs);
+            continue;
+          }
+          if (code != CURLE_OK)
+            return code;
+          if (!length)
+            return CURLE_GOT_NOTHING;
+          inbound.append(buffer, length);
+          received = true;
+        }
+      };
+
+      bool wait(short events, int timeoutMs) const noexcept {
+        struct pollfd descriptor;
+        descriptor.fd = sockfd;
+        descriptor.events = events;
+        descriptor.revents = 0;
+        return ::poll(&descriptor, 1, timeoutMs) > 0;
+      };
+
+  };
+
+}
@@ -0,0 +1,352 @@
+////////////////////////////////////////////////////////////////////////////////
+//  WithdrawConfig.hpp
+//
+//
+//  Bitfinex REST API C++ client - parsed and validated withdraw.conf
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <cctype>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// POSIX stat
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// internal error enumeration, Decimal and quoted decimal parser
+#include "error.hpp"
+#include "jsonutils.hpp"
+#include "PayloadWriter.hpp"
+
+namespace BfxAPI
+{
+
+    /// Parameters of /withdraw/ request, see withdraw.conf for their meaning
+    struct WithdrawRequest
+    {
+        std::string withdrawType;   // "wire" or crypto method
+        std::string walletSelected;
+        Decimal amount;
+        std::string address;
+        std::string paymentId;
+        bool expressWire = false;
+        std::string accountName;
+        std::string accountNumber;
+        std::string bankName;
+        std::string bankAddress;
+        std::string bankCity;
+        std::string bankCountry;
+        std::string detailPayment;
+        std::string intermediaryBankName;
+        std::string intermediaryBankAddress;
+        std::string intermediaryBankCity;
+        std::string intermediaryBankCountry;
+        std::string intermediaryBankAccount;
+        std::string intermediaryBankSwift;
+
+        // Adds non-empty parameters to payload
+        void write(PayloadWriter &params) const
+        {
+            for (const auto &field : textFields())
+            {
+                const std::string &value = this->*field.member;
+                if (!value.empty())
+                    params.text(field.key, value);
+            }
+            params.decimal("amount", amount);
+            if (withdrawType == "wire")
+                params.text("expressWire", expressWire ? "1" : "0");
+        }
+
+        // withdraw.conf key to member
+        struct TextField
+        {
+            const char *key;
+            std::string WithdrawRequest::*member;
+        };
+
+        static const std::vector<TextField>& textFields()
+        {
+            static const std::vector<TextField> fields =
+            {
+                {"withdraw_type", &WithdrawRequest::withdrawType},
+                {"walletselected", &WithdrawRequest::walletSelected},
+                {"address", &WithdrawRequest::address},
+                {"payment_id", &WithdrawRequest::paymentId},
+                {"account_name", &WithdrawRequest::accountName},
+                {"account_number", &WithdrawRequest::accountNumber},
+                {"bank_name", &WithdrawRequest::bankName},
+                {"bank_address", &WithdrawRequest::bankAddress},
+                {"bank_city", &WithdrawRequest::bankCity},
+                {"bank_country", &WithdrawRequest::bankCountry},
+                {"detail_payment", &WithdrawRequest::detailPayment},
+                {"intermediary_bank_name",
+                 &WithdrawRequest::intermediaryBankName},
+                {"intermediary_bank_address",
+                 &WithdrawRequest::intermediaryBankAddress},
+                {"intermediary_bank_city",
+                 &WithdrawRequest::intermediaryBankCity},
+                {"intermediary_bank_country",
+                 &WithdrawRequest::intermediaryBankCountry},
+                {"intermediary_bank_account",
+                 &WithdrawRequest::intermediaryBankAccount},
+                {"intermediary_bank_swift",
+                 &WithdrawRequest::intermediaryBankSwift}
+            };
+            return fields;
+        }
+    };
+
+    /// withdraw.conf parsed once into WithdrawRequest. load() stats the file
+    /// and parses it again only when its inode, size or modification time
+    /// (to the nanosecond where the platform has it) changed, so repeated
+    /// withdrawals cost one stat call. Edits within the timestamp
+    /// resolution can't be told apart, so a file modified in the second
+    /// it was parsed is parsed again on every load() until it settles. Parse and validation errors are cached along with the
+    /// request. Not thread-safe.
+    class WithdrawConfig
+    {
+
+    public:
+
+        ////////////////////////////////////////////////////////////////////////
+        // Constructor
+        ////////////////////////////////////////////////////////////////////////
+
+        explicit WithdrawConfig(const std::string &path): path_(path) {}
+
+        ////////////////////////////////////////////////////////////////////////
+        // Accessors
+        ////////////////////////////////////////////////////////////////////////
+
+        const std::string& getPath() const noexcept { return path_; }
+
+        // Discards parsed request
+        void setPath(const std::string &path)
+        {
+            path_ = path;
+            loaded_ = false;
+        }
+
+        // Request of last successful load()
+        const WithdrawRequest& request() const noexcept { return request_; }
+
+        ////////////////////////////////////////////////////////////////////////
+        // Loading
+        ////////////////////////////////////////////////////////////////////////
+
+        // cryptoMethods are withdraw types which require address
+        BfxClientErrors load(const std::unordered_set<std::string>
+                             &cryptoMethods)
+        {
+            struct stat info;
+            if (::stat(path_.c_str(), &info))
+            {
+                loaded_ = false;
+                return badWDconfFilePath;
+            }
+            const FileVersion version = fileVersion(info);
+            if (loaded_ && version == version_ && parsed_ > version.modified)
+                return status_;
+
+            parsed_ = std::time(nullptr);
+            status_ = parse(cryptoMethods);
+            loaded_ = status_ != badWDconfFilePath;
+            version_ = version;
+            return status_;
+        }
+
+    private:
+
+        // Identity and modification of parsed file
+        struct FileVersion
+        {
+            dev_t device = 0;
+            ino_t inode = 0;
+            long long size = -1;
+            time_t modified = 0;
+            long modifiedNanos = 0;
+
+            bool operator == (const FileVersion &other) const noexcept
+            {
+                return device == other.device && inode == other.inode &&
+                       size == other.size && modified == other.modified &&
+                       modifiedNanos == other.modifiedNanos;
+            }
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private attributes
+        ////////////////////////////////////////////////////////////////////////
+
+        std::string path_;
+        WithdrawRequest request_;
+        BfxClientErrors status_ = noError;
+        bool loaded_ = false;
+        FileVersion version_;
+        time_t parsed_ = 0;  // when version_ was parsed
+
+        ////////////////////////////////////////////////////////////////////////
+        // Utility private methods
+        ////////////////////////////////////////////////////////////////////////
+
+        static FileVersion fileVersion(const struct stat &info) noexcept
+        {
+            FileVersion version;
+            version.device = info.st_dev;
+            version.inode = info.st_ino;
+            version.size = static_cast<long long>(info.st_size);
+            version.modified = info.st_mtime;
+            #if defined(__APPLE__)
+            version.modifiedNanos = info.st_mtimespec.tv_nsec;
+            #elif defined(__linux__) || _POSIX_C_SOURCE >= 200809L
+            version.modifiedNanos = info.st_mtim.tv_nsec;
+            #endif
+            return version;
+        }
+
+        BfxClientErrors parse(const std::unordered_set<std::string>
+                              &cryptoMethods)
+        {
+            std::ifstream inFile(path_, std::ifstream::in);
+            if (!inFile.is_open())
+                return badWDconfFilePath;
+
+            WithdrawRequest request;
+            std::unordered_set<std::string> seen;
+            std::string line, key, value;
+            for (size_t lineNumber = 1; std::getline(inFile, line);
+                 ++lineNumber)
+            {
+                // Skip comments and blank lines
+                if (line.empty() ||
+                    !std::isalpha(static_cast<unsigned char>(line[0])))
+                    continue;
+                if (!tokenize(line, key, value))
+                {
+                    std::cerr << path_ << ":" << lineNumber
+                              << ": expected key = \"value\"" << std::endl;
+                    return badWDconfValue;
+                }
+                // First occurrence wins, empty values mean absent
+                if (value.empty() || !seen.insert(key).second)
+                    continue;
+                if (!assign(request, key, value))
+                {
+                    std::cerr << path_ << ":" << lineNumber
+                              << ": bad value of " << key << std::endl;
+                    return badWDconfValue;
+                }
+            }
+
+            // Check parameters
+            if (request.withdrawType.empty() ||
+                request.walletSelected.empty() ||
+                !seen.count("amount"))
+                return requiredParamsMissing;
+
+            if (request.withdrawType == "wire")
+            {
+                if (request.accountNumber.empty() ||
+                    request.bankName.empty() ||
+                    request.bankAddress.empty() ||
+                    request.bankCity.empty() ||
+                    request.bankCountry.empty())
+                    return wireParamsMissing;
+            }
+            else if (cryptoMethods.count(request.withdrawType) &&
+                     request.address.empty())
+                return addressParamsMissing;
+
+            request_ = std::move(request);
+            return noError;
+        }
+
+        // key = "value" or key = value, trailing // comment allowed after
+        // quoted value
+        static bool tokenize(const std::string &line,
+                             std::string &key,
+                             std::string &value)
+        {
+            size_t i = 0;
+            const size_t end = line.size();
+            while (i < end && (std::isalnum(static_cast<unsigned char>(line[i]))
+                               || line[i] == '_'))
+                ++i;
+            key.assign(line, 0, i);
+            i = skipSpace(line, i);
+            if (i == end || line[i] != '=')
+                return false;
+            i = skipSpace(line, i + 1);
+
+            if (i < end && line[i] == '"')
+            {
+                const size_t close = line.find('"', i + 1);
+                if (close == std::string::npos)
+                    return false;
+                value.assign(line, i + 1, close - i - 1);
+                i = skipSpace(line, close + 1);
+                return i == end || !line.compare(i, 2, "//");
+            }
+
+            size_t last = end;
+            while (last > i &&
+                   std::isspace(static_cast<unsigned char>(line[last - 1])))
+                --last;
+            value.assign(line, i, last - i);
+            return true;
+        }
+
+        static size_t skipSpace(const std::string &line, size_t i) noexcept
+        {
+            while (i < line.size() &&
+                   std::isspace(static_cast<unsigned char>(line[i])))
+                ++i;
+            return i;
+        }
+
+        static bool assign(WithdrawRequest &request,
+                           const std::string &key,
+                           const std::string &value)
+        {
+            if (key == "amount")
+            {
+                Decimal amount;
+                if (!jsonutils::parseDecimal(
+                        value.data(), static_cast<rapidjson::SizeType>(
+                                          value.size()), amount) ||
+                    amount.mantissa() <= 0 ||
+                    amount.scale() > Decimal::MAX_SCALE)
+                    return false;
+                request.amount = amount;
+                return true;
+            }
+            if (key == "expressWire")
+            {
+                if (value != "0" && value != "1")
+                    return false;
+                request.expressWire = value == "1";
+                return true;
+            }
+            for (const auto &field : WithdrawRequest::textFields())
+            {
+                if (key == field.key)
+                {
+                    request.*field.member = value;
+                    return true;
+                }
+            }
+            std::cerr << "Ignoring unknown withdraw.conf key " << key
+                      << std::endl;
+            return true;
+        }
+    };
+}
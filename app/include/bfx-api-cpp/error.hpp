@@ -22,5 +22,7 @@ enum BfxClientErrors
     jsonStrToUSetError,     // 10
     badWDconfFilePath,      // 11
     responseParseError,     // 12
-    responseSchemaError     // 13
+    responseSchemaError,    // 13
+    rateLimitError,         // 14
+    badWDconfValue          // 15
 };
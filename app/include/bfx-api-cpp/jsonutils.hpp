@@ -10,6 +10,7 @@
 #include "rapidjson/document.h"
 #include "rapidjson/error/en.h"
 #include "rapidjson/filereadstream.h"
+#include "rapidjson/internal/strtod.h"
 #include "rapidjson/schema.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
@@ -17,19 +18,49 @@
 // internal error
 #include "error.hpp"
 
+// internal typed responses
+#include "responses.hpp"
+
+// internal fixed-point decimal
+#include "Decimal.hpp"
+
+// internal endpoint table
+#include "Endpoints.hpp"
+
+// internal BFX_DECL
+#include "Config.hpp"
+
 // std
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
+
+// definitions.json compiled into binary (see BFX_EMBED_DEFINITIONS in
+// CMakeLists.txt)
+#ifdef JSON_DEFINITIONS_EMBEDDED
+#include "definitions_embedded.hpp"
+#endif
 
 // namespaces
 using std::cerr;
 using std::cout;
 using std::endl;
 using std::string;
+using std::unique_ptr;
 using std::unordered_set;
 using std::unordered_map;
+using std::vector;
 namespace rj = rapidjson;
 
 
@@ -37,202 +68,1692 @@ namespace jsonutils
 {
     
     ////////////////////////////////////////////////////////////////////////////
-    // Classes
+    // Classes
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Process-wide immutable registry of schemas from definitions.json.
+    /// Definitions are loaded and compiled exactly once on first use (either
+    /// from the embedded copy or from JSON_DEFINITIONS_FILE_PATH) and shared
+    /// by all providers, validators and BitfinexAPI instances. Compiled
+    /// schema documents are read-only and safe to use from multiple threads.
+    class BfxSchemaDefinitions
+    {
+        
+        #ifndef JSON_DEFINITIONS_FILE_PATH
+        static constexpr auto JSON_DEFINITIONS_FILE_PATH = "definitions.json";
+        #endif
+        
+    public:
+        
+        // Thread-safe lazy initialization (C++11 function local static)
+        static const BfxSchemaDefinitions& instance()
+        {
+            static const BfxSchemaDefinitions definitions;
+            return definitions;
+        }
+        
+        BfxSchemaDefinitions(const BfxSchemaDefinitions&) = delete;
+        BfxSchemaDefinitions& operator = (const BfxSchemaDefinitions&) = delete;
+        
+        const rj::SchemaDocument& getSchemaDocument() const noexcept
+        { return *schemaDoc_; }
+        
+        bool isLoaded() const noexcept { return loaded_; }
+        
+        // Compiles "{ "$ref": "definitions.json#/<schemaName>" }" schema
+        // document resolved against the shared definitions.
+        static unique_ptr<rj::SchemaDocument>
+        compileRefSchema(const string &schemaName);
+        
+    private:
+        
+        unique_ptr<rj::SchemaDocument> schemaDoc_;
+        bool loaded_ = false;
+        
+        BfxSchemaDefinitions();
+    };
+    
+    /// Helper class resolving remote schema for schema $ref operator
+    class MyRemoteSchemaDocumentProvider: public rj::IRemoteSchemaDocumentProvider
+    {
+    private:
+        
+        virtual const rj::SchemaDocument*
+        GetRemoteDocument(const char*, rj::SizeType)
+        {
+            // Resolve the URI and return a pointer to that schema
+            return &BfxSchemaDefinitions::instance().getSchemaDocument();
+        }
+    };
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Typed response decoding
+    ////////////////////////////////////////////////////////////////////////////
+    
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+    /// Converts plain decimal of at most 16 digits, e.g. "-6543.2", with
+    /// SSE2: digits are right-aligned into one register, validated and
+    /// combined pairwise into two 8 digit halves. Result is exact, single
+    /// division of integers representable in double is correctly rounded.
+    /// Returns false for other forms (exponent, too many digits), which
+    /// are left to the general parser.
+    inline bool parseDecimalSimd(const char *str, rj::SizeType length,
+                                 double &out)
+    {
+        static const double powers[] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+            1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16
+        };
+    
+        const bool negative = length && *str == '-';
+        str += negative;
+        length -= negative;
+    
+        const char *dot = static_cast<const char*>(
+            std::memchr(str, '.', length));
+        const size_t intDigits = dot ? dot - str : length;
+        const size_t fracDigits = dot ? length - intDigits - 1 : 0;
+        const size_t digits = intDigits + fracDigits;
+        if (!intDigits || (dot && !fracDigits) || digits > 16)
+            return false;
+    
+        // '0' padded on the left doesn't change value
+        alignas(16) char buffer[16];
+        std::memset(buffer, '0', sizeof buffer);
+        std::memcpy(buffer + 16 - digits, str, intDigits);
+        if (fracDigits)
+            std::memcpy(buffer + 16 - fracDigits, dot + 1, fracDigits);
+    
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i values = _mm_sub_epi8(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(buffer)),
+            _mm_set1_epi8('0'));
+        // Bytes other than 0..9 wrapped above 9 as unsigned
+        if (_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_max_epu8(values, nine), nine)) != 0xffff)
+            return false;
+    
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i tens = _mm_set1_epi32(0x0001000a);
+        const __m128i pairs = _mm_packs_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi8(values, zero), tens),
+            _mm_madd_epi16(_mm_unpackhi_epi8(values, zero), tens));
+        const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));
+        const __m128i octets = _mm_madd_epi16(_mm_packs_epi32(quads, quads),
+                                              _mm_set1_epi32(0x00012710));
+    
+        const uint64_t mantissa =
+            static_cast<uint64_t>(_mm_cvtsi128_si32(octets)) * 100000000u +
+            static_cast<uint32_t>(_mm_cvtsi128_si32(
+                _mm_shuffle_epi32(octets, _MM_SHUFFLE(1, 1, 1, 1))));
+        if (mantissa > (uint64_t(1) << 53))
+            return false;
+    
+        const double value = static_cast<double>(mantissa) / powers[fracDigits];
+        out = negative ? -value : value;
+        return true;
+    }
+#endif
+    
+    /// Decimal text [-]digits[.digits][(e|E)[+|-]digits] split into parts,
+    /// value is digits * 10^(exponent - fracDigits)
+    struct DecimalScan
+    {
+        bool negative = false;
+        const char *intBegin = nullptr;
+        size_t intDigits = 0;
+        const char *fracBegin = nullptr;
+        size_t fracDigits = 0;
+        int exponent = 0;
+        // First 19 significant digits and count of all significant digits
+        uint64_t significand = 0;
+        int significantDigits = 0;
+    };
+    
+    /// Scans decimal text, ASCII only whatever the locale is
+    inline bool scanDecimal(const char *str, rj::SizeType length,
+                            DecimalScan &scan) noexcept
+    {
+        const char *p = str, *end = str + length;
+        scan.negative = p != end && *p == '-';
+        p += scan.negative;
+        
+        auto digits = [&](size_t &count)
+        {
+            for (; p != end && *p >= '0' && *p <= '9'; ++p, ++count)
+            {
+                if (!scan.significantDigits && *p == '0')
+                    continue;
+                if (scan.significantDigits++ < 19)
+                    scan.significand = scan.significand * 10 + (*p - '0');
+            }
+        };
+        
+        scan.intBegin = p;
+        digits(scan.intDigits);
+        if (p != end && *p == '.')
+        {
+            scan.fracBegin = ++p;
+            digits(scan.fracDigits);
+        }
+        if (!scan.intDigits && !scan.fracDigits)
+            return false;
+        
+        if (p != end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            const bool negativeExponent = p != end && *p == '-';
+            p += p != end && (*p == '-' || *p == '+');
+            if (p == end)
+                return false;
+            int exponent = 0;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p)
+            {
+                if (exponent < 100000)
+                    exponent = exponent * 10 + (*p - '0');
+            }
+            scan.exponent = negativeExponent ? -exponent : exponent;
+        }
+        return p == end;
+    }
+    
+    /// Converts Bitfinex quoted decimal to nearest double, locale
+    /// independent. Significand below 2^53 (any 15 significant digits)
+    /// within 10^±22 (every Bitfinex price, amount and timestamp) takes
+    /// rapidjson exact fast path of one multiplication or division of
+    /// exactly representable doubles, others are left to classic locale
+    /// stream conversion, which also rounds correctly. rapidjson full
+    /// precision path isn't used, it misrounds some long inputs.
+    inline bool parseDouble(const char *str, rj::SizeType length, double &out)
+    {
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+        if (parseDecimalSimd(str, length, out))
+            return true;
+#endif
+        DecimalScan scan;
+        if (!scanDecimal(str, length, scan))
+            return false;
+        
+        double value;
+        if (scan.significantDigits <= 19 &&
+            scan.significand < (uint64_t(1) << 53) &&
+            rj::internal::StrtodFast(static_cast<double>(scan.significand),
+                                     scan.exponent -
+                                     static_cast<int>(scan.fracDigits),
+                                     &value))
+        {
+            out = scan.negative ? -value : value;
+            return true;
+        }
+        
+        std::istringstream in(string(str, length));
+        in.imbue(std::locale::classic());
+        in >> value;
+        if (in.fail())
+            return false;
+        out = value;
+        return true;
+    }
+    
+    /// Converts Bitfinex quoted decimal to fixed-point without rounding,
+    /// e.g. "0.00012345" to 12345 * 10^-8. Fails when value doesn't fit
+    /// in 18 digits.
+    inline bool parseDecimal(const char *str, rj::SizeType length,
+                             BfxAPI::Decimal &out)
+    {
+        DecimalScan scan;
+        if (!scanDecimal(str, length, scan) || scan.significantDigits > 18)
+            return false;
+        
+        long long mantissa = static_cast<long long>(scan.significand);
+        int scale = static_cast<int>(scan.fracDigits) - scan.exponent;
+        if (scale < 0)
+        {
+            if (scan.significantDigits - scale > 18)
+                return false;
+            for (; scale < 0; ++scale)
+                mantissa *= 10;
+        }
+        else if (scale > 18)
+            return false;
+        out = BfxAPI::Decimal(scan.negative ? -mantissa : mantissa, scale);
+        return true;
+    }
+    
+    /// Converts Bitfinex quoted integer to long long. Fails when value is
+    /// out of long long range.
+    inline bool parseInteger(const char *str, rj::SizeType length, long long &out)
+    {
+        const char *p = str, *end = str + length;
+        bool negative = (p != end && *p == '-');
+        if (negative)
+            ++p;
+        if (p == end)
+            return false;
+        
+        // Magnitude of LLONG_MIN is one above LLONG_MAX
+        const uint64_t limit = static_cast<uint64_t>(INT64_MAX) + negative;
+        uint64_t value = 0;
+        for (; p != end; ++p)
+        {
+            if (*p < '0' || *p > '9')
+                return false;
+            const unsigned digit = *p - '0';
+            if (value > (limit - digit) / 10)
+                return false;
+            value = value * 10 + digit;
+        }
+        out = negative && value ? -static_cast<long long>(value - 1) - 1
+                       : static_cast<long long>(value);
+        return true;
+    }
+    
+    /// Describes JSON object member decoded into T member
+    template <typename T>
+    struct RecordField
+    {
+        const char *name;
+        double T::*asDouble;
+        long long T::*asInteger;
+        bool T::*asBool;
+        string T::*asString;
+        BfxAPI::Decimal T::*asDecimal;
+    };
+    
+    template <typename T>
+    RecordField<T> recordField(const char *name, double T::*member)
+    { return {name, member, nullptr, nullptr, nullptr, nullptr}; }
+    
+    template <typename T>
+    RecordField<T> recordField(const char *name, long long T::*member)
+    { return {name, nullptr, member, nullptr, nullptr, nullptr}; }
+    
+    template <typename T>
+    RecordField<T> recordField(const char *name, bool T::*member)
+    { return {name, nullptr, nullptr, member, nullptr, nullptr}; }
+    
+    template <typename T>
+    RecordField<T> recordField(const char *name, string T::*member)
+    { return {name, nullptr, nullptr, nullptr, member, nullptr}; }
+    
+    template <typename T>
+    RecordField<T> recordField(const char *name, BfxAPI::Decimal T::*member)
+    { return {name, nullptr, nullptr, nullptr, nullptr, member}; }
+    
+    /// JSON member name to struct member mapping, specialized per record type
+    template <typename T>
+    struct RecordFields;
+    
+    template <>
+    struct RecordFields<BfxAPI::Ticker>
+    {
+        using T = BfxAPI::Ticker;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("mid", &T::mid),
+                recordField("bid", &T::bid),
+                recordField("ask", &T::ask),
+                recordField("last_price", &T::lastPrice),
+                recordField("low", &T::low),
+                recordField("high", &T::high),
+                recordField("volume", &T::volume),
+                recordField("timestamp", &T::timestamp)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::Stat>
+    {
+        using T = BfxAPI::Stat;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("period", &T::period),
+                recordField("volume", &T::volume)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::PriceLevel>
+    {
+        using T = BfxAPI::PriceLevel;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("price", &T::price),
+                recordField("amount", &T::amount),
+                recordField("timestamp", &T::timestamp)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::Trade>
+    {
+        using T = BfxAPI::Trade;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("timestamp", &T::timestamp),
+                recordField("tid", &T::tid),
+                recordField("price", &T::price),
+                recordField("amount", &T::amount),
+                recordField("exchange", &T::exchange),
+                recordField("type", &T::type)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::SymbolDetails>
+    {
+        using T = BfxAPI::SymbolDetails;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("pair", &T::pair),
+                recordField("price_precision", &T::pricePrecision),
+                recordField("initial_margin", &T::initialMargin),
+                recordField("minimum_margin", &T::minimumMargin),
+                recordField("maximum_order_size", &T::maximumOrderSize),
+                recordField("minimum_order_size", &T::minimumOrderSize),
+                recordField("expiration", &T::expiration),
+                recordField("margin", &T::margin)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::Balance>
+    {
+        using T = BfxAPI::Balance;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("type", &T::type),
+                recordField("currency", &T::currency),
+                recordField("amount", &T::amount),
+                recordField("available", &T::available)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::Order>
+    {
+        using T = BfxAPI::Order;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("id", &T::id),
+                // /order/new/ duplicates "id" as "order_id"
+                recordField("order_id", &T::id),
+                recordField("symbol", &T::symbol),
+                recordField("exchange", &T::exchange),
+                recordField("price", &T::price),
+                recordField("avg_execution_price", &T::avgExecutionPrice),
+                recordField("side", &T::side),
+                recordField("type", &T::type),
+                recordField("timestamp", &T::timestamp),
+                recordField("is_live", &T::isLive),
+                recordField("is_cancelled", &T::isCancelled),
+                recordField("is_hidden", &T::isHidden),
+                recordField("was_forced", &T::wasForced),
+                recordField("original_amount", &T::originalAmount),
+                recordField("remaining_amount", &T::remainingAmount),
+                recordField("executed_amount", &T::executedAmount)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::BalanceHistoryEntry>
+    {
+        using T = BfxAPI::BalanceHistoryEntry;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("currency", &T::currency),
+                recordField("amount", &T::amount),
+                recordField("balance", &T::balance),
+                recordField("description", &T::description),
+                recordField("timestamp", &T::timestamp)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::Movement>
+    {
+        using T = BfxAPI::Movement;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("id", &T::id),
+                recordField("currency", &T::currency),
+                recordField("method", &T::method),
+                recordField("type", &T::type),
+                recordField("amount", &T::amount),
+                recordField("description", &T::description),
+                recordField("address", &T::address),
+                recordField("status", &T::status),
+                recordField("timestamp", &T::timestamp),
+                recordField("timestamp_created", &T::timestampCreated),
+                recordField("fee", &T::fee)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::PastTrade>
+    {
+        using T = BfxAPI::PastTrade;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("price", &T::price),
+                recordField("amount", &T::amount),
+                recordField("timestamp", &T::timestamp),
+                recordField("exchange", &T::exchange),
+                recordField("type", &T::type),
+                recordField("fee_currency", &T::feeCurrency),
+                recordField("fee_amount", &T::feeAmount),
+                recordField("tid", &T::tid),
+                recordField("order_id", &T::orderId)
+            };
+            return fields;
+        }
+    };
+    
+    template <>
+    struct RecordFields<BfxAPI::FundingTrade>
+    {
+        using T = BfxAPI::FundingTrade;
+        static const vector<RecordField<T>>& get()
+        {
+            static const vector<RecordField<T>> fields =
+            {
+                recordField("rate", &T::rate),
+                recordField("period", &T::period),
+                recordField("amount", &T::amount),
+                recordField("timestamp", &T::timestamp),
+                recordField("type", &T::type),
+                recordField("tid", &T::tid),
+                recordField("offer_id", &T::offerId)
+            };
+            return fields;
+        }
+    };
+    
+    /// Decodes scalar members of single flat JSON object into T. Quoted
+    /// numbers are converted during decoding, unknown members are skipped.
+    template <typename T>
+    class RecordDecoder
+    {
+    public:
+        
+        void key(const char *str, rj::SizeType length) noexcept
+        {
+            field_ = nullptr;
+            for (const auto &field : RecordFields<T>::get())
+            {
+                if (!strncmp(field.name, str, length) &&
+                    field.name[length] == '\0')
+                {
+                    field_ = &field;
+                    return;
+                }
+            }
+        }
+        
+        bool string(T &record, const char *str, rj::SizeType length)
+        {
+            if (!field_)
+                return true;
+            if (field_->asString)
+                (record.*field_->asString).assign(str, length);
+            else if (field_->asDouble)
+                return parseDouble(str, length, record.*field_->asDouble);
+            else if (field_->asDecimal)
+                return parseDecimal(str, length, record.*field_->asDecimal);
+            else if (field_->asInteger)
+                return parseInteger(str, length, record.*field_->asInteger);
+            else
+                return false;
+            return true;
+        }
+        
+        bool integer(T &record, long long i) noexcept
+        {
+            if (!field_)
+                return true;
+            if (field_->asInteger)
+                record.*field_->asInteger = i;
+            else if (field_->asDouble)
+                record.*field_->asDouble = static_cast<double>(i);
+            else if (field_->asDecimal)
+                record.*field_->asDecimal = BfxAPI::Decimal(i, 0);
+            else
+                return false;
+            return true;
+        }
+        
+        bool real(T &record, double d) noexcept
+        {
+            if (!field_)
+                return true;
+            if (field_->asDouble)
+                record.*field_->asDouble = d;
+            else if (field_->asDecimal)
+                return BfxAPI::Decimal::fromDouble(d,
+                                                   record.*field_->asDecimal);
+            else if (field_->asInteger)
+            {
+                // Out of long long range conversion is undefined
+                if (!(d >= -9223372036854775808.0 && d < 9223372036854775808.0))
+                    return false;
+                record.*field_->asInteger = static_cast<long long>(d);
+            }
+            else
+                return false;
+            return true;
+        }
+        
+        bool boolean(T &record, bool b) noexcept
+        {
+            if (!field_)
+                return true;
+            if (!field_->asBool)
+                return false;
+            record.*field_->asBool = b;
+            return true;
+        }
+        
+    private:
+        
+        const RecordField<T> *field_ = nullptr;
+    };
+    
+    /// SAX events handler decoding single JSON object into T or JSON array of
+    /// objects into vector<T>
+    template <typename T>
+    class RecordsHandler:
+    public rj::BaseReaderHandler<rj::UTF8<>, RecordsHandler<T>>
+    {
+    public:
+        
+        explicit RecordsHandler(T &record): record_(&record) {}
+        explicit RecordsHandler(vector<T> &records): records_(&records)
+        { records_->clear(); }
+        
+        // SAX events handlers
+        bool StartObject()
+        {
+            if (depth_++ == recordDepth())
+            {
+                if (records_)
+                {
+                    records_->emplace_back();
+                    current_ = &records_->back();
+                }
+                else
+                    current_ = record_;
+            }
+            return true;
+        }
+        
+        bool EndObject(rj::SizeType) noexcept { --depth_; return true; }
+        
+        bool StartArray() noexcept
+        {
+            // Top level array is accepted only for vector<T> output
+            if (depth_++ == 0)
+                return records_ != nullptr;
+            return true;
+        }
+        
+        bool EndArray(rj::SizeType) noexcept { --depth_; return true; }
+        
+        bool Key(const char *str, rj::SizeType length, bool)
+        {
+            if (inRecord())
+                decoder_.key(str, length);
+            return true;
+        }
+        
+        bool String(const char *str, rj::SizeType length, bool)
+        { return !inRecord() || decoder_.string(*current_, str, length); }
+        
+        bool Int(int i) { return integer(i); }
+        bool Uint(unsigned u) { return integer(u); }
+        bool Int64(int64_t i) { return integer(i); }
+        bool Uint64(uint64_t u) { return integer(static_cast<long long>(u)); }
+        
+        bool Double(double d)
+        { return depth_ > 0 && (!inRecord() || decoder_.real(*current_, d)); }
+        
+        bool Bool(bool b)
+        { return depth_ > 0 && (!inRecord() || decoder_.boolean(*current_, b)); }
+        
+        bool Null() { return depth_ > 0; }
+        
+    private:
+        
+        T *record_ = nullptr;
+        vector<T> *records_ = nullptr;
+        T *current_ = nullptr;
+        unsigned depth_ = 0;
+        RecordDecoder<T> decoder_;
+        
+        unsigned recordDepth() const noexcept { return records_ ? 1 : 0; }
+        bool inRecord() const noexcept { return depth_ == recordDepth() + 1; }
+        
+        bool integer(long long i)
+        { return depth_ > 0 && (!inRecord() || decoder_.integer(*current_, i)); }
+    };
+    
+    /// SAX events handler decoding /book/ response into OrderBook
+    class OrderBookHandler:
+    public rj::BaseReaderHandler<rj::UTF8<>, OrderBookHandler>
+    {
+    public:
+        
+        explicit OrderBookHandler(BfxAPI::OrderBook &book): book_(book)
+        {
+            book_.bids.clear();
+            book_.asks.clear();
+        }
+        
+        // SAX events handlers
+        bool StartObject()
+        {
+            switch (depth_++)
+            {
+                case 0:
+                    return true;
+                case 2:
+                    if (side_)
+                        side_->push_back(BfxAPI::PriceLevel());
+                    return true;
+                default:
+                    return true;
+            }
+        }
+        
+        bool EndObject(rj::SizeType) noexcept { --depth_; return true; }
+        
+        bool StartArray() noexcept { return depth_++ > 0; }
+        
+        bool EndArray(rj::SizeType) noexcept { --depth_; return true; }
+        
+        bool Key(const char *str, rj::SizeType length, bool)
+        {
+            if (depth_ == 1)
+            {
+                if (length == 4 && !strncmp(str, "bids", 4))
+                    side_ = &book_.bids;
+                else if (length == 4 && !strncmp(str, "asks", 4))
+                    side_ = &book_.asks;
+                else
+                    side_ = nullptr;
+            }
+            else if (inLevel())
+                decoder_.key(str, length);
+            return true;
+        }
+        
+        bool String(const char *str, rj::SizeType length, bool)
+        { return !inLevel() || decoder_.string(side_->back(), str, length); }
+        
+        bool Int(int i) { return integer(i); }
+        bool Uint(unsigned u) { return integer(u); }
+        bool Int64(int64_t i) { return integer(i); }
+        bool Uint64(uint64_t u) { return integer(static_cast<long long>(u)); }
+        
+        bool Double(double d)
+        { return !inLevel() || decoder_.real(side_->back(), d); }
+        
+        bool Bool(bool) { return !inLevel(); }
+        bool Null() { return true; }
+        
+    private:
+        
+        BfxAPI::OrderBook &book_;
+        vector<BfxAPI::PriceLevel> *side_ = nullptr;
+        unsigned depth_ = 0;
+        RecordDecoder<BfxAPI::PriceLevel> decoder_;
+        
+        bool inLevel() const noexcept { return side_ && depth_ == 3; }
+        
+        bool integer(long long i)
+        { return !inLevel() || decoder_.integer(side_->back(), i); }
+    };
+    
+    /// SAX events handler decoding /order/new/multi/ response into
+    /// NewOrders, "order_ids" array is forwarded to RecordsHandler<Order>
+    class NewOrdersHandler:
+    public rj::BaseReaderHandler<rj::UTF8<>, NewOrdersHandler>
+    {
+    public:
+        
+        explicit NewOrdersHandler(BfxAPI::NewOrders &out):
+        out_(out),
+        orders_(out.orders)
+        {
+            out_.status.clear();
+        }
+        
+        // SAX events handlers
+        bool StartObject()
+        {
+            if (ordersDepth_)
+            {
+                ++ordersDepth_;
+                return orders_.StartObject();
+            }
+            ++depth_;
+            return true;
+        }
+        
+        bool EndObject(rj::SizeType count)
+        {
+            if (ordersDepth_)
+            {
+                --ordersDepth_;
+                return orders_.EndObject(count);
+            }
+            --depth_;
+            return true;
+        }
+        
+        bool StartArray()
+        {
+            if (ordersDepth_ || (depth_ == 1 && key_ == Member::orderIds))
+            {
+                ++ordersDepth_;
+                return orders_.StartArray();
+            }
+            return depth_++ > 0;
+        }
+        
+        bool EndArray(rj::SizeType count)
+        {
+            if (ordersDepth_)
+            {
+                --ordersDepth_;
+                return orders_.EndArray(count);
+            }
+            --depth_;
+            return true;
+        }
+        
+        bool Key(const char *str, rj::SizeType length, bool copy)
+        {
+            if (ordersDepth_)
+                return orders_.Key(str, length, copy);
+            if (depth_ == 1)
+                key_ = length == 9 && !strncmp(str, "order_ids", 9)
+                    ? Member::orderIds
+                    : length == 6 && !strncmp(str, "status", 6)
+                    ? Member::status
+                    : Member::other;
+            return true;
+        }
+        
+        bool String(const char *str, rj::SizeType length, bool copy)
+        {
+            if (ordersDepth_)
+                return orders_.String(str, length, copy);
+            if (depth_ == 1 && key_ == Member::status)
+                out_.status.assign(str, length);
+            return depth_ > 0;
+        }
+        
+        bool Int(int i)
+        { return ordersDepth_ ? orders_.Int(i) : depth_ > 0; }
+        bool Uint(unsigned u)
+        { return ordersDepth_ ? orders_.Uint(u) : depth_ > 0; }
+        bool Int64(int64_t i)
+        { return ordersDepth_ ? orders_.Int64(i) : depth_ > 0; }
+        bool Uint64(uint64_t u)
+        { return ordersDepth_ ? orders_.Uint64(u) : depth_ > 0; }
+        bool Double(double d)
+        { return ordersDepth_ ? orders_.Double(d) : depth_ > 0; }
+        bool Bool(bool b)
+        { return ordersDepth_ ? orders_.Bool(b) : depth_ > 0; }
+        bool Null()
+        { return ordersDepth_ ? orders_.Null() : depth_ > 0; }
+        
+    private:
+        
+        enum class Member { other, orderIds, status };
+        
+        BfxAPI::NewOrders &out_;
+        RecordsHandler<BfxAPI::Order> orders_;
+        unsigned depth_ = 0;
+        // Nesting inside "order_ids" array, 0 outside of it
+        unsigned ordersDepth_ = 0;
+        Member key_ = Member::other;
+    };
+    
+    /// Selects SAX handler decoding given typed response
+    inline RecordsHandler<BfxAPI::Ticker> makeHandler(BfxAPI::Ticker &out)
+    { return RecordsHandler<BfxAPI::Ticker>(out); }
+    
+    inline OrderBookHandler makeHandler(BfxAPI::OrderBook &out)
+    { return OrderBookHandler(out); }
+    
+    inline RecordsHandler<BfxAPI::Order> makeHandler(BfxAPI::Order &out)
+    { return RecordsHandler<BfxAPI::Order>(out); }
+    
+    inline NewOrdersHandler makeHandler(BfxAPI::NewOrders &out)
+    { return NewOrdersHandler(out); }
+    
+    template <typename T>
+    RecordsHandler<T> makeHandler(vector<T> &out)
+    { return RecordsHandler<T>(out); }
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Parse memory
     ////////////////////////////////////////////////////////////////////////////
     
-    /// Helper class resolving remote schema for schema $ref operator
-    class MyRemoteSchemaDocumentProvider: public rj::IRemoteSchemaDocumentProvider
+    /// Reusable memory of one parse at a time: reader stack, schema validator
+    /// state and documents. Allocations are carved from a retained buffer and
+    /// released all at once by reset(). When a parse overflows the buffer into
+    /// chunks of BaseAllocator, reset() grows the buffer to that peak, so
+    /// steady state parsing doesn't allocate at all. The buffer may also be
+    /// supplied by the caller, it is never grown then. Not thread-safe,
+    /// local() is the arena of the calling thread.
+    template <typename BaseAllocator = rj::CrtAllocator>
+    class BasicParseArena
     {
+    public:
         
-        #ifndef JSON_DEFINITIONS_FILE_PATH
-        static constexpr auto JSON_DEFINITIONS_FILE_PATH = "definitions.json";
-        #endif
+        using Allocator = rj::MemoryPoolAllocator<BaseAllocator>;
+        // DOM allocating values and parse stack from the arena
+        using Document = rj::GenericDocument<rj::UTF8<>, Allocator, Allocator>;
+        using Reader = rj::GenericReader<rj::UTF8<>, rj::UTF8<>, Allocator>;
+        
+        static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+        
+        explicit BasicParseArena(size_t capacity = DEFAULT_CAPACITY,
+                                 BaseAllocator *baseAllocator = nullptr):
+        buffer_(capacity),
+        baseAllocator_(baseAllocator)
+        { create(buffer_.data(), buffer_.size()); }
+        
+        // Caller owned buffer, must outlive the arena
+        BasicParseArena(void *buffer,
+                        size_t size,
+                        BaseAllocator *baseAllocator = nullptr):
+        baseAllocator_(baseAllocator)
+        { create(buffer, size); }
+        
+        BasicParseArena(const BasicParseArena&) = delete;
+        BasicParseArena& operator = (const BasicParseArena&) = delete;
+        
+        Allocator& allocator() noexcept { return *allocator_; }
+        
+        // Bytes retained between parses
+        size_t capacity() const noexcept { return capacity_; }
+        
+        // Releases all allocations. Memory allocated in parses since last
+        // reset is retained from now on.
+        void reset()
+        {
+            const size_t peak = allocator_->Capacity();
+            if (!buffer_.empty() && peak > buffer_.size())
+            {
+                allocator_.reset();
+                buffer_.assign(peak, 0);
+                create(buffer_.data(), buffer_.size());
+            }
+            else
+                allocator_->Clear();
+        }
+        
+        static BasicParseArena& local()
+        {
+            thread_local BasicParseArena arena;
+            return arena;
+        }
+        
+    private:
+        
+        vector<char> buffer_;
+        BaseAllocator *baseAllocator_;
+        unique_ptr<Allocator> allocator_;
+        size_t capacity_ = 0;
+        
+        void create(void *buffer, size_t size)
+        {
+            capacity_ = size;
+            allocator_.reset(
+                new Allocator(buffer, size,
+                              RAPIDJSON_ALLOCATOR_DEFAULT_CHUNK_CAPACITY,
+                              baseAllocator_));
+        }
+    };
+    
+    using ParseArena = BasicParseArena<>;
+    
+    /// Resets arena when parse using it goes out of scope
+    template <typename Arena>
+    struct ArenaScope
+    {
+        Arena &arena;
+        ~ArenaScope() { arena.reset(); }
+    };
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Streaming frames
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// WebSocket API v2 message: either event object, e.g.
+    /// {"event":"subscribed","channel":"book","chanId":17,...}, or channel
+    /// array [chanId, tag?, values] where values is single row of numbers or
+    /// array of rows (snapshot). Reused between messages.
+    struct StreamFrame
+    {
+        bool isEvent = false;
+        // Event object members
+        string event;
+        string channel;
+        string symbol;
+        string precision;
+        string message;
+        long long code = 0;
+        // Channel array, chanId is also member of subscribed event
+        long long chanId = -1;
+        string tag;             // "hb", "te", "tu", "cs" ... or empty
+        bool isSnapshot = false;
+        vector<double> values;  // rows stored one after another
+        vector<size_t> rowEnds; // end offset of every row in values
+        
+        void clear() noexcept
+        {
+            isEvent = isSnapshot = false;
+            event.clear();
+            channel.clear();
+            symbol.clear();
+            precision.clear();
+            message.clear();
+            code = 0;
+            chanId = -1;
+            tag.clear();
+            values.clear();
+            rowEnds.clear();
+        }
         
+        size_t rows() const noexcept { return rowEnds.size(); }
+        
+        // First value of row and number of its values
+        const double* row(size_t i, size_t &width) const noexcept
+        {
+            const size_t begin = i ? rowEnds[i - 1] : 0;
+            width = rowEnds[i] - begin;
+            return values.data() + begin;
+        }
+    };
+    
+    /// SAX events handler decoding WebSocket API v2 message into StreamFrame.
+    /// Strings and nulls inside rows are decoded as 0 to keep value positions.
+    class StreamFrameHandler:
+    public rj::BaseReaderHandler<rj::UTF8<>, StreamFrameHandler>
+    {
     public:
         
-        MyRemoteSchemaDocumentProvider()
+        explicit StreamFrameHandler(StreamFrame &frame): frame_(frame)
+        { frame_.clear(); }
+        
+        // SAX events handlers
+        bool StartObject() noexcept
         {
-            FILE *pFileIn = fopen(JSON_DEFINITIONS_FILE_PATH, "r"); // non-Windows use "r"
-            char readBuffer[65536];
-            rj::FileReadStream fReadStream(pFileIn, readBuffer, sizeof(readBuffer));
-            rj::Document d;
-            d.ParseStream(fReadStream);
-            fclose(pFileIn);
-            remoteSchemaDoc_ = new rj::SchemaDocument(d);
-        };
+            if (depth_++ == 0)
+                frame_.isEvent = true;
+            return true;
+        }
+        
+        bool EndObject(rj::SizeType) noexcept { --depth_; return true; }
+        
+        bool StartArray() noexcept
+        {
+            switch (depth_++)
+            {
+                case 0:
+                    return true;
+                case 2:
+                    // Array of rows
+                    frame_.isSnapshot = true;
+                    return true;
+                default:
+                    return true;
+            }
+        }
+        
+        bool EndArray(rj::SizeType)
+        {
+            --depth_;
+            if (!frame_.isEvent && inRow(depth_ + 1))
+                frame_.rowEnds.push_back(frame_.values.size());
+            return true;
+        }
+        
+        bool Key(const char *str, rj::SizeType length, bool)
+        {
+            member_ = nullptr;
+            number_ = nullptr;
+            if (depth_ != 1)
+                return true;
+            
+            if (is(str, length, "event"))
+                member_ = &frame_.event;
+            else if (is(str, length, "channel"))
+                member_ = &frame_.channel;
+            else if (is(str, length, "symbol"))
+                member_ = &frame_.symbol;
+            else if (is(str, length, "prec"))
+                member_ = &frame_.precision;
+            else if (is(str, length, "msg"))
+                member_ = &frame_.message;
+            else if (is(str, length, "chanId"))
+                number_ = &frame_.chanId;
+            else if (is(str, length, "code"))
+                number_ = &frame_.code;
+            return true;
+        }
         
-        //        ~MyRemoteSchemaDocumentProvider()
-        //        {
-        //            delete remoteSchemaDoc_;
-        //        };
+        bool String(const char *str, rj::SizeType length, bool)
+        {
+            if (frame_.isEvent)
+            {
+                if (member_ && depth_ == 1)
+                    member_->assign(str, length);
+            }
+            else if (depth_ == 1)
+                frame_.tag.assign(str, length);
+            else
+                value(0);
+            return true;
+        }
+        
+        bool Int(int i) { return value(i); }
+        bool Uint(unsigned u) { return value(u); }
+        bool Int64(int64_t i) { return value(static_cast<double>(i)); }
+        bool Uint64(uint64_t u) { return value(static_cast<double>(u)); }
+        bool Double(double d) { return value(d); }
+        bool Bool(bool b) { return value(b); }
+        bool Null() { return value(0); }
         
     private:
         
-        rj::SchemaDocument *remoteSchemaDoc_;
+        StreamFrame &frame_;
+        unsigned depth_ = 0;
+        unsigned position_ = 0; // element index of channel array
+        string *member_ = nullptr;
+        long long *number_ = nullptr;
         
-        virtual const rj::SchemaDocument*
-        GetRemoteDocument(const char* uri, rj::SizeType length)
+        static bool is(const char *str, rj::SizeType length, const char *key)
+        noexcept
+        { return length == strlen(key) && !strncmp(str, key, length); }
+        
+        // Row is innermost array: depth 2 for update, 3 for snapshot
+        bool inRow(unsigned depth) const noexcept
+        { return depth == (frame_.isSnapshot ? 3u : 2u); }
+        
+        bool value(double d)
         {
-            // Resolve the URI and return a pointer to that schema
-            return remoteSchemaDoc_;
+            if (frame_.isEvent)
+            {
+                if (number_ && depth_ == 1)
+                    *number_ = static_cast<long long>(d);
+            }
+            else if (depth_ == 1)
+            {
+                // [chanId, ...] or trailing scalar, e.g. checksum of "cs"
+                if (position_++ == 0)
+                    frame_.chanId = static_cast<long long>(d);
+                else
+                {
+                    frame_.values.push_back(d);
+                    frame_.rowEnds.push_back(frame_.values.size());
+                }
+            }
+            else if (inRow(depth_))
+                frame_.values.push_back(d);
+            return true;
         }
     };
     
+    /// Decodes WebSocket API v2 message, returns false on malformed JSON
+    template <typename Arena>
+    bool decodeStreamFrame(const string &inputJson,
+                           StreamFrame &frame,
+                           Arena &arena)
+    {
+        ArenaScope<Arena> scope{arena};
+        StreamFrameHandler handler(frame);
+        typename Arena::Reader reader(&arena.allocator());
+        rj::StringStream ss(inputJson.c_str());
+        return static_cast<bool>(reader.Parse(ss, handler));
+    }
+    
+    inline bool decodeStreamFrame(const string &inputJson, StreamFrame &frame)
+    { return decodeStreamFrame(inputJson, frame, ParseArena::local()); }
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Schema validation
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Outputs schema validator diagnostic information
+    template <typename Validator>
+    void printSchemaErrors(const Validator &validator, const string &inputJson)
+    {
+        rj::StringBuffer sb;
+        validator.GetInvalidSchemaPointer().StringifyUriFragment(sb);
+        cerr << "Invalid schema: " << sb.GetString() << endl;
+        cerr << "Invalid keyword: " << validator.GetInvalidSchemaKeyword() << endl;
+        sb.Clear();
+        validator.GetInvalidDocumentPointer().StringifyUriFragment(sb);
+        cerr << "Invalid document: " << sb.GetString() << endl;
+        cerr << "Invalid response: " << inputJson << endl;
+    }
+    
+    /// How much of a response BfxSchemaValidator checks, set per endpoint
+    enum class ValidationMode
+    {
+        full,        // parse and validate against schema
+        sampled,     // full validation of 1 in N responses, others structural
+        structural,  // parse only, JSON syntax errors are still detected
+        off          // like structural when decoding, otherwise not parsed
+    };
+    
+    /// Validation counters of one endpoint
+    struct ValidationStats
+    {
+        size_t validated = 0;    // responses validated against schema
+        size_t unvalidated = 0;  // responses parsed only or skipped by mode
+        size_t schemaErrors = 0; // schema mismatches
+        size_t parseErrors = 0;  // invalid JSON
+    };
+    
+    /// Endpoint argument of BfxSchemaValidator; implicitly constructed from
+    /// request path, matched by BfxAPI::findEndpoint(), or from endpoint
+    struct ApiEndPoint
+    {
+        ApiEndPoint(const string &inPath) noexcept:
+        id(BfxAPI::findEndpoint(inPath)),
+        path(inPath.c_str())
+        {}
+        
+        ApiEndPoint(const char *inPath) noexcept:
+        id(BfxAPI::findEndpoint(inPath, std::strlen(inPath))),
+        path(inPath)
+        {}
+        
+        ApiEndPoint(BfxAPI::Endpoint endpoint) noexcept:
+        id(endpoint),
+        path(BfxAPI::endpointInfo(endpoint).path)
+        {}
+        
+        // Endpoint of request path already known
+        ApiEndPoint(BfxAPI::Endpoint endpoint, const string &inPath) noexcept:
+        id(endpoint),
+        path(inPath.c_str())
+        {}
+        
+        BfxAPI::Endpoint id;
+        const char *path;   // used in diagnostics
+    };
+    
     class BfxSchemaValidator
     {
     public:
         
-        BfxSchemaValidator() {}
-        BfxSchemaValidator(unordered_set<string> &symbols,
-                           unordered_set<string> &currencies)
+        // Mapping of endpoints to schema names is the compile-time table of
+        // Endpoints.hpp. It is needed because rapidjson implementation of
+        // $ref keyword in json schema doesn't support json schema names
+        // which contain special characters thus direct mapping of endpoint
+        // such "/symbols/" to "/symbols/" schema name is not possible.
+        // See https://github.com/Tencent/rapidjson/issues/1311
+        BfxSchemaValidator() = default;
+        
+        // Symbols and currencies are not needed any more, kept for
+        // compatibility
+        BfxSchemaValidator(unordered_set<string> &, unordered_set<string> &):
+        BfxSchemaValidator()
+        {}
+        
+        // Schema of each endpoint is compiled on its first validation,
+        // validation methods are const and can be called concurrently from
+        // multiple threads. Moves must not overlap validations; schemas
+        // missing afterwards (e.g. in moved-from validator) are compiled
+        // again on use.
+        BfxSchemaValidator(BfxSchemaValidator &&other) noexcept:
+        cacheHits_(other.cacheHits_.load()),
+        cacheMisses_(other.cacheMisses_.load())
         {
-            // Mapping is needed because rapidjson implementation of $ref
-            // keyword in json schema doesn't support json schema names which
-            // contain special characters thus direct mapping of endpoint such
-            // "/symbols/" to "/symbols/" schema name is not possible.
-            // See https://github.com/Tencent/rapidjson/issues/1311
-            
-            ////////////////////////////////////////////////////////////////////
-            // Public endpoints
-            ////////////////////////////////////////////////////////////////////
+            moveSchemas(other);
+            copyPolicies(other);
+        }
+        
+        BfxSchemaValidator& operator = (BfxSchemaValidator &&other) noexcept
+        {
+            if (this == &other)
+                return *this;
+            moveSchemas(other);
+            copyPolicies(other);
+            cacheHits_ = other.cacheHits_.load();
+            cacheMisses_ = other.cacheMisses_.load();
+            return *this;
+        }
+        
+        // Validation mode of endpoint, full by default. sampleInterval is N
+        // of sampled mode. Can be changed while other threads validate.
+        void setValidationMode(BfxAPI::Endpoint endpoint,
+                               ValidationMode mode,
+                               unsigned sampleInterval = 100) noexcept
+        {
+            Policy &policy = policies_[static_cast<size_t>(endpoint)];
+            policy.sampleInterval.store(sampleInterval ? sampleInterval : 1,
+                                        std::memory_order_relaxed);
+            policy.mode.store(mode, std::memory_order_relaxed);
+        }
+        
+        // Sets mode of all endpoints, including unknown ones
+        void setValidationMode(ValidationMode mode,
+                               unsigned sampleInterval = 100) noexcept
+        {
+            for (size_t i = 0; i <= BfxAPI::ENDPOINT_COUNT; ++i)
+                setValidationMode(static_cast<BfxAPI::Endpoint>(i), mode,
+                                  sampleInterval);
+        }
+        
+        ValidationMode getValidationMode(BfxAPI::Endpoint endpoint)
+        const noexcept
+        {
+            return policies_[static_cast<size_t>(endpoint)].mode
+                .load(std::memory_order_relaxed);
+        }
+        
+        ValidationStats getValidationStats(BfxAPI::Endpoint endpoint)
+        const noexcept
+        {
+            const Policy &policy = policies_[static_cast<size_t>(endpoint)];
+            ValidationStats stats;
+            stats.validated = policy.validated.load(std::memory_order_relaxed);
+            stats.unvalidated =
+                policy.unvalidated.load(std::memory_order_relaxed);
+            stats.schemaErrors =
+                policy.schemaErrors.load(std::memory_order_relaxed);
+            stats.parseErrors =
+                policy.parseErrors.load(std::memory_order_relaxed);
+            return stats;
+        }
+        
+        // Prometheus text exposition format: counters with endpoint and
+        // result labels
+        void writePrometheus(std::ostream &out) const
+        {
+            static constexpr auto name = "bfx_response_validations_total";
             
-            // Create map for endpoints which use symbols in URL
-            for (const auto &symbol : symbols)
-            {
-                // Map /pubticker/[symbol] endpoints to "pubticker" schema
-                apiEndPointToSchemaMap_.emplace("/pubticker/" + symbol,
-                                                "pubticker");
-                // Map /stats/[symbol] endpoints to "stats" schema
-                apiEndPointToSchemaMap_.emplace("/stats/" + symbol,
-                                                "stats");
-                // Map /book/[symbol] endpoints to "book" schema
-                apiEndPointToSchemaMap_.emplace("/book/" + symbol,
-                                                "book");
-                // Map /trades/[symbol] endpoints to "trades" schema
-                apiEndPointToSchemaMap_.emplace("/trades/" + symbol,
-                                                "trades");
+            out << "# HELP " << name
+                << " Bitfinex REST responses by validation result\n"
+                << "# TYPE " << name << " counter\n";
+            for (size_t e = 0; e <= BfxAPI::ENDPOINT_COUNT; ++e)
+            {
+                const auto endpoint = static_cast<BfxAPI::Endpoint>(e);
+                const ValidationStats stats = getValidationStats(endpoint);
+                if (!stats.validated && !stats.unvalidated)
+                    continue;
+                const char *endpointName = e < BfxAPI::ENDPOINT_COUNT
+                    ? BfxAPI::endpointInfo(endpoint).schema
+                    : "unknown";
+                const std::pair<const char*, size_t> results[] =
+                {
+                    {"validated", stats.validated},
+                    {"unvalidated", stats.unvalidated},
+                    {"schema_error", stats.schemaErrors},
+                    {"parse_error", stats.parseErrors}
+                };
+                for (const auto &result : results)
+                    out << name << "{endpoint=\"" << endpointName
+                        << "\",result=\"" << result.first << "\"} "
+                        << result.second << "\n";
             }
-            
-            // Create map for endpoints which use currencies in URL
-            for (const auto &currency : currencies)
-            {
-                // Map /lendbook/[currency] endpoints to "lendbook" schema
-                apiEndPointToSchemaMap_.emplace("/lendbook/" + currency,
-                                                "lendbook");
-                // Map /lends/[currency] endpoints to "lends" schema
-                apiEndPointToSchemaMap_.emplace("/lends/" + currency,
-                                                "lends");
+        }
+        
+        // Parses and validates inputJson against apiEndPoint schema in
+        // a single SAX pass. Validated SAX events are forwarded to handler
+        // so that callers can decode the response in the same pass. Reader
+        // and validator state live in arena, which is reset afterwards.
+        // API endpoint is given either as request path, e.g. "/book/btcusd",
+        // or as BfxAPI::Endpoint, which skips path matching.
+        template <typename Handler, typename Arena>
+        BfxClientErrors validateSchema(const ApiEndPoint &apiEndPoint,
+                                       const string &inputJson,
+                                       Handler &handler,
+                                       Arena &arena) const
+        {
+            rj::StringStream ss(inputJson.c_str());
+            return parse<rj::kParseDefaultFlags>(apiEndPoint, ss, inputJson,
+                                                 handler, arena);
+        }
+        
+        // In-situ variant: strings are decoded inside inputJson instead of
+        // being copied to the reader stack, inputJson is overwritten
+        template <typename Handler, typename Arena>
+        BfxClientErrors validateSchemaInsitu(const ApiEndPoint &apiEndPoint,
+                                             string &inputJson,
+                                             Handler &handler,
+                                             Arena &arena) const
+        {
+            static const string consumedJson = "<parsed in situ>";
+            rj::InsituStringStream ss(&inputJson[0]);
+            return parse<rj::kParseInsituFlag>(apiEndPoint, ss, consumedJson,
+                                               handler, arena);
+        }
+        
+        // Uses arena of the calling thread
+        template <typename Handler>
+        BfxClientErrors validateSchema(const ApiEndPoint &apiEndPoint,
+                                       const string &inputJson,
+                                       Handler &handler) const
+        {
+            return validateSchema(apiEndPoint, inputJson, handler,
+                                  ParseArena::local());
+        }
+        
+        BfxClientErrors validateSchema(const ApiEndPoint &apiEndPoint,
+                                       const string &inputJson) const;
+        
+        // Validates inputJson and decodes it into typed response in one
+        // pass. Defined below the class, so that extern template
+        // declarations of separately compiled response types hold.
+        template <typename T>
+        BfxClientErrors decodeResponse(const ApiEndPoint &apiEndPoint,
+                                       const string &inputJson,
+                                       T &out) const;
+        
+        template <typename T, typename Arena>
+        BfxClientErrors decodeResponse(const ApiEndPoint &apiEndPoint,
+                                       const string &inputJson,
+                                       T &out,
+                                       Arena &arena) const
+        {
+            auto handler = makeHandler(out);
+            return validateSchema(apiEndPoint, inputJson, handler, arena);
+        }
+        
+        // Decodes inputJson in situ, inputJson is overwritten
+        template <typename T>
+        BfxClientErrors decodeResponseInsitu(const ApiEndPoint &apiEndPoint,
+                                             string &inputJson,
+                                             T &out) const;
+        
+        // Schema document cache statistics
+        size_t getCacheHits() const noexcept { return cacheHits_; }
+        size_t getCacheMisses() const noexcept { return cacheMisses_; }
+        size_t getCacheSize() const noexcept
+        {
+            size_t size = 0;
+            for (const auto &schema : schemas_)
+                size += schema.load(std::memory_order_acquire) != nullptr;
+            return size;
+        }
+        
+    private:
+        
+        // Compiled schema documents indexed by endpoint, owned by
+        // schemaDocs_ and published to readers by schemas_ once compiled.
+        // Null slots are compiled by compileSchema() under compileMutex_.
+        mutable unique_ptr<rj::SchemaDocument> schemaDocs_[BfxAPI::ENDPOINT_COUNT];
+        mutable std::atomic<const rj::SchemaDocument*>
+        schemas_[BfxAPI::ENDPOINT_COUNT] = {};
+        mutable std::mutex compileMutex_;
+        mutable std::atomic<size_t> cacheHits_{0};
+        mutable std::atomic<size_t> cacheMisses_{0};
+        
+        // Validation mode and counters of endpoint
+        struct Policy
+        {
+            std::atomic<ValidationMode> mode{ValidationMode::full};
+            std::atomic<unsigned> sampleInterval{100};
+            mutable std::atomic<size_t> sampled{0};
+            mutable std::atomic<size_t> validated{0};
+            mutable std::atomic<size_t> unvalidated{0};
+            mutable std::atomic<size_t> schemaErrors{0};
+            mutable std::atomic<size_t> parseErrors{0};
+        };
+        // Indexed by endpoint, last one is unknown endpoint
+        Policy policies_[BfxAPI::ENDPOINT_COUNT + 1];
+        
+        // diagnosticJson is printed on error in place of the input
+        template <unsigned parseFlags,
+                  typename InputStream,
+                  typename Handler,
+                  typename Arena>
+        BfxClientErrors parse(const ApiEndPoint &apiEndPoint,
+                              InputStream &ss,
+                              const string &diagnosticJson,
+                              Handler &handler,
+                              Arena &arena) const
+        {
+            const Policy &policy = policies_[static_cast<size_t>(
+                apiEndPoint.id)];
+            if (!validates(policy))
+            {
+                policy.unvalidated.fetch_add(1, std::memory_order_relaxed);
+                return parseOnly<parseFlags>(apiEndPoint, ss, diagnosticJson,
+                                             handler, arena, policy);
             }
+            policy.validated.fetch_add(1, std::memory_order_relaxed);
             
-            // Create map for static endpoints
-            apiEndPointToSchemaMap_.emplace("/symbols/", "symbols");
-            apiEndPointToSchemaMap_.emplace("/symbols_details/",
-                                            "symbols_details");
-            
-            ////////////////////////////////////////////////////////////////////
-            // Authenticated endpoints
-            ////////////////////////////////////////////////////////////////////
+            const auto &schemaDocument = getSchemaDocument(apiEndPoint.id);
             
-            // Create map for static endpoints
-            apiEndPointToSchemaMap_.emplace("/account_infos/", "account_infos");
-            apiEndPointToSchemaMap_.emplace("/account_fees/", "account_fees");
-            apiEndPointToSchemaMap_.emplace("/summary/", "summary");
-            apiEndPointToSchemaMap_.emplace("/deposit/new/", "deposit_new");
-            apiEndPointToSchemaMap_.emplace("/key_info/", "key_info");
-            apiEndPointToSchemaMap_.emplace("/margin_infos/", "margin_infos");
-            apiEndPointToSchemaMap_.emplace("/balances/", "balances");
-            apiEndPointToSchemaMap_.emplace("/transfer/", "transfer");
-            apiEndPointToSchemaMap_.emplace("/withdraw/", "withdraw");
-            apiEndPointToSchemaMap_.emplace("/order/new/", "order_new");
-            apiEndPointToSchemaMap_.emplace("/order/new/multi/", "order_new_multi");
-            apiEndPointToSchemaMap_.emplace("/order/cancel/", "order_cancel");
-            apiEndPointToSchemaMap_.emplace("/order/cancel/multi/",
-                                            "order_cancel_multi");
-            apiEndPointToSchemaMap_.emplace("/order/cancel/all/",
-                                            "order_cancel_all");
-            apiEndPointToSchemaMap_.emplace("/order/cancel/replace/",
-                                            "order_cancel_replace");
-            apiEndPointToSchemaMap_.emplace("/order/status/", "order_status");
-            apiEndPointToSchemaMap_.emplace("/orders/", "orders");
-            apiEndPointToSchemaMap_.emplace("/orders/hist/", "orders_hist");
-            apiEndPointToSchemaMap_.emplace("/positions/", "positions");
-            apiEndPointToSchemaMap_.emplace("/position/claim/", "position_claim");
-            apiEndPointToSchemaMap_.emplace("/history/", "history");
-            apiEndPointToSchemaMap_.emplace("/history/movements/",
-                                            "history_movements");
-            apiEndPointToSchemaMap_.emplace("/mytrades/", "mytrades");
-            apiEndPointToSchemaMap_.emplace("/offer/new/", "offer_new");
-            apiEndPointToSchemaMap_.emplace("/offer/cancel/", "offer_cancel");
-            apiEndPointToSchemaMap_.emplace("/offer/status/", "offer_status");
-            apiEndPointToSchemaMap_.emplace("/credits/", "credits");
-            apiEndPointToSchemaMap_.emplace("/offers/", "offers");
-            apiEndPointToSchemaMap_.emplace("/offers/hist/", "offers_hist");
-            apiEndPointToSchemaMap_.emplace("/mytrades_funding/",
-                                            "mytrades_funding");
-            apiEndPointToSchemaMap_.emplace("/taken_funds/", "taken_funds");
-            apiEndPointToSchemaMap_.emplace("/unused_taken_funds/",
-                                            "unused_taken_funds");
-            apiEndPointToSchemaMap_.emplace("/total_taken_funds/",
-                                            "total_taken_funds");
-            apiEndPointToSchemaMap_.emplace("/funding/close/", "funding_close");
-            apiEndPointToSchemaMap_.emplace("/position/close/", "position_close");
+            // Declared first so that it's released after validator
+            ArenaScope<Arena> scope{arena};
             
-        }
-        
-        auto validateSchema(const string &apiEndPoint, const string &inputJson)
-        {
-            const auto schemaName = getApiEndPointSchemaName(apiEndPoint);
+            // Create rapidjson validator wrapping output handler
+            rj::GenericSchemaValidator<rj::SchemaDocument,
+                                       Handler,
+                                       typename Arena::Allocator>
+            validator(schemaDocument, handler, &arena.allocator());
             
-            // Create rapidjson schema document
-            rj::Document sd;
-            string schema =
-            "{ \"$ref\": \"definitions.json#/" + schemaName + "\" }";
-            sd.Parse(schema.c_str());
-            rj::SchemaDocument schemaDocument(sd, 0, 0, &provider_);
+            // Create reader
+            typename Arena::Reader reader(&arena.allocator());
             
-            // Create rapidjson document and check for parse errors
-            rj::Document d;
-            if (d.Parse(inputJson.c_str()).HasParseError())
+            // Parse and validate
+            if (!reader.template Parse<parseFlags>(ss, validator))
             {
-                cerr << "Invalid json - response:" << endl;
-                cerr << inputJson << endl;
-                cerr << "API endpoint: " << apiEndPoint << endl;
+                if (!validator.IsValid())
+                {
+                    // Input JSON is invalid according to the schema
+                    // Output diagnostic information
+                    policy.schemaErrors.fetch_add(1,
+                                                  std::memory_order_relaxed);
+                    printSchemaErrors(validator, diagnosticJson);
+                    cerr << "Invalid API endpoint: " << apiEndPoint.path
+                         << endl;
+                    return BfxClientErrors::responseSchemaError;
+                }
+                
+                policy.parseErrors.fetch_add(1, std::memory_order_relaxed);
+                printParseError(reader, apiEndPoint, diagnosticJson);
                 return BfxClientErrors::responseParseError;
             }
             
-            // Create rapidjson validator and check for schema errors
-            rj::SchemaValidator validator(schemaDocument);
-            if (!d.Accept(validator))
-            {
-                // Input JSON is invalid according to the schema
-                // Output diagnostic information
-                rj::StringBuffer sb;
-                validator.GetInvalidSchemaPointer().StringifyUriFragment(sb);
-                cerr << "Invalid schema: " << sb.GetString() << endl;
-                cerr << "Invalid keyword: " << validator.GetInvalidSchemaKeyword() << endl;
-                sb.Clear();
-                validator.GetInvalidDocumentPointer().StringifyUriFragment(sb);
-                cerr << "Invalid document: " << sb.GetString() << endl;
-                cerr << "Invalid response: " << inputJson << endl;
-                cerr << "Invalid API endpoint: " << apiEndPoint << endl;
-                return BfxClientErrors::responseSchemaError;
+            return BfxClientErrors::noError;
+        }
+        
+        // Parses straight into handler without schema validator
+        template <unsigned parseFlags,
+                  typename InputStream,
+                  typename Handler,
+                  typename Arena>
+        BfxClientErrors parseOnly(const ApiEndPoint &apiEndPoint,
+                                  InputStream &ss,
+                                  const string &diagnosticJson,
+                                  Handler &handler,
+                                  Arena &arena,
+                                  const Policy &policy) const
+        {
+            ArenaScope<Arena> scope{arena};
+            typename Arena::Reader reader(&arena.allocator());
+            if (!reader.template Parse<parseFlags>(ss, handler))
+            {
+                policy.parseErrors.fetch_add(1, std::memory_order_relaxed);
+                printParseError(reader, apiEndPoint, diagnosticJson);
+                return BfxClientErrors::responseParseError;
             }
-            
             return BfxClientErrors::noError;
         }
         
-    private:
+        // Whether response is validated against schema in policy mode
+        static bool validates(const Policy &policy) noexcept
+        {
+            switch (policy.mode.load(std::memory_order_relaxed))
+            {
+                case ValidationMode::full:
+                    return true;
+                case ValidationMode::sampled:
+                    return policy.sampled.fetch_add(
+                        1, std::memory_order_relaxed) %
+                        policy.sampleInterval.load(
+                            std::memory_order_relaxed) == 0;
+                default:
+                    return false;
+            }
+        }
+        
+        template <typename Reader>
+        static void printParseError(const Reader &reader,
+                                    const ApiEndPoint &apiEndPoint,
+                                    const string &diagnosticJson)
+        {
+            cerr << "Invalid json - response:" << endl;
+            cerr << diagnosticJson << endl;
+            cerr << "Error(offset " << reader.GetErrorOffset() << "): ";
+            cerr << GetParseError_En(reader.GetParseErrorCode()) << endl;
+            cerr << "API endpoint: " << apiEndPoint.path << endl;
+        }
+        
+        // Compiles schema document of endpoint unless another thread did
+        const rj::SchemaDocument* compileSchema(BfxAPI::Endpoint endpoint)
+        const;
         
-        MyRemoteSchemaDocumentProvider provider_;
-        unordered_map<string, string> apiEndPointToSchemaMap_;
+        void moveSchemas(BfxSchemaValidator &other) noexcept
+        {
+            for (size_t i = 0; i < BfxAPI::ENDPOINT_COUNT; ++i)
+            {
+                schemaDocs_[i] = std::move(other.schemaDocs_[i]);
+                schemas_[i].store(schemaDocs_[i].get(),
+                                  std::memory_order_release);
+                other.schemas_[i].store(nullptr, std::memory_order_release);
+            }
+        }
         
-        const string& getApiEndPointSchemaName(const string& apiEndpoint) noexcept
+        void copyPolicies(const BfxSchemaValidator &other) noexcept
         {
-            return apiEndPointToSchemaMap_[apiEndpoint];
+            for (size_t i = 0; i <= BfxAPI::ENDPOINT_COUNT; ++i)
+            {
+                Policy &policy = policies_[i];
+                const Policy &source = other.policies_[i];
+                policy.mode = source.mode.load();
+                policy.sampleInterval = source.sampleInterval.load();
+                policy.sampled = source.sampled.load();
+                policy.validated = source.validated.load();
+                policy.unvalidated = source.unvalidated.load();
+                policy.schemaErrors = source.schemaErrors.load();
+                policy.parseErrors = source.parseErrors.load();
+            }
         }
         
+        // Returns compiled schema document of endpoint. Unknown endpoints
+        // resolve to schema accepting any JSON document.
+        const rj::SchemaDocument& getSchemaDocument(BfxAPI::Endpoint endpoint)
+        const;
+        
     };
     
+    template <typename T>
+    BfxClientErrors BfxSchemaValidator::decodeResponse(
+        const ApiEndPoint &apiEndPoint,
+        const string &inputJson,
+        T &out) const
+    {
+        auto handler = makeHandler(out);
+        return validateSchema(apiEndPoint, inputJson, handler);
+    }
+    
+    template <typename T>
+    BfxClientErrors BfxSchemaValidator::decodeResponseInsitu(
+        const ApiEndPoint &apiEndPoint,
+        string &inputJson,
+        T &out) const
+    {
+        auto handler = makeHandler(out);
+        return validateSchemaInsitu(apiEndPoint, inputJson, handler,
+                                    ParseArena::local());
+    }
+    
+    /// Typed responses decoded by BitfinexAPI. With BFX_SEPARATE_COMPILATION
+    /// their decoders are instantiated only in bfxapicpp library, other
+    /// types are still instantiated where used.
+    #define BFX_DECODED_RESPONSES(X) \
+        X(BfxAPI::Ticker) \
+        X(BfxAPI::OrderBook) \
+        X(BfxAPI::Order) \
+        X(BfxAPI::NewOrders) \
+        X(vector<BfxAPI::Stat>) \
+        X(vector<BfxAPI::Trade>) \
+        X(vector<BfxAPI::SymbolDetails>) \
+        X(vector<BfxAPI::Balance>) \
+        X(vector<BfxAPI::Order>) \
+        X(vector<BfxAPI::BalanceHistoryEntry>) \
+        X(vector<BfxAPI::Movement>) \
+        X(vector<BfxAPI::PastTrade>) \
+        X(vector<BfxAPI::FundingTrade>)
+    
+    // Explicit instantiation of decoders of T, declaration when prefixed
+    // by extern
+    #define BFX_DECODER_INSTANTIATION(prefix, T) \
+        prefix template BfxClientErrors \
+        BfxSchemaValidator::decodeResponse<T>( \
+            const ApiEndPoint&, const string&, T&) const; \
+        prefix template BfxClientErrors \
+        BfxSchemaValidator::decodeResponseInsitu<T>( \
+            const ApiEndPoint&, string&, T&) const;
+    
+    #ifdef BFX_SEPARATE_COMPILATION
+    #define BFX_EXTERN_DECODER(T) BFX_DECODER_INSTANTIATION(extern, T)
+    BFX_DECODED_RESPONSES(BFX_EXTERN_DECODER)
+    #undef BFX_EXTERN_DECODER
+    #endif
+    
     /// SAX events helper struct for jsonStrToUset() routine
     struct jsonStrToUsetHandler:
     public rj::BaseReaderHandler<rj::UTF8<>, jsonStrToUsetHandler>
@@ -253,7 +1774,7 @@ namespace jsonutils
             }
         }
         
-        bool String(const char *str, rj::SizeType length, bool)
+        bool String(const char *str, rj::SizeType, bool)
         {
             switch (state_)
             {
@@ -285,25 +1806,138 @@ namespace jsonutils
     // Routines
     ////////////////////////////////////////////////////////////////////////////
     
-    BfxClientErrors jsonStrToUset(unordered_set<string> &uSet, const string &inputJson)
+    BfxClientErrors jsonStrToUset(unordered_set<string> &uSet,
+                                  const string &inputJson);
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Separately compiled definitions (see Config.hpp)
+    ////////////////////////////////////////////////////////////////////////////
+    
+#if BFX_HEADER_DEFINITIONS
+    BFX_DECL BfxSchemaDefinitions::BfxSchemaDefinitions()
+    {
+        rj::Document d;
+        #ifdef JSON_DEFINITIONS_EMBEDDED
+        d.Parse(embedded::definitionsJson);
+        #else
+        FILE *pFileIn = fopen(JSON_DEFINITIONS_FILE_PATH, "r"); // non-Windows use "r"
+        if (pFileIn)
+        {
+            vector<char> readBuffer(65536);
+            rj::FileReadStream fReadStream(pFileIn, readBuffer.data(),
+                                           readBuffer.size());
+            d.ParseStream(fReadStream);
+            fclose(pFileIn);
+        }
+        else
+        {
+            cerr << "Unable to open JSON definitions file: ";
+            cerr << JSON_DEFINITIONS_FILE_PATH << endl;
+            d.SetObject();
+        }
+        #endif
+        
+        if (d.HasParseError())
+        {
+            cerr << "Invalid JSON definitions: ";
+            cerr << GetParseError_En(d.GetParseError()) << endl;
+            d.SetObject();
+        }
+        else
+            loaded_ = d.IsObject() && d.MemberCount() > 0;
+        
+        schemaDoc_.reset(new rj::SchemaDocument(d));
+    }
+    
+    BFX_DECL unique_ptr<rj::SchemaDocument>
+    BfxSchemaDefinitions::compileRefSchema(const string &schemaName)
     {
-        // Create schema $ref resolver
         rj::Document sd;
-        string schema = "{ \"$ref\": \"doc/definitions.json#/flatJsonSchema\" }";
+        string schema =
+        "{ \"$ref\": \"definitions.json#/" + schemaName + "\" }";
         sd.Parse(schema.c_str());
         MyRemoteSchemaDocumentProvider provider;
-        rj::SchemaDocument schemaDoc(sd, 0, 0, &provider);
+        return unique_ptr<rj::SchemaDocument>(
+            new rj::SchemaDocument(sd, 0, 0, &provider));
+    }
+    
+    BFX_DECL BfxClientErrors
+    BfxSchemaValidator::validateSchema(const ApiEndPoint &apiEndPoint,
+                                       const string &inputJson) const
+    {
+        const Policy &policy = policies_[static_cast<size_t>(apiEndPoint.id)];
+        if (policy.mode.load(std::memory_order_relaxed) == ValidationMode::off)
+        {
+            policy.unvalidated.fetch_add(1, std::memory_order_relaxed);
+            return BfxClientErrors::noError;
+        }
+        rj::BaseReaderHandler<> handler;
+        return validateSchema(apiEndPoint, inputJson, handler);
+    }
+    
+    BFX_DECL const rj::SchemaDocument*
+    BfxSchemaValidator::compileSchema(BfxAPI::Endpoint endpoint) const
+    {
+        const size_t i = static_cast<size_t>(endpoint);
+        std::lock_guard<std::mutex> lock(compileMutex_);
+        const rj::SchemaDocument *schema =
+            schemas_[i].load(std::memory_order_relaxed);
+        if (!schema)
+        {
+            ++cacheMisses_;
+            schemaDocs_[i] = BfxSchemaDefinitions::compileRefSchema(
+                BfxAPI::endpointInfo(endpoint).schema);
+            schema = schemaDocs_[i].get();
+            schemas_[i].store(schema, std::memory_order_release);
+        }
+        return schema;
+    }
+    
+    BFX_DECL const rj::SchemaDocument&
+    BfxSchemaValidator::getSchemaDocument(BfxAPI::Endpoint endpoint) const
+    {
+        if (endpoint != BfxAPI::Endpoint::unknown)
+        {
+            const rj::SchemaDocument *schema =
+                schemas_[static_cast<size_t>(endpoint)].load(
+                    std::memory_order_acquire);
+            if (schema)
+            {
+                ++cacheHits_;
+                return *schema;
+            }
+            return *compileSchema(endpoint);
+        }
+        ++cacheMisses_;
+        
+        static const auto unknownSchemaDocument =
+        BfxSchemaDefinitions::compileRefSchema("");
+        return *unknownSchemaDocument;
+    }
+    
+    BFX_DECL BfxClientErrors jsonStrToUset(unordered_set<string> &uSet,
+                                           const string &inputJson)
+    {
+        // Schema is compiled once per process and shared by all calls
+        static const auto schemaDoc =
+        BfxSchemaDefinitions::compileRefSchema("flatJsonSchema");
         
         // Create SAX events handler which contains parsed uSet after successful
         // parsing
         jsonStrToUsetHandler handler;
         
+        // Parse state lives in arena of the calling thread
+        auto &arena = ParseArena::local();
+        ArenaScope<ParseArena> scope{arena};
+        
         // Create schema validator
-        rj::GenericSchemaValidator<rj::SchemaDocument, jsonStrToUsetHandler>
-        validator(schemaDoc, handler);
+        rj::GenericSchemaValidator<rj::SchemaDocument,
+                                   jsonStrToUsetHandler,
+                                   ParseArena::Allocator>
+        validator(*schemaDoc, handler, &arena.allocator());
         
         // Create reader
-        rj::Reader reader;
+        ParseArena::Reader reader(&arena.allocator());
         
         // Create input JSON StringStream
         rj::StringStream ss(inputJson.c_str());
@@ -317,16 +1951,7 @@ namespace jsonutils
             cerr << GetParseError_En(reader.GetParseErrorCode()) << endl;
             
             if (!validator.IsValid())
-            {
-                rj::StringBuffer sb;
-                validator.GetInvalidSchemaPointer().StringifyUriFragment(sb);
-                cerr << "Invalid schema: " << sb.GetString() << endl;
-                cerr << "Invalid keyword: " << validator.GetInvalidSchemaKeyword() << endl;
-                sb.Clear();
-                validator.GetInvalidDocumentPointer().StringifyUriFragment(sb);
-                cerr << "Invalid document: " << sb.GetString() << endl;
-                cerr << "Invalid response: " << inputJson << endl;
-            }
+                printSchemaErrors(validator, inputJson);
             return BfxClientErrors::jsonStrToUSetError;
         }
         else
@@ -335,4 +1960,5 @@ namespace jsonutils
             return BfxClientErrors::noError;
         }
     }
+#endif
 }
@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// responses.hpp
+//
+// Typed Bitfinex REST API v1 responses decoded by jsonutils SAX handlers
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// std
+#include <string>
+#include <vector>
+
+namespace BfxAPI
+{
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Public endpoints
+    ////////////////////////////////////////////////////////////////////////////
+
+    // /pubticker/[symbol]
+    struct Ticker
+    {
+        double mid = 0;
+        double bid = 0;
+        double ask = 0;
+        double lastPrice = 0;
+        double low = 0;
+        double high = 0;
+        double volume = 0;
+        double timestamp = 0;
+    };
+
+    // /stats/[symbol] period entry
+    struct Stat
+    {
+        long long period = 0;
+        double volume = 0;
+    };
+
+    // /book/[symbol] price level
+    struct PriceLevel
+    {
+        double price;
+        double amount;
+        double timestamp;
+    };
+
+    // /book/[symbol]
+    struct OrderBook
+    {
+        std::vector<PriceLevel> bids;
+        std::vector<PriceLevel> asks;
+    };
+
+    // /trades/[symbol]
+    struct Trade
+    {
+        double timestamp = 0;
+        long long tid = 0;
+        double price = 0;
+        double amount = 0;
+        std::string exchange;
+        std::string type;
+    };
+
+    // /symbols_details/ entry
+    struct SymbolDetails
+    {
+        std::string pair;
+        long long pricePrecision = 0; // significant digits of price
+        double initialMargin = 0;
+        double minimumMargin = 0;
+        double maximumOrderSize = 0;
+        double minimumOrderSize = 0;
+        std::string expiration;
+        bool margin = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Authenticated endpoints
+    ////////////////////////////////////////////////////////////////////////////
+
+    // /balances/
+    struct Balance
+    {
+        std::string type;
+        std::string currency;
+        double amount = 0;
+        double available = 0;
+    };
+
+    // /order/new/, /order/status/, /orders/, /orders/hist/ ...
+    struct Order
+    {
+        long long id = 0;
+        std::string symbol;
+        std::string exchange;
+        double price = 0;
+        double avgExecutionPrice = 0;
+        std::string side;
+        std::string type;
+        double timestamp = 0;
+        bool isLive = false;
+        bool isCancelled = false;
+        bool isHidden = false;
+        bool wasForced = false;
+        double originalAmount = 0;
+        double remainingAmount = 0;
+        double executedAmount = 0;
+    };
+
+    // /history/ entry
+    struct BalanceHistoryEntry
+    {
+        std::string currency;
+        double amount = 0;
+        double balance = 0;
+        std::string description;
+        double timestamp = 0;
+    };
+
+    // /history/movements/ entry
+    struct Movement
+    {
+        long long id = 0;
+        std::string currency;
+        std::string method;
+        std::string type;
+        double amount = 0;
+        std::string description;
+        std::string address;
+        std::string status;
+        double timestamp = 0;
+        double timestampCreated = 0;
+        double fee = 0;
+    };
+
+    // /mytrades/ entry
+    struct PastTrade
+    {
+        double price = 0;
+        double amount = 0;
+        double timestamp = 0;
+        std::string exchange;
+        std::string type;
+        std::string feeCurrency;
+        double feeAmount = 0;
+        long long tid = 0;
+        long long orderId = 0;
+    };
+
+    // /mytrades_funding/ entry
+    struct FundingTrade
+    {
+        double rate = 0;
+        long long period = 0;
+        double amount = 0;
+        double timestamp = 0;
+        std::string type;
+        long long tid = 0;
+        long long offerId = 0;
+    };
+
+    // /order/new/multi/
+    struct NewOrders
+    {
+        std::vector<Order> orders;  // "order_ids", in submission order
+        std::string status;
+    };
+}
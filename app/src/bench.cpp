@@ -0,0 +1,284 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  bench.cpp
+//
+//
+//  Bitfinex REST API C++ client - microbenchmarks of client hot paths over
+//  recorded responses, no network access
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// std
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+// BitfinexAPI
+#include "bfx-api-cpp/BitfinexAPI.hpp"
+
+#ifndef BFX_BENCH_FIXTURES_DIR
+#define BFX_BENCH_FIXTURES_DIR "bench/fixtures"
+#endif
+
+#ifndef WITHDRAWAL_CONF_FILE_PATH
+#define WITHDRAWAL_CONF_FILE_PATH "doc/withdraw.conf"
+#endif
+
+// namespaces
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+  // Recorded response of every public endpoint with schema
+  const BfxAPI::Endpoint fixtureEndpoints[] = {
+    BfxAPI::Endpoint::pubticker,
+    BfxAPI::Endpoint::stats,
+    BfxAPI::Endpoint::book,
+    BfxAPI::Endpoint::trades,
+    BfxAPI::Endpoint::lendbook,
+    BfxAPI::Endpoint::lends,
+    BfxAPI::Endpoint::symbols,
+    BfxAPI::Endpoint::symbolsDetails
+  };
+
+  const string& fixture(BfxAPI::Endpoint endpoint) {
+    static std::map<BfxAPI::Endpoint, string> fixtures;
+    auto it = fixtures.find(endpoint);
+    if (it != fixtures.end())
+      return it->second;
+
+    const string path = string(BFX_BENCH_FIXTURES_DIR) + "/" +
+      BfxAPI::endpointInfo(endpoint).schema + ".json";
+    std::ifstream in(path);
+    if (!in) {
+      cerr << "Missing fixture " << path << endl;
+      std::exit(EXIT_FAILURE);
+    }
+    std::ostringstream body;
+    body << in.rdbuf();
+    return fixtures.emplace(endpoint, body.str()).first->second;
+  }
+
+  // Schemas compiled before timing starts
+  const jsonutils::BfxSchemaValidator& validator() {
+    static const jsonutils::BfxSchemaValidator instance;
+    static const bool warmed = [] {
+      instance.validateSchema(BfxAPI::Endpoint::pubticker,
+                              fixture(BfxAPI::Endpoint::pubticker));
+      return true;
+    }();
+    (void)warmed;
+    return instance;
+  }
+
+  // Order of newOrders(), prices rounded as BitfinexAPI::orderPrice() does
+  // with 5 significant digits
+  struct Order {
+    string symbol;
+    double amount;
+    double price;
+    string side;
+    string type;
+  };
+
+  const vector<Order>& orders() {
+    static const vector<Order> instance = [] {
+      vector<Order> list;
+      for (int i = 0; i < 10; ++i)
+        list.push_back({"btcusd", 0.01 * (i + 1), 7654.8 - 0.5 * i,
+                        i % 2 ? "sell" : "buy", "exchange limit"});
+      return list;
+    }();
+    return instance;
+  }
+
+  const std::unordered_set<string> cryptoMethods = {
+    "bitcoin", "ethereum", "ethereumc", "litecoin", "mastercoin", "monero",
+    "tetheruso", "zcash"
+  };
+
+  //////////////////////////////////////////////////////////////////////////
+  // Response validation and decoding
+  //////////////////////////////////////////////////////////////////////////
+
+  void validateSchema(benchmark::State &state, BfxAPI::Endpoint endpoint) {
+    const auto &schemaValidator = validator();
+    const string &body = fixture(endpoint);
+    if (schemaValidator.validateSchema(endpoint, body) != noError)
+      state.SkipWithError("fixture doesn't match schema");
+    for (auto _ : state) {
+      auto code = schemaValidator.validateSchema(endpoint, body);
+      benchmark::DoNotOptimize(code);
+    }
+    state.SetBytesProcessed(state.iterations() * body.size());
+  }
+
+  template <typename T>
+  void decodeResponse(benchmark::State &state, BfxAPI::Endpoint endpoint) {
+    const auto &schemaValidator = validator();
+    const string &body = fixture(endpoint);
+    T out;
+    if (schemaValidator.decodeResponse(endpoint, body, out) != noError)
+      state.SkipWithError("fixture doesn't decode");
+    for (auto _ : state) {
+      auto code = schemaValidator.decodeResponse(endpoint, body, out);
+      benchmark::DoNotOptimize(code);
+      benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(state.iterations() * body.size());
+  }
+
+  void jsonStrToUset(benchmark::State &state) {
+    const string &body = fixture(BfxAPI::Endpoint::symbols);
+    std::unordered_set<string> symbols;
+    for (auto _ : state) {
+      symbols.clear();
+      auto code = jsonutils::jsonStrToUset(symbols, body);
+      benchmark::DoNotOptimize(code);
+    }
+    state.SetBytesProcessed(state.iterations() * body.size());
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+  // Request signing
+  //////////////////////////////////////////////////////////////////////////
+
+  // X-BFX-PAYLOAD of newOrder()
+  void getBase64(benchmark::State &state) {
+    BfxAPI::PayloadWriter params("/v1/order/new", 1528370000000000ULL);
+    params.text("symbol", "btcusd").decimal("amount", 0.01);
+    const string json = params.str();
+    string encoded;
+    for (auto _ : state) {
+      encoded.clear();
+      BfxAPI::HTTPRequest::appendBase64(json, encoded);
+      benchmark::DoNotOptimize(encoded.data());
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+  }
+
+  void getHmacSha384(benchmark::State &state) {
+    BfxAPI::HmacSigner signer;
+    signer.setKey(string(43, 'k'));
+    string payload;
+    BfxAPI::HTTPRequest::appendBase64(string(state.range(0), 'p'), payload);
+    BfxAPI::HmacSigner::Signature signature;
+    for (auto _ : state) {
+      signer.sign(payload, signature);
+      benchmark::DoNotOptimize(signature);
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+  // Payload building
+  //////////////////////////////////////////////////////////////////////////
+
+  // Same members as BitfinexAPI::newOrder()
+  void newOrderPayload(benchmark::State &state) {
+    unsigned long long nonce = 1528370000000000ULL;
+    for (auto _ : state) {
+      BfxAPI::PayloadWriter params("/v1/order/new", ++nonce);
+      params.text("symbol", "btcusd");
+      params.decimal("amount", 0.01);
+      params.decimal("price", BfxAPI::Decimal::fromSignificant(7654.8, 5));
+      params.text("side", "buy");
+      params.text("type", "exchange limit");
+      params.boolean("is_hidden", false);
+      params.boolean("is_postonly", false);
+      params.boolean("use_all_available", false);
+      params.boolean("ocoorder", false);
+      params.boolean("buy_price_oco", false);
+      benchmark::DoNotOptimize(params.str().data());
+    }
+  }
+
+  // Same members as BitfinexAPI::newOrders() with 10 orders
+  void newOrdersPayload(benchmark::State &state) {
+    unsigned long long nonce = 1528370000000000ULL;
+    for (auto _ : state) {
+      BfxAPI::PayloadWriter params("/v1/order/new/multi", ++nonce);
+      params.beginArray("payload");
+      for (const auto &order : orders()) {
+        params.beginObject();
+        params.text("symbol", order.symbol);
+        params.decimal("amount", order.amount);
+        params.decimal("price",
+                       BfxAPI::Decimal::fromSignificant(order.price, 5));
+        params.text("side", order.side);
+        params.text("type", order.type);
+        params.endObject();
+      }
+      params.endArray();
+      benchmark::DoNotOptimize(params.str().data());
+    }
+    state.SetItemsProcessed(state.iterations() * orders().size());
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+  // withdraw.conf
+  //////////////////////////////////////////////////////////////////////////
+
+  // Parse after file change
+  void parseWDconfParams(benchmark::State &state) {
+    BfxAPI::WithdrawConfig config(WITHDRAWAL_CONF_FILE_PATH);
+    for (auto _ : state) {
+      config.setPath(WITHDRAWAL_CONF_FILE_PATH);
+      auto code = config.load(cryptoMethods);
+      benchmark::DoNotOptimize(code);
+    }
+  }
+
+  // Unchanged file, what withdraw() pays per call
+  void loadWDconfCached(benchmark::State &state) {
+    BfxAPI::WithdrawConfig config(WITHDRAWAL_CONF_FILE_PATH);
+    config.load(cryptoMethods);
+    for (auto _ : state) {
+      auto code = config.load(cryptoMethods);
+      benchmark::DoNotOptimize(code);
+    }
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  for (const auto endpoint : fixtureEndpoints) {
+    benchmark::RegisterBenchmark(
+      (string("validateSchema/") + BfxAPI::endpointInfo(endpoint).schema)
+        .c_str(),
+      validateSchema, endpoint);
+  }
+  benchmark::RegisterBenchmark("decodeResponse/pubticker",
+                               decodeResponse<BfxAPI::Ticker>,
+                               BfxAPI::Endpoint::pubticker);
+  benchmark::RegisterBenchmark("decodeResponse/book",
+                               decodeResponse<BfxAPI::OrderBook>,
+                               BfxAPI::Endpoint::book);
+  benchmark::RegisterBenchmark("decodeResponse/trades",
+                               decodeResponse<vector<BfxAPI::Trade>>,
+                               BfxAPI::Endpoint::trades);
+  benchmark::RegisterBenchmark("jsonStrToUset", jsonStrToUset);
+  benchmark::RegisterBenchmark("getBase64", getBase64);
+  benchmark::RegisterBenchmark("getHmacSha384", getHmacSha384)
+    ->Arg(64)->Arg(256)->Arg(1024);
+  benchmark::RegisterBenchmark("newOrderPayload", newOrderPayload);
+  benchmark::RegisterBenchmark("newOrdersPayload", newOrdersPayload);
+  benchmark::RegisterBenchmark("parseWDconfParams", parseWDconfParams);
+  benchmark::RegisterBenchmark("loadWDconfCached", loadWDconfCached);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return EXIT_FAILURE;
+  benchmark::RunSpecifiedBenchmarks();
+  return EXIT_SUCCESS;
+}
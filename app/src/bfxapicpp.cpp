@@ -0,0 +1,24 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  bfxapicpp.cpp
+//
+//
+//  Bitfinex REST API C++ client - separately compiled part of bfxapicpp
+//  library (see BFX_COMPILED_LIBRARY in CMakeLists.txt and Config.hpp)
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Definitions left out of headers by BFX_SEPARATE_COMPILATION
+#define BFX_IMPLEMENTATION
+
+// BitfinexAPI
+#include "bfx-api-cpp/BitfinexAPI.hpp"
+
+
+namespace jsonutils
+{
+    // Decoders of every typed response of BitfinexAPI
+    #define BFX_DECODER(T) BFX_DECODER_INSTANTIATION(, T)
+    BFX_DECODED_RESPONSES(BFX_DECODER)
+    #undef BFX_DECODER
+}
@@ -23,7 +23,7 @@ using std::ifstream;
 using std::string;
 
 
-int main(int argc, char *argv[])
+int main()
 {
     // Create bfxAPI without API keys
     BfxAPI::BitfinexAPI bfxAPI;
@@ -71,6 +71,22 @@ int main(int argc, char *argv[])
     //  bfxAPI.getSymbols();
     //  bfxAPI.getSymbolsDetails();
 
+    ////////////////////////////////////////////////////////////////////////////
+    ///  Asynchronous unauthenticated requests
+    ////////////////////////////////////////////////////////////////////////////
+
+    //  All requests are in flight at once, runAsync() drives them to the end
+    //  auto ticker = bfxAPI.getTickerAsync("btcusd");
+    //  auto book = bfxAPI.getOrderBookAsync("btcusd", 50, 50, true);
+    //  bfxAPI.getTradesAsync("ethusd", [&](BfxAPI::HTTPResponse &response)
+    //  {
+    //      vector<BfxAPI::Trade> trades;
+    //      bfxAPI.decodeResponse(response, trades);
+    //  });
+    //  bfxAPI.runAsync();
+    //  BfxAPI::HTTPResponse response = ticker.get();
+    //  bfxAPI.checkResponse(response);
+
     ////////////////////////////////////////////////////////////////////////////
     ///  Available authenticated requests
     ////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  example_coro.cpp
+//
+//
+//  Bitfinex REST API C++ client - C++20 coroutine examples
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// std
+#include <iostream>
+#include <string>
+#include <vector>
+
+// BitfinexAPI
+#include "bfx-api-cpp/Awaitable.hpp"
+
+
+// namespaces
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+// Sequential looking flow, every co_await lets other flows run meanwhile
+BfxAPI::Task<> watchSpread(BfxAPI::AwaitableAPI &api, string symbol)
+{
+    auto ticker = co_await api.getTickerAsync(symbol);
+    if (ticker.bfxApiStatusCode != BfxClientErrors::noError)
+    {
+        cerr << symbol << " ticker failed: " << ticker.bfxApiStatusCode << endl;
+        co_return;
+    }
+
+    auto book = co_await api.getOrderBookAsync(symbol, 1, 1);
+    if (book.bfxApiStatusCode == BfxClientErrors::noError &&
+        !book.data.bids.empty() && !book.data.asks.empty())
+        cout << symbol << " last " << ticker.data.lastPrice << " spread "
+             << book.data.asks[0].price - book.data.bids[0].price << endl;
+}
+
+int main()
+{
+    BfxAPI::BitfinexAPI bfxAPI;
+
+    // Responses resume their flows inline from run() on this thread. Pass
+    // executor, e.g. [&pool](auto handle) { pool.post(handle); }, to resume
+    // them on thread pool instead.
+    BfxAPI::AwaitableAPI api(bfxAPI);
+
+    const vector<string> symbols = {"btcusd", "ethusd", "ltcusd", "xrpusd"};
+    for (const auto &symbol : symbols)
+        spawn(watchSpread(api, symbol));
+    api.run();
+
+    return 0;
+}
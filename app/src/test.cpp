@@ -35,7 +35,20 @@ void check(BfxAPI::BitfinexAPI &bfxAPI) {
   }
 }
 
-int main(int argc, char *argv[]) {
+void check(const BfxAPI::HTTPResponse &response) {
+  if (response.hasError()) {
+    cout << "❌" << endl << endl;
+    cout << "BfxApiStatusCode: ";
+    cout << response.bfxApiStatusCode << " - ";
+    cout << "CurlStatusCode: ";
+    cout << response.curlStatusCode << endl;
+    cout << "Response: " << response.body << endl << endl;
+  } else {
+    cout << "✅" << endl << endl;
+  }
+}
+
+int main() {
   // Create bfxAPI without API keys
   BfxAPI::BitfinexAPI bfxAPI;
 
@@ -68,5 +81,15 @@ int main(int argc, char *argv[]) {
   cout << "- getSymbolsDetails(): ";
   bfxAPI.getSymbolsDetails(); check(bfxAPI);
 
+  cout << "- fetchTicker(\"btcusd\"): ";
+  check(bfxAPI.fetchTicker("btcusd"));
+
+  cout << "- fetchTicker(getSymbolId(\"btcusd\")): ";
+  check(bfxAPI.fetchTicker(bfxAPI.getSymbolId("btcusd")));
+
+  cout << "- fetchTickerBatch({\"btcusd\", \"ethusd\"}): ";
+  for (const auto &result : bfxAPI.fetchTickerBatch({"btcusd", "ethusd"}))
+    check(result);
+
   return 0;
 }
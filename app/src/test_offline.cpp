@@ -0,0 +1,605 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  test_offline.cpp
+//
+//
+//  Bitfinex REST API C++ client - Deterministic tests of components which
+//  need no network access, run by ctest
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// POSIX mkdir, rmdir
+#include <sys/stat.h>
+#include <unistd.h>
+
+// BitfinexAPI
+#include "bfx-api-cpp/BitfinexAPI.hpp"
+#include "bfx-api-cpp/OrderGateway.hpp"
+#include "bfx-api-cpp/RecordReplay.hpp"
+
+
+// namespaces
+using std::cout;
+using std::endl;
+using std::string;
+
+using BfxAPI::Endpoint;
+
+int failures = 0;
+
+void expect(bool condition, const string &what) {
+  cout << "- " << what << ": " << (condition ? "✅" : "❌") << endl;
+  if (!condition)
+    ++failures;
+}
+
+void testSchemaValidatorMove() {
+  cout << "BfxSchemaValidator" << endl;
+  const string valid = "[\"btcusd\"]";
+  const string invalid = "[1]";
+
+  jsonutils::BfxSchemaValidator validator;
+  expect(validator.validateSchema(Endpoint::symbols, valid) ==
+         BfxClientErrors::noError, "valid response");
+  expect(validator.validateSchema(Endpoint::symbols, invalid) ==
+         BfxClientErrors::responseSchemaError, "invalid response");
+
+  jsonutils::BfxSchemaValidator moved(std::move(validator));
+  expect(moved.validateSchema(Endpoint::symbols, invalid) ==
+         BfxClientErrors::responseSchemaError, "validates after move");
+  expect(validator.validateSchema(Endpoint::symbols, invalid) ==
+         BfxClientErrors::responseSchemaError,
+         "moved-from validator compiles schema again");
+
+  moved = jsonutils::BfxSchemaValidator();
+  expect(moved.getCacheSize() == 0, "move assignment of empty validator");
+  expect(moved.validateSchema(Endpoint::symbols, valid) ==
+         BfxClientErrors::noError &&
+         moved.validateSchema(Endpoint::symbols, invalid) ==
+         BfxClientErrors::responseSchemaError,
+         "validates after move assignment");
+  expect(moved.getCacheSize() == 1, "compiles only validated endpoint");
+  cout << endl;
+}
+
+void testLatencyHistogram() {
+  cout << "LatencyHistogram" << endl;
+  BfxAPI::LatencyHistogram histogram;
+  const long long values[] = {0, 1, (1LL << 32) - 1, 1LL << 32, INT64_MAX};
+  for (long long value : values)
+    histogram.record(value);
+
+  expect(histogram.count() == 5, "count of values up to INT64_MAX");
+  expect(histogram.max() == INT64_MAX, "max");
+  expect(histogram.sum() == (1ULL << 33) + INT64_MAX, "sum");
+  expect(histogram.quantile(0) == 0, "minimum quantile");
+  expect(histogram.quantile(0.4) == 1, "quantile of small value");
+  expect(histogram.quantile(0.6) >= (1ULL << 32) - 1,
+         "quantile in last bucket");
+  expect(histogram.quantile(1) == INT64_MAX, "maximum quantile");
+
+  histogram.reset();
+  histogram.record(-5);
+  expect(histogram.count() == 1 && histogram.quantile(0.5) == 0,
+         "negative value recorded as 0");
+  cout << endl;
+}
+
+BfxAPI::Order liveOrder(long long id, double remainingAmount) {
+  BfxAPI::Order order;
+  order.id = id;
+  order.symbol = "btcusd";
+  order.isLive = true;
+  order.remainingAmount = remainingAmount;
+  return order;
+}
+
+void testOrderCache() {
+  cout << "OrderCache" << endl;
+  using Clock = BfxAPI::OrderCache::Clock;
+  const auto second = std::chrono::seconds(1);
+  BfxAPI::OrderCache cache;
+  BfxAPI::Order order;
+  expect(cache.needsReconcile(), "needs reconcile before first snapshot");
+
+  const auto requested = Clock::now() - second;
+  cache.apply(liveOrder(1, 2.0));
+  cache.apply(liveOrder(2, 1.0));
+  cache.remove(2);
+  cache.applySnapshot({liveOrder(1, 1.0), liveOrder(2, 1.0), liveOrder(3, 1.0)},
+                      requested);
+  expect(cache.find(1, order) && order.remainingAmount == 2.0,
+         "newer order state kept over snapshot");
+  expect(!cache.find(2, order), "order removed after request stays removed");
+  expect(cache.find(3, order) && cache.size() == 2, "snapshot order added");
+  expect(!cache.needsReconcile(requested + second), "reconciled");
+
+  cache.replace(3, liveOrder(4, 1.0));
+  expect(!cache.find(3, order) && cache.find(4, order), "replaced order");
+  BfxAPI::Order cancelled = liveOrder(1, 2.0);
+  cancelled.isCancelled = true;
+  cache.apply(cancelled);
+  expect(!cache.find(1, order) && cache.activeOrders("btcusd").size() == 1,
+         "cancelled order removed");
+
+  const auto now = Clock::now();
+  cache.markGap(now + second);
+  cache.applySnapshot({}, now);
+  expect(cache.needsReconcile(now), "gap after request survives snapshot");
+  cache.applySnapshot({}, now + 2 * second);
+  expect(!cache.needsReconcile(now + 2 * second),
+         "snapshot requested after gap reconciles");
+  expect(cache.stats().gaps == 1 && cache.stats().reconciliations == 3,
+         "stats");
+  cout << endl;
+}
+
+void testRateLimiter() {
+  cout << "RateLimiter" << endl;
+  BfxAPI::RateLimiter limiter;
+  BfxAPI::RateLimiter::Clock::duration wait;
+  bool taken = true;
+  for (int i = 0; i < 5; ++i)
+    taken = limiter.tryAcquire("/symbols/", wait) && taken;
+  expect(taken, "burst of default symbols budget");
+  expect(!limiter.tryAcquire("/symbols/", wait) &&
+         wait > BfxAPI::RateLimiter::Clock::duration::zero(),
+         "symbols budget exhausted");
+  expect(limiter.tryAcquire("/symbols_details/", wait) &&
+         limiter.tryAcquire("/book/btcusd", wait),
+         "endpoints of other buckets not limited");
+  for (int i = 0; i < 90; ++i)
+    limiter.tryAcquire("/order/new/", wait);
+  expect(!limiter.tryAcquire("/history/movements/", wait) &&
+         !limiter.tryAcquire("/unlisted/", wait),
+         "authenticated endpoints and unlisted paths share budget");
+
+  limiter.setBucket("symbols", {0, 60});
+  expect(limiter.tryAcquire("/symbols/", wait), "zero requests not limited");
+  limiter.setBucket("symbols", {5, 0});
+  expect(limiter.tryAcquire("/symbols/", wait), "zero period not limited");
+  limiter.setBucket("symbols", {1, HUGE_VAL});
+  expect(limiter.tryAcquire("/symbols/", wait), "zero rate not limited");
+  limiter.setBucket("symbols", {1, 1e300});
+  expect(limiter.tryAcquire("/symbols/", wait) &&
+         !limiter.tryAcquire("/symbols/", wait) &&
+         wait == std::chrono::seconds(60), "wait of slow bucket capped");
+  cout << endl;
+}
+
+void testParseInteger() {
+  cout << "parseInteger" << endl;
+  auto parse = [](const string &text, long long &value) {
+    return jsonutils::parseInteger(text.data(),
+                                   static_cast<rj::SizeType>(text.size()),
+                                   value);
+  };
+  long long value = 0;
+  expect(parse("9223372036854775807", value) && value == INT64_MAX,
+         "maximum");
+  expect(parse("-9223372036854775808", value) && value == INT64_MIN,
+         "minimum");
+  expect(parse("-0", value) && value == 0, "negative zero");
+  expect(!parse("9223372036854775808", value) &&
+         !parse("-9223372036854775809", value), "one past range fails");
+  expect(!parse("123456789012345678901", value), "20+ digits fail");
+  cout << endl;
+}
+
+void testParseDouble() {
+  cout << "parseDouble" << endl;
+  const char *texts[] = {
+    "0.1", "-1234.5678", "123456789012345", "0.000000012345",
+    "9007199254740991", "9007199254740993", "1234567890123456789",
+    "123456789012.3456789", "1e22", "1.5e-300", "17976931348623157e292"
+  };
+  bool rounded = true;
+  for (const char *text : texts) {
+    double value = 0;
+    rounded = jsonutils::parseDouble(
+      text, static_cast<rj::SizeType>(std::strlen(text)), value) &&
+      value == std::strtod(text, nullptr) && rounded;
+  }
+  expect(rounded, "rounds as strtod");
+  cout << endl;
+}
+
+void testHmacSigner() {
+  cout << "HmacSigner" << endl;
+  // HMAC-SHA384 of empty message with empty key
+  const string empty =
+    "6c1f2ee938fad2e24bd91298474382ca218c75db3d83e114b3d4367776d14d35"
+    "51289e75e8209cd4b792302840234adc";
+  BfxAPI::HmacSigner signer;
+  BfxAPI::HmacSigner::Signature signature;
+  signer.sign("", signature);
+  expect(signature == empty, "empty key before setKey()");
+  signer.setKey("secret");
+  signer.sign("", signature);
+  expect(signature != empty, "keyed signature");
+  signer.setKey("");
+  signer.sign("", signature);
+  expect(signature == empty, "empty key clears previous key");
+  cout << endl;
+}
+
+string decimalText(const BfxAPI::Decimal &decimal) {
+  char text[BfxAPI::Decimal::MAX_LENGTH];
+  return string(text, decimal.write(text));
+}
+
+void testDecimal() {
+  cout << "Decimal" << endl;
+  using BfxAPI::Decimal;
+  Decimal decimal;
+  expect(Decimal::fromDouble(0.1, decimal) && decimalText(decimal) == "0.1",
+         "shortest digits");
+  expect(Decimal::fromDouble(1.005, decimal, 2) &&
+         decimalText(decimal) == "1.01", "rounds half away from zero");
+  expect(Decimal::fromSignificant(123456, 5, decimal) &&
+         decimalText(decimal) == "123460", "significant digits above units");
+  expect(Decimal::fromDouble(-123456789012345678.0, decimal) &&
+         decimal.mantissa() == -123456789012345680LL, "18 integer digits");
+  expect(Decimal::fromDouble(1e-12, decimal) && decimal.mantissa() == 0,
+         "rounds to zero");
+  expect(Decimal::fromDouble(0.4, decimal, -3) && decimal.mantissa() == 0,
+         "rounds to zero above units");
+  expect(!Decimal::fromDouble(1e18, decimal) &&
+         !Decimal::fromDouble(-1e300, decimal) &&
+         !Decimal::fromSignificant(1e25, 5, decimal),
+         "too large value fails");
+  expect(!Decimal::fromDouble(HUGE_VAL, decimal) &&
+         !Decimal::fromDouble(-HUGE_VAL, decimal) &&
+         !Decimal::fromDouble(NAN, decimal), "infinity and NaN fail");
+  expect(Decimal::fromDouble(1e300).mantissa() == 0, "zero when failed");
+
+  BfxAPI::PayloadWriter payload("/v1/test", 1);
+  payload.decimal("price", 1234.56789, 5).decimal("amount", HUGE_VAL);
+  expect(payload.str() == "{\"request\":\"/v1/test\",\"nonce\":\"1\","
+         "\"price\":\"1234.6\",\"amount\":\"\"}",
+         "payload of value out of range");
+  cout << endl;
+}
+
+void testCaptureFile() {
+  cout << "CaptureFile" << endl;
+  namespace capture = BfxAPI::capture;
+  const int64_t values[] = {0, 1, -1, 63, -64, 64, INT64_MAX, INT64_MIN};
+  string encoded;
+  for (int64_t value : values)
+    capture::putVarint(encoded, value);
+  const uint8_t *in = reinterpret_cast<const uint8_t*>(encoded.data());
+  const uint8_t *end = in + encoded.size();
+  bool decoded = encoded.size() == 1 + 1 + 1 + 1 + 1 + 2 + 10 + 10;
+  for (int64_t value : values) {
+    int64_t out = 0;
+    decoded = capture::getVarint(in, end, out) && out == value && decoded;
+  }
+  expect(decoded && in == end, "zigzag varints");
+  int64_t out = 0;
+  in = reinterpret_cast<const uint8_t*>(encoded.data()) + encoded.size() - 10;
+  expect(!capture::getVarint(in, end - 1, out), "truncated varint fails");
+
+  const string path = "test_offline.bfxcap";
+  std::remove(path.c_str());
+  std::vector<BfxAPI::Trade> trades(3);
+  for (size_t i = 0; i < trades.size(); ++i) {
+    trades[i].timestamp = 1500000000.5 - i;
+    trades[i].tid = 1000 - 7 * static_cast<long long>(i);
+    trades[i].price = 7654.3 - i * 0.1;
+    trades[i].amount = i == 1 ? -0.5 : 0.00012345;
+    trades[i].type = i == 1 ? "buy" : "sell";
+  }
+  {
+    BfxAPI::CaptureWriter writer(path);
+    writer.write("btcusd", trades);
+    writer.write("ethusd", trades);
+  }
+  // Interrupted writer left part of the second block
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  const long long length = file.tellg();
+  file.close();
+  expect(::truncate(path.c_str(), length - 3) == 0, "file truncated");
+  {
+    BfxAPI::CaptureWriter writer(path);
+    writer.write("ltcusd", trades);
+  }
+
+  BfxAPI::CaptureReader reader(path);
+  BfxAPI::TradeColumns columns;
+  expect(reader.size() == 2 && reader.block(0).symbol == "btcusd" &&
+         reader.block(1).symbol == "ltcusd",
+         "appends after last complete block");
+  bool equal = reader.size() == 2 && reader.read(1, columns) &&
+    columns.size() == trades.size();
+  for (size_t i = 0; equal && i < trades.size(); ++i) {
+    const long long millis = 1500000000500LL - 1000 * static_cast<long long>(i);
+    equal = columns.timestamp[i] == millis &&
+      columns.tid[i] == trades[i].tid &&
+      columns.price[i] == trades[i].price &&
+      columns.amount[i] == trades[i].amount &&
+      columns.buy[i] == (i == 1);
+  }
+  expect(equal, "columns of appended block");
+  std::remove(path.c_str());
+  cout << endl;
+}
+
+void testNonceGenerator() {
+  cout << "NonceGenerator" << endl;
+  auto &generator = BfxAPI::NonceGenerator::instance();
+  const size_t threads = 4, count = 10000;
+  std::vector<std::vector<unsigned long long>> nonces(threads);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&generator, &nonces, t] {
+      for (size_t i = 0; i < count; ++i)
+        nonces[t].push_back(generator.next());
+    });
+  }
+  for (auto &worker : workers)
+    worker.join();
+
+  bool increasing = true;
+  std::vector<unsigned long long> all;
+  for (const auto &issued : nonces) {
+    for (size_t i = 1; i < issued.size(); ++i)
+      increasing = increasing && issued[i] > issued[i - 1];
+    all.insert(all.end(), issued.begin(), issued.end());
+  }
+  std::sort(all.begin(), all.end());
+  expect(increasing, "increasing per thread");
+  expect(std::adjacent_find(all.begin(), all.end()) == all.end(),
+         "unique across threads");
+
+  // High-water mark of previous run ahead of clock
+  const string path = "test_offline.nonce";
+  const unsigned long long stored = generator.next() + 1000000000ULL;
+  std::ofstream(path) << stored << endl;
+  generator.setPersistencePath(path);
+  const unsigned long long nonce = generator.next();
+  unsigned long long reserved = 0;
+  std::ifstream(path) >> reserved;
+  expect(nonce > stored, "seeded by persisted nonce");
+  expect(reserved > nonce, "reserved ahead of issued nonce");
+
+  // Unwritable path is retried until the mark is stored
+  const string directory = "test_offline.noncedir";
+  const string retried = directory + "/nonce";
+  generator.setPersistencePath(retried);
+  const unsigned long long unstored = generator.next();
+  ::mkdir(directory.c_str(), 0700);
+  const unsigned long long next = generator.next();
+  reserved = 0;
+  std::ifstream(retried) >> reserved;
+  expect(next > unstored && reserved > next, "failed write retried");
+  generator.setPersistencePath("");
+  std::remove(path.c_str());
+  std::remove(retried.c_str());
+  ::rmdir(directory.c_str());
+  cout << endl;
+}
+
+void testWithdrawConfig() {
+  cout << "WithdrawConfig" << endl;
+  const string path = "test_offline.withdraw.conf";
+  const auto write = [&path](const char *amount) {
+    std::ofstream file(path, std::ofstream::trunc);
+    file << "withdraw_type = \"bitcoin\"\n"
+         << "walletselected = \"exchange\"\n"
+         << "amount = \"" << amount << "\"\n"
+         << "address = \"1PvVYHGjVJ57XXQyo7z2UBT4JF2vA5dGTN\"\n";
+  };
+  const std::unordered_set<string> cryptoMethods = {"bitcoin"};
+  BfxAPI::WithdrawConfig config(path);
+  write("0.01");
+  const bool first = config.load(cryptoMethods) == BfxClientErrors::noError &&
+                     config.request().amount.mantissa() == 1;
+  write("0.02");
+  expect(first && config.load(cryptoMethods) == BfxClientErrors::noError &&
+         config.request().amount.mantissa() == 2,
+         "same second, same size edit reloaded");
+  std::remove(path.c_str());
+  expect(config.load(cryptoMethods) == BfxClientErrors::badWDconfFilePath,
+         "missing file");
+  cout << endl;
+}
+
+// Echoes request path as response body
+class EchoTransport: public BfxAPI::Transport {
+  public:
+    void perform(const BfxAPI::TransportRequest &request,
+                 BfxAPI::HTTPResponse &response) override {
+      response.body = request.path;
+      response.curlStatusCode = CURLE_OK;
+      response.httpStatusCode = 200;
+    }
+};
+
+void testRecordReplay() {
+  cout << "RecordReplay" << endl;
+  const string path = "test_offline.rec";
+  std::remove(path.c_str());
+  const auto echo = std::make_shared<EchoTransport>();
+  BfxAPI::TransportRequest request;
+  BfxAPI::HTTPResponse response;
+  {
+    BfxAPI::RecordingTransport recorder(echo, path);
+    request.path = "/pubticker/btcusd";
+    recorder.perform(request, response);
+    request.path = "/stats/btcusd";
+    recorder.perform(request, response);
+  }
+  // Interrupted record
+  std::ofstream(path, std::ios::binary | std::ios::app) << "\x40\0\0\0\0";
+  {
+    BfxAPI::RecordingTransport recorder(echo, path);
+    request.path = "/book/btcusd";
+    recorder.perform(request, response);
+    expect(recorder.isOpen() && recorder.size() == 1, "appended to recording");
+  }
+  BfxAPI::ReplayTransport replay(path);
+  response = BfxAPI::HTTPResponse();
+  replay.perform(request, response);
+  expect(replay.size() == 3 && response.body == "/book/btcusd",
+         "partial record cut before appending");
+
+  std::ofstream(path, std::ios::trunc) << "not a recording";
+  BfxAPI::RecordingTransport refused(echo, path);
+  std::ifstream file(path);
+  const string content((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  expect(!refused.isOpen() && content == "not a recording",
+         "other files left untouched");
+  std::remove(path.c_str());
+  cout << endl;
+}
+
+void testInternTable() {
+  cout << "InternTable" << endl;
+  std::vector<string> names;
+  for (int i = 0; i < 500; ++i)
+    names.push_back("sym" + std::to_string(i * 7919));
+  names.push_back("btcusd");
+  names.push_back("btcusd");
+  const BfxAPI::SymbolTable table(names);
+  expect(table.size() == 501, "duplicates ignored");
+
+  bool found = true;
+  for (const auto &name : names) {
+    const BfxAPI::SymbolId id = table.find(name);
+    found = found && id && id.name() == name && table.at(id.index()) == id;
+  }
+  expect(found, "every name found");
+  const BfxAPI::SymbolId btcusd = table.find("btcusd");
+  expect(btcusd.path(Endpoint::book) == "/book/btcusd",
+         "endpoint path of symbol");
+  expect(!table.find("ethusd") && !table.find("") &&
+         !table.find("btcus") && !table.find("btcusd2"),
+         "unknown names not found");
+  expect(!BfxAPI::SymbolTable().find("btcusd"), "empty table");
+
+  BfxAPI::SymbolTable source(names);
+  const BfxAPI::SymbolId id = source.find("btcusd");
+  BfxAPI::SymbolTable moved(std::move(source));
+  expect(moved.find("btcusd") == id && id.name() == "btcusd",
+         "ids stay valid after move");
+  cout << endl;
+}
+
+void testSymbolMetadata() {
+  cout << "SymbolMetadata" << endl;
+  BfxAPI::SymbolMetadata symbols;
+  symbols.setSymbols(std::vector<string>{"btcusd", "ethusd"});
+  std::vector<BfxAPI::SymbolDetails> details(2);
+  details[0].pair = "btcusd";
+  details[0].pricePrecision = 5;
+  details[1].pair = "ethusd";
+  symbols.setPricePrecisions(details);
+  const BfxAPI::SymbolId btcusd = symbols.table().find("btcusd");
+  expect(symbols.pricePrecision(btcusd) == 5 &&
+         symbols.pricePrecision("btcusd") == 5, "precision by id and name");
+  expect(symbols.pricePrecision(symbols.table().find("ethusd")) == 0,
+         "unknown precision");
+
+  symbols.setSymbols(std::vector<string>{"aaausd", "btcusd", "ethusd"});
+  const BfxAPI::SymbolId current = symbols.table().find("btcusd");
+  expect(current != btcusd && current.index() != btcusd.index() &&
+         symbols.pricePrecision(current) == 5 &&
+         symbols.pricePrecision(btcusd) == 5,
+         "precisions kept for ids of both tables");
+
+  const BfxAPI::SymbolTable *table = &symbols.table();
+  symbols.setSymbols(std::vector<string>{"ethusd", "btcusd", "aaausd",
+                                         "btcusd"});
+  symbols.setPricePrecisions(details);
+  expect(&symbols.table() == table &&
+         symbols.table().find("btcusd") == current &&
+         symbols.pricePrecision(current) == 5,
+         "unchanged symbols not published again");
+  details[1].pricePrecision = 4;
+  symbols.setPricePrecisions(details);
+  expect(symbols.pricePrecision(symbols.table().find("ethusd")) == 4,
+         "changed precision published");
+  cout << endl;
+}
+
+void testSpscQueue() {
+  cout << "SpscQueue" << endl;
+  BfxAPI::SpscQueue<uint64_t, 8> queue;
+  uint64_t value = 0;
+  bool wrapped = !queue.pop(value);
+  for (uint64_t round = 0; round < 3; ++round) {
+    for (uint64_t i = 0; i < queue.capacity(); ++i)
+      wrapped = queue.push(round * 100 + i) && wrapped;
+    wrapped = queue.full() && !queue.push(0) && wrapped;
+    for (uint64_t i = 0; i < queue.capacity(); ++i)
+      wrapped = queue.pop(value) && value == round * 100 + i && wrapped;
+    wrapped = !queue.pop(value) && !queue.full() && wrapped;
+  }
+  expect(wrapped, "full, empty and wraparound");
+
+  // Producer and consumer threads, values arrive in order
+  static BfxAPI::SpscQueue<uint64_t, 64> shared;
+  const uint64_t count = 200000;
+  std::thread producer([count] {
+    for (uint64_t i = 1; i <= count; ++i) {
+      while (!shared.push(i))
+        std::this_thread::yield();
+    }
+  });
+  bool ordered = true;
+  for (uint64_t expected = 1; expected <= count;) {
+    if (shared.pop(value)) {
+      ordered = ordered && value == expected;
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  expect(ordered && !shared.pop(value), "transfer between threads");
+  cout << endl;
+}
+
+int main() {
+  cout << "Starting offline tests" << endl << endl;
+
+  testSchemaValidatorMove();
+  testLatencyHistogram();
+  testOrderCache();
+  testRateLimiter();
+  testParseInteger();
+  testParseDouble();
+  testHmacSigner();
+  testDecimal();
+  testCaptureFile();
+  testNonceGenerator();
+  testWithdrawConfig();
+  testRecordReplay();
+  testInternTable();
+  testSymbolMetadata();
+  testSpscQueue();
+
+  cout << (failures ? "FAILED: " : "PASSED: ") << failures << " failures"
+       << endl;
+  return failures ? 1 : 0;
+}